@@ -14,7 +14,6 @@ layout(location = 0) out vec4 frag_color;
 // Unity
 struct Material {
 	sampler2D Diffuse;
-	float     Shininess;
 };
 // Create a uniform for the material
 uniform Material u_Material;
@@ -31,15 +30,23 @@ uniform Material u_Material;
 /////////////// Frame Level Uniforms ///////////////////////////
 ////////////////////////////////////////////////////////////////
 
-uniform float     iTime;
-
-uniform bool toggle_diffuse = true;
-uniform bool toggle_ambient = true;
-uniform bool toggle_specular = true;
-uniform bool spec_ramp = false;
-uniform bool diff_ramp = false;
+// The material's parameters, packed into a slot of the shared material buffer (see MaterialBuffer)
+layout (std140, binding = 3) uniform b_Material {
+    float u_Shininess;
+    float iTime;
+    bool  toggle_diffuse;
+    bool  toggle_ambient;
+    bool  toggle_specular;
+    bool  spec_ramp;
+    bool  diff_ramp;
+    bool  activated;
+};
 
-uniform bool activated = true;
+// Block members can't have initializers, so we declare the values materials start with here
+#pragma default toggle_diffuse  true
+#pragma default toggle_ambient  true
+#pragma default toggle_specular true
+#pragma default activated       true
 
 //https://www.shadertoy.com/view/MtXfDj
 // GooFunc - now with technical parameters for you to play with :)
@@ -64,7 +71,7 @@ void main() {
 	vec3 normal = normalize(inNormal);
 
 	// Use the lighting calculation that we included from our partial file
-	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Material.Shininess,toggle_diffuse, toggle_specular, toggle_ambient, spec_ramp, diff_ramp);
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Shininess,toggle_diffuse, toggle_specular, toggle_ambient, spec_ramp, diff_ramp);
     lightAccumulation = LightCorrect(lightAccumulation);
 
     if (activated)
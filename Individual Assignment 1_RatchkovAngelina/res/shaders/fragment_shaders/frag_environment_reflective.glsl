@@ -20,7 +20,6 @@ layout(location = 0) out vec4 frag_color;
 // Unity
 struct Material {
 	sampler2D Diffuse;
-	float     Shininess;
 };
 // Create a uniform for the material
 uniform Material u_Material;
@@ -33,11 +32,20 @@ uniform Material u_Material;
 #include "../fragments/color_correction.glsl"
 #include "../fragments/light_correction.glsl"
 
-uniform bool toggle_diffuse = true;
-uniform bool toggle_ambient = true;
-uniform bool toggle_specular = true;
-uniform bool spec_ramp = false;
-uniform bool diff_ramp = false;
+// The material's parameters, packed into a slot of the shared material buffer (see MaterialBuffer)
+layout (std140, binding = 3) uniform b_Material {
+    float u_Shininess;
+    bool  toggle_diffuse;
+    bool  toggle_ambient;
+    bool  toggle_specular;
+    bool  spec_ramp;
+    bool  diff_ramp;
+};
+
+// Block members can't have initializers, so we declare the values materials start with here
+#pragma default toggle_diffuse  true
+#pragma default toggle_ambient  true
+#pragma default toggle_specular true
 
 const float LOG_MAX = 2.40823996531;
 
@@ -52,7 +60,7 @@ void main() {
 
 	// Will accumulate the contributions of all lights on this fragment
 	// This is defined in the fragment file "multiple_point_lights.glsl"
-	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Material.Shininess,toggle_diffuse, toggle_specular, toggle_ambient, spec_ramp, diff_ramp);
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Shininess,toggle_diffuse, toggle_specular, toggle_ambient, spec_ramp, diff_ramp);
 	lightAccumulation = LightCorrect(lightAccumulation);
 
 
@@ -62,5 +70,5 @@ void main() {
 	// combine for the final result
 	vec3 result = lightAccumulation  * inColor * textureColor.rgb;
 
-	frag_color = vec4(ColorCorrect(mix(result, reflected, u_Material.Shininess)), textureColor.a);
+	frag_color = vec4(ColorCorrect(mix(result, reflected, u_Shininess)), textureColor.a);
 }
\ No newline at end of file
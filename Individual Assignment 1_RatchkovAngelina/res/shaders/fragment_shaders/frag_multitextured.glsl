@@ -23,11 +23,15 @@ layout(location = 0) out vec4 frag_color;
 struct Material {
 	sampler2D DiffuseA;
 	sampler2D DiffuseB;
-	float     Shininess;
 };
 // Create a uniform for the material
 uniform Material u_Material;
 
+// The material's parameters, packed into a slot of the shared material buffer (see MaterialBuffer)
+layout (std140, binding = 3) uniform b_Material {
+    float u_Shininess;
+};
+
 ////////////////////////////////////////////////////////////////
 ///////////// Application Level Uniforms ///////////////////////
 ////////////////////////////////////////////////////////////////
@@ -44,7 +48,7 @@ void main() {
 
 	// Will accumulate the contributions of all lights on this fragment
 	// This is defined in the fragment file "multiple_point_lights.glsl"
-	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Material.Shininess);
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Shininess);
 
     // By we can use this lil trick to divide our weight by the sum of all components
     // This will make all of our texture weights add up to one! 
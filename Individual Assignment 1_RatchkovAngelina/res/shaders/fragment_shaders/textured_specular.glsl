@@ -15,7 +15,6 @@ layout(location = 0) out vec4 frag_color;
 struct Material {
 	sampler2D Diffuse;
 	sampler2D Specular;
-	float Shininess;
 };
 // Create a uniform for the material
 uniform Material u_Material;
@@ -34,14 +33,21 @@ uniform Material u_Material;
 #include "../fragments/color_correction.glsl"
 #include "../fragments/light_correction.glsl"
 
-uniform bool toggle_diffuse = true;
-uniform bool toggle_ambient = true;
-uniform bool toggle_specular = true;
-uniform bool spec_ramp = false;
-uniform bool diff_ramp = false;
-
+// The material's parameters, packed into a slot of the shared material buffer (see MaterialBuffer)
+layout (std140, binding = 3) uniform b_Material {
+    float u_Shininess;
+    bool  toggle_diffuse;
+    bool  toggle_ambient;
+    bool  toggle_specular;
+    bool  spec_ramp;
+    bool  diff_ramp;
+    float spec_increase;
+};
 
-uniform float spec_increase = 0;
+// Block members can't have initializers, so we declare the values materials start with here
+#pragma default toggle_diffuse  true
+#pragma default toggle_ambient  true
+#pragma default toggle_specular true
 
 // https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
 void main() {
@@ -2,18 +2,20 @@
 #pragma once
 #include "frame_uniforms.glsl"
 
+// Compiled in or out by the renderer, see ShaderProgram::GetVariant
+#pragma keyword ENABLE_COLOR_CORRECTION
+
 // Our color correction 3d texture
 uniform layout (binding=14) sampler3D s_ColorCorrection;
 
 // Function for applying color correction
 vec3 ColorCorrect(vec3 inputColor) {
-    // If our color correction flag is set, we perform the color lookup
-    if (IsFlagSet(FLAG_ENABLE_COLOR_CORRECTION)) {
-        return texture(s_ColorCorrection, inputColor).rgb;
-    }
+    // If our color correction keyword is set, we perform the color lookup
+#ifdef ENABLE_COLOR_CORRECTION
+    return texture(s_ColorCorrection, inputColor).rgb;
     // Otherwise just return the input
-    else {
-        return inputColor;
-    }
+#else
+    return inputColor;
+#endif
 }
 
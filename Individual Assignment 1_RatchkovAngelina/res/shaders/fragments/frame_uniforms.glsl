@@ -17,15 +17,34 @@ layout (std140, binding = 0) uniform b_FrameLevelUniforms {
 };
 
 // Stores uniforms that change every object/instance
-layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
+struct InstanceLevelUniforms {
     // Complete MVP
-    uniform mat4 u_ModelViewProjection;
+    mat4 ModelViewProjection;
     // Just the model transform, we'll do worldspace lighting
-    uniform mat4 u_Model;
+    mat4 Model;
     // Normal Matrix for transforming normals
-    uniform mat4 u_NormalMatrix;
+    mat4 NormalMatrix;
+    // The slot of the object's material in the material parameter buffer (see MaterialBuffer), or ~0 if it has none
+    uint MaterialIndex;
 };
 
+// The render layer writes every object drawn this frame into this buffer, in draw order
+layout (std430, binding = 1) readonly buffer b_InstanceLevelUniforms {
+    InstanceLevelUniforms u_Instances[];
+};
+
+// Shaders that get their draw's base instance as an input (see vs_common.glsl) define this before including us
+#ifndef INSTANCE_INDEX
+#define INSTANCE_INDEX gl_InstanceID
+#endif
+
+// Lets our vertex shaders keep using the per-object names, these should only be used
+// in vertex shaders since gl_InstanceID does not exist in the other stages
+#define u_ModelViewProjection u_Instances[INSTANCE_INDEX].ModelViewProjection
+#define u_Model               u_Instances[INSTANCE_INDEX].Model
+#define u_NormalMatrix        u_Instances[INSTANCE_INDEX].NormalMatrix
+#define u_MaterialIndex       u_Instances[INSTANCE_INDEX].MaterialIndex
+
 #define FLAG_ENABLE_COLOR_CORRECTION (1 << 0)
 #define FLAG_ENABLE_LIGHTS (1 << 1)
 
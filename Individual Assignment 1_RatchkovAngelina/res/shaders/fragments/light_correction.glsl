@@ -2,15 +2,17 @@
 #pragma once
 #include "frame_uniforms.glsl"
 
+// Compiled in or out by the renderer, see ShaderProgram::GetVariant
+#pragma keyword ENABLE_LIGHTS
+
 // Function for applying color correction
 vec3 LightCorrect(vec3 lightAccumulation) {
-    // If our color correction flag is set, we perform the color lookup
-    if (IsFlagSet(FLAG_ENABLE_LIGHTS)) {
-        return lightAccumulation;
-    }
+    // If our lighting keyword is set, we keep the light we've accumulated
+#ifdef ENABLE_LIGHTS
+    return lightAccumulation;
     // Otherwise just return the input
-    else {
-        return vec3(0.0);
-    }
+#else
+    return vec3(0.0);
+#endif
 }
 
@@ -8,6 +8,11 @@ layout(location = 3) in vec2 inUV;
 layout(location = 4) in vec3 inTangent;
 layout(location = 5) in vec3 inBiTangent;
 
+// Many objects are drawn by a single multi-draw, each draw's base instance comes in here so we
+// can find it's instance data. Matches MeshPool::INSTANCE_ID_SLOT
+layout(location = 15) in uint inBaseInstance;
+#define INSTANCE_INDEX (inBaseInstance + uint(gl_InstanceID))
+
 // Standard vertex shader outputs
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outColor;
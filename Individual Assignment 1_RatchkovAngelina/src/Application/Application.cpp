@@ -12,6 +12,7 @@
 #include "Utils/FileHelpers.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/ObjParser.h"
 
 // Graphics
 #include "Graphics/Buffers/IndexBuffer.h"
@@ -26,6 +27,7 @@
 #include "Graphics/Font.h"
 #include "Graphics/GuiBatcher.h"
 #include "Graphics/Framebuffer.h"
+#include "Graphics/GlState.h"
 
 // Gameplay
 #include "Gameplay/Material.h"
@@ -67,6 +69,8 @@ std::string Application::_applicationName = "INFR-2350U - DEMO";
 
 #define DEFAULT_WINDOW_WIDTH 1280
 #define DEFAULT_WINDOW_HEIGHT 720
+// The time to spend uploading asynchronously loaded resources each frame, in seconds
+#define RESOURCE_UPLOAD_BUDGET 0.002f
 
 Application::Application() :
 	_window(nullptr),
@@ -76,7 +80,8 @@ Application::Application() :
 	_windowTitle("INFR - 2350U"),
 	_currentScene(nullptr),
 	_targetScene(nullptr),
-	_renderOutput(nullptr)
+	_renderOutput(nullptr),
+	_jobSystem(std::make_shared<JobSystem>())
 { }
 
 Application::~Application() = default; 
@@ -94,6 +99,8 @@ void Application::Start(int argCount, char** arguments) {
 
 GLFWwindow* Application::GetWindow() { return _window; }
 
+JobSystem& Application::GetJobSystem() { return *_jobSystem; }
+
 const glm::ivec2& Application::GetWindowSize() const { return _windowSize; }
 
 
@@ -195,6 +202,10 @@ void Application::_Run()
 		// Receive events like input and window position/size changes from GLFW
 		glfwPollEvents();
 
+		// Handle any work that other threads have handed back to us, like uploading to the GPU
+		_jobSystem->RunMainThreadJobs();
+		ResourceManager::ProcessUploads(RESOURCE_UPLOAD_BUDGET);
+
 		// Handle closing the app via the close button
 		if (glfwWindowShouldClose(_window)) {
 			_isRunning = false;
@@ -216,6 +227,9 @@ void Application::_Run()
 		timing._timeSinceSceneLoad += scaledDt;
 		timing._unscaledTimeSinceSceneLoad += dt;
 
+		// Start counting the GL calls that we make this frame
+		GlState::BeginFrame();
+
 		ImGuiHelper::StartFrame();
 
 		// Core update loop
@@ -232,6 +246,8 @@ void Application::_Run()
 
 		InputEngine::EndFrame();
 		ImGuiHelper::EndFrame();
+		// ImGui's renderer (and any extra viewport windows) change GL state without going through GlState
+		GlState::Reset();
 
 		glfwSwapBuffers(_window);
 
@@ -247,7 +263,9 @@ void Application::_RegisterClasses()
 	using namespace Gameplay::Physics;
 
 	// Initialize our resource manager
-	ResourceManager::Init();
+	ResourceManager::Init(*_jobSystem);
+	// Large OBJ files get split across the job system
+	ObjParser::Init(*_jobSystem);
 
 	// Register all our resource types so we can load them from manifest files
 	ResourceManager::RegisterType<Texture1D>();
@@ -5,6 +5,7 @@
 #include "Utils/Macros.h"
 #include "Application/ApplicationLayer.h"
 #include "Gameplay/Scene.h"
+#include "Utils/JobSystem.h"
 
 struct GLFWwindow;
 
@@ -39,6 +40,11 @@ public:
 	 */
 	GLFWwindow* GetWindow();
 
+	/**
+	 * Gets the job system that layers can use to spread work across threads
+	 */
+	JobSystem& GetJobSystem();
+
 	/**
 	 * Gets the width and height of the application window, in pixels
 	 */
@@ -140,6 +146,9 @@ protected:
 	// Stores all the layers of the application, in the order they should be invoked
 	std::vector<ApplicationLayer::Sptr> _layers;
 
+	// Worker threads shared by the whole engine
+	JobSystem::Sptr _jobSystem;
+
 	Framebuffer::Sptr _renderOutput;
 
 	void _Run();
@@ -441,7 +441,7 @@ void DefaultSceneLayer::_CreateScene()
 			boxMaterial->Name = "Box";
 			boxMaterial->Set("u_Material.Diffuse", boxTexture);
 			boxMaterial->Set("u_Material.Specular", boxSpec);
-			boxMaterial->Set("u_Material.Shininess", 10.1f);
+			boxMaterial->Set("u_Shininess", 10.1f);
 			
 		}
 		//brick material
@@ -449,7 +449,7 @@ void DefaultSceneLayer::_CreateScene()
 		{
 			brickMaterial->Name = "Brick";
 			brickMaterial->Set("u_Material.Diffuse", brickTexture);
-			brickMaterial->Set("u_Material.Shininess", 10.1f);
+			brickMaterial->Set("u_Shininess", 10.1f);
 		}
 
 		// This will be the reflective material, we'll make the whole thing 90% reflective
@@ -457,14 +457,14 @@ void DefaultSceneLayer::_CreateScene()
 		{
 			monkeyMaterial->Name = "Monkey";
 			monkeyMaterial->Set("u_Material.Diffuse", monkeyTex);
-			monkeyMaterial->Set("u_Material.Shininess", 10.5f);
+			monkeyMaterial->Set("u_Shininess", 10.5f);
 		}
 		// This will be the reflective material, we'll make the whole thing 90% reflective
 		Material::Sptr monkeyMaterial2 = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			monkeyMaterial2->Name = "Monkey";
 			monkeyMaterial2->Set("u_Material.Diffuse", monkeyTex);
-			monkeyMaterial2->Set("u_Material.Shininess", 10.5f);
+			monkeyMaterial2->Set("u_Shininess", 10.5f);
 		}
 		Texture2D::Sptr    slimeTexture = ResourceManager::CreateAsset<Texture2D>("textures/goo.png");
 
@@ -482,8 +482,8 @@ void DefaultSceneLayer::_CreateScene()
 		{
 			foliageMaterial->Name = "Foliage Shader";
 			foliageMaterial->Set("u_Material.Diffuse", leafTex);
-			foliageMaterial->Set("u_Material.Shininess", 10.1f);
-			foliageMaterial->Set("u_Material.Threshold", 0.1f);
+			foliageMaterial->Set("u_Shininess", 10.1f);
+			foliageMaterial->Set("u_Threshold", 0.1f);
 
 			foliageMaterial->Set("u_WindDirection", glm::vec3(1.0f, 1.0f, 0.0f));
 			foliageMaterial->Set("u_WindStrength", 0.5f);
@@ -502,7 +502,7 @@ void DefaultSceneLayer::_CreateScene()
 			displacementTest->Set("u_Material.Diffuse", diffuseMap);
 			displacementTest->Set("s_Heightmap", displacementMap);
 			displacementTest->Set("s_NormalMap", normalMap);
-			displacementTest->Set("u_Material.Shininess", 10.5f);
+			displacementTest->Set("u_Shininess", 10.5f);
 			displacementTest->Set("u_Scale", 0.1f);
 		}
 
@@ -514,7 +514,7 @@ void DefaultSceneLayer::_CreateScene()
 			normalmapMat->Name = "Tangent Space Normal Map";
 			normalmapMat->Set("u_Material.Diffuse", diffuseMap);
 			normalmapMat->Set("s_NormalMap", normalMap);
-			normalmapMat->Set("u_Material.Shininess", 10.5f);
+			normalmapMat->Set("u_Shininess", 10.5f);
 			normalmapMat->Set("u_Scale", 0.1f);
 		}
 		
@@ -692,7 +692,7 @@ void DefaultSceneLayer::_CreateScene()
 		{
 			toyMaterial->Name = "Toy";
 			toyMaterial->Set("u_Material.Diffuse", toyTex);
-			toyMaterial->Set("u_Material.Shininess", 10.0f);
+			toyMaterial->Set("u_Shininess", 10.0f);
 
 		}
 		Gameplay::GameObject::Sptr toyM = scene->CreateGameObject("Toy");
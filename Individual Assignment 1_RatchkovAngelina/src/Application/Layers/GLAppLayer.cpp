@@ -1,6 +1,7 @@
 #include "Application/Layers/GLAppLayer.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
+#include "Graphics/GlState.h"
 #include "Application/Application.h"
 
 GLAppLayer::GLAppLayer() :
@@ -26,7 +27,7 @@ void GLAppLayer::OnAppLoad(const nlohmann::json& config) {
 
 	LOG_ASSERT(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0, "Failed to initialize glad");
 
-	glEnable(GL_PROGRAM_POINT_SIZE);
+	GlState::Enable(GL_PROGRAM_POINT_SIZE);
 }
 
 void GLAppLayer::OnAppUnload()
@@ -1,6 +1,7 @@
 #include "ParticleLayer.h"
 #include "Gameplay/Components/ParticleSystem.h"
 #include "Application/Application.h"
+#include "Application/Layers/RenderLayer.h"
 
 ParticleLayer::ParticleLayer() :
 	ApplicationLayer()
@@ -19,7 +20,7 @@ void ParticleLayer::OnUpdate()
 	// Only update the particle systems when the game is playing, so we can edit them in
 	// the inspector
 	if (app.CurrentScene()->IsPlaying) {
-		app.CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+		app.CurrentScene()->Components().Each<ParticleSystem>([](ParticleSystem* system) {
 			if (system->IsEnabled) {
 				system->Update();
 			}
@@ -29,7 +30,10 @@ void ParticleLayer::OnUpdate()
 
 void ParticleLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 {
-	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+	// Our shaders read the camera from the frame uniforms, which the render layer owns
+	Application::Get().GetLayer<RenderLayer>()->BindFrameUniforms();
+
+	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](ParticleSystem* system) {
 		if (system->IsEnabled) {
 			system->Render();
 		}
@@ -3,10 +3,12 @@
 #include "Graphics/GuiBatcher.h"
 #include "Gameplay/Components/Camera.h"
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlState.h"
 #include "Graphics/Textures/TextureCube.h"
 #include "../Timing.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Gameplay/Components/RenderComponent.h"
+#include "Utils/GlmDefines.h"
 
 // GLM math library
 #include <GLM/glm.hpp>
@@ -20,10 +22,23 @@ RenderLayer::RenderLayer() :
 	ApplicationLayer(),
 	_primaryFBO(nullptr),
 	_blitFbo(true),
-	_frameUniforms(nullptr),
-	_instanceUniforms(nullptr),
+	_uniformRing(nullptr),
+	_frameUniforms(),
+	_meshPool(nullptr),
+	_batches(),
+	_clusterCuller(std::make_shared<ClusterCuller>()),
+	_clusterCulling(true),
+	_modelMatrices(),
+	_mvpMatrices(),
 	_renderFlags(RenderFlags::EnableLights),
-	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f })
+	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f }),
+	_cullList(),
+	_cullBounds(),
+	_cullResults(),
+	_renderQueue(std::make_shared<RenderQueue>()),
+	_drawList(),
+	_materialIds(),
+	_stats()
 {
 	Name = "Rendering";
 	Overrides = AppLayerFunctions::OnAppLoad | AppLayerFunctions::OnRender | AppLayerFunctions::OnWindowResize;
@@ -54,12 +69,8 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	DebugDrawer::Get().SetViewProjection(viewProj);
 
 	// Make sure depth testing and culling are re-enabled
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-
-	// The current material that is bound for rendering
-	Material::Sptr currentMat = nullptr;
-	ShaderProgram::Sptr shader = nullptr;
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::Enable(GL_CULL_FACE);
 
 	// Bind the skybox texture to a reserved texture slot
 	// See Material.h and Material.cpp for how we're reserving texture slots
@@ -76,27 +87,17 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 	// Here we'll bind all the UBOs to their corresponding slots
 	app.CurrentScene()->PreRender();
-	_frameUniforms->Bind(FRAME_UBO_BINDING);
-	_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
 
 	// Draw physics debug
 	app.CurrentScene()->DrawPhysicsDebug();
 
-	// Upload frame level uniforms
-	auto& frameData = _frameUniforms->GetData();
-	frameData.u_Projection = camera->GetProjection();
-	frameData.u_View = camera->GetView();
-	frameData.u_ViewProjection = camera->GetViewProjection();
-	frameData.u_CameraPos = glm::vec4(camera->GetGameObject()->GetPosition(), 1.0f);
-	frameData.u_Time = static_cast<float>(Timing::Current().TimeSinceSceneLoad());
-	frameData.u_DeltaTime = Timing::Current().DeltaTime();
-	frameData.u_RenderFlags = _renderFlags;
-	_frameUniforms->Update();
-
 	Material::Sptr defaultMat = app.CurrentScene()->DefaultMaterial;
 
-	// Render all our objects
-	app.CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
+	// Gather everything we might want to draw, along with their world space bounds
+	_cullList.clear();
+	_cullBounds.clear();
+
+	app.CurrentScene()->Components().Each<RenderComponent>([&](RenderComponent* renderable) {
 		// Early bail if mesh not set
 		if (renderable->GetMesh() == nullptr) {
 			return;
@@ -112,29 +113,261 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 			}
 		}
 
-		// If the material has changed, we need to bind the new shader and set up our material and frame data
-		// Note: This is a good reason why we should be sorting the render components in ComponentManager
-		if (renderable->GetMaterial() != currentMat) {
-			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
+		_cullList.push_back(renderable);
+		_cullBounds.push_back(renderable->GetGameObject()->GetWorldBounds());
+	});
 
-			shader->Bind();
-			currentMat->Apply();
+	// Test all the bounds against the camera in one batch, so we can do 4 objects at a time
+	_cullResults.resize(_cullList.size());
+	camera->GetFrustum().IntersectsBatch(_cullBounds.data(), _cullBounds.size(), _cullResults.data());
+
+	// The render flags pick which variant of each shader we draw with, rather than being branched on per pixel
+	static const uint32_t lightsKeyword = ShaderProgram::GetKeywordMask("ENABLE_LIGHTS");
+	static const uint32_t colorCorrectionKeyword = ShaderProgram::GetKeywordMask("ENABLE_COLOR_CORRECTION");
+	uint32_t globalKeywords = 0;
+	globalKeywords |= *(_renderFlags & RenderFlags::EnableLights) ? lightsKeyword : 0;
+	globalKeywords |= *(_renderFlags & RenderFlags::EnableColorCorrection) ? colorCorrectionKeyword : 0;
+	ShaderProgram::SetGlobalKeywords(globalKeywords);
+
+	// Build a sort key for each visible object
+	_renderQueue->Clear();
+	_drawList.clear();
+	_materialIds.clear();
+	_stats = RenderStats();
+
+	const glm::mat4& view = camera->GetView();
+	float farPlane = camera->GetFarPlane();
+
+	for (size_t ix = 0; ix < _cullList.size(); ix++) {
+		// Objects without bounds can't be culled, so we always draw them
+		if (!_cullResults[ix] && _cullBounds[ix].IsValid()) {
+			_stats.ObjectsCulled++;
+			continue;
+		}
+
+		RenderComponent* renderable = _cullList[ix];
+		const Material::Sptr& material = renderable->GetMaterial();
+		auto it = _materialIds.find(material.get());
+		if (it == _materialIds.end()) {
+			it = _materialIds.emplace(material.get(), static_cast<uint32_t>(_materialIds.size())).first;
 		}
 
-		// Grab the game object so we can do some stuff with it
-		GameObject* object = renderable->GetGameObject();
+		// Camera looks down -Z, so we flip the view space Z to get the distance in front of it
+		float depth = -(view * renderable->GetGameObject()->GetTransform()[3]).z / farPlane;
 
-		// Use our uniform buffer for our instance level uniforms
-		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-		_instanceUniforms->Update();
+		const uint32_t lod = _SelectLod(renderable, _cullBounds[ix], *camera);
+		renderable->SetLodLevel(lod);
+		if (lod > 0) {
+			_stats.ReducedLodObjects++;
+		}
 
-		// Draw the object
-		renderable->GetMesh()->Draw();
-	});
+		// Each variant is it's own program, so sorting by it's handle keeps variants of the same shader apart
+		ShaderProgram* shader = material->GetShader()->GetVariant(globalKeywords | material->GetKeywords());
+
+		uint64_t key = RenderQueue::MakeSortKey(
+			RenderPass::Opaque,
+			shader->GetHandle(),
+			it->second,
+			renderable->GetMesh()->GetHandle(),
+			lod,
+			depth
+		);
+		_renderQueue->Push(key, static_cast<uint32_t>(_drawList.size()));
+		_drawList.push_back(renderable);
+	}
+
+	// Sorting groups our draws by shader, then material, then mesh and LOD, then front to back
+	_renderQueue->Sort();
+
+	// Walk the sorted queue, and collapse runs of objects with the same mesh, LOD and material into batches.
+	// Since those share the upper bits of the key, they will already be next to each other
+	_batches.clear();
+	_meshPool->CollectGarbage();
+	for (uint32_t ix = 0; ix < _renderQueue->Size(); ix++) {
+		RenderComponent* renderable = _drawList[(*_renderQueue)[ix].Index];
+
+		bool newBatch = _batches.empty() ||
+			_batches.back().Renderable->GetMaterial() != renderable->GetMaterial() ||
+			_batches.back().Renderable->GetMeshResource() != renderable->GetMeshResource() ||
+			_batches.back().Renderable->GetLodLevel() != renderable->GetLodLevel() ||
+			_UsesClusterCulling(renderable);
+		if (newBatch) {
+			_batches.push_back({ renderable, ix, 0, _meshPool->Get(renderable->GetMesh()), 0, 0 });
+		}
+		_batches.back().InstanceCount++;
+	}
+
+	// Compute all the MVPs in one go, rather than one at a time as we write instances
+	_modelMatrices.resize(_renderQueue->Size());
+	_mvpMatrices.resize(_renderQueue->Size());
+	for (uint32_t ix = 0; ix < _renderQueue->Size(); ix++) {
+		RenderComponent* renderable = _drawList[(*_renderQueue)[ix].Index];
+		_modelMatrices[ix] = renderable->GetGameObject()->GetTransform();
+
+		// Meshes with quantized positions need to be mapped back to model space first, the normal matrix stays as is
+		const VertexArrayObject* mesh = renderable->GetMeshResource()->Mesh.get();
+		if (mesh->HasPositionTransform()) {
+			_modelMatrices[ix] = _modelMatrices[ix] * mesh->GetPositionTransform();
+		}
+	}
+	MultiplyMat4Batch(viewProj, _modelMatrices.data(), _mvpMatrices.data(), _modelMatrices.size());
+
+	// Pooled batches need one command, or one per meshlet if they are culled cluster by cluster
+	uint32_t maxCommands = 0;
+	for (const DrawBatch& batch : _batches) {
+		if (batch.Pooled != nullptr) {
+			maxCommands += _UsesClusterCulling(batch.Renderable) ? static_cast<uint32_t>(batch.Renderable->GetMeshResource()->Mesh->GetMeshlets().size()) : 1;
+		}
+	}
+
+	// Work out how much of the ring buffer we need this frame, each allocation gets padded out to the alignment
+	const uint32_t instanceCount = _renderQueue->Size();
+	uint32_t requiredBytes = _uniformRing->AlignSize(sizeof(FrameLevelUniforms));
+	requiredBytes += _uniformRing->AlignSize(instanceCount * sizeof(InstanceLevelUniforms));
+	requiredBytes += _uniformRing->AlignSize(maxCommands * sizeof(DrawElementsIndirectCommand));
+	_uniformRing->BeginFrame(requiredBytes);
+	_meshPool->ReserveInstances(instanceCount);
+
+	// Upload frame level uniforms
+	FrameLevelUniforms frameData;
+	frameData.u_Projection = camera->GetProjection();
+	frameData.u_View = camera->GetView();
+	frameData.u_ViewProjection = camera->GetViewProjection();
+	frameData.u_CameraPos = glm::vec4(camera->GetGameObject()->GetPosition(), 1.0f);
+	frameData.u_Time = static_cast<float>(Timing::Current().TimeSinceSceneLoad());
+	frameData.u_DeltaTime = Timing::Current().DeltaTime();
+	frameData.u_RenderFlags = _renderFlags;
+	_frameUniforms = _uniformRing->Allocate(frameData);
+	BindFrameUniforms();
+
+	// Every object drawn this frame gets it's instance data written in queue order, so each batch's
+	// instances start at it's first item. This lets us bind the whole thing once for every draw
+	UniformRingBuffer::Allocation instanceAlloc = _uniformRing->Allocate(instanceCount * sizeof(InstanceLevelUniforms));
+	InstanceLevelUniforms* instances = reinterpret_cast<InstanceLevelUniforms*>(instanceAlloc.Data);
+	if (instances == nullptr) {
+		_batches.clear();
+	}
+	for (uint32_t ix = 0; instances != nullptr && ix < instanceCount; ix++) {
+		RenderComponent* renderable = _drawList[(*_renderQueue)[ix].Index];
+
+		InstanceLevelUniforms& instance = instances[ix];
+		instance.u_Model = _modelMatrices[ix];
+		instance.u_ModelViewProjection = _mvpMatrices[ix];
+		instance.u_NormalMatrix = glm::mat4(renderable->GetGameObject()->GetNormalMatrix());
+		instance.u_MaterialIndex = renderable->GetMaterial()->GetParameterSlot();
+	}
+
+	// The view matrix's third row is the camera's backwards axis in world space
+	_clusterCuller->BeginFrame(camera->GetFrustum(), camera->GetGameObject()->GetPosition(), camera->GetOrthoEnabled(), -glm::vec3(view[0][2], view[1][2], view[2][2]));
+
+	// Write the indirect commands for every pooled batch, in batch order so that neighbouring batches can be drawn together
+	UniformRingBuffer::Allocation commandAlloc = _uniformRing->Allocate(maxCommands * sizeof(DrawElementsIndirectCommand));
+	DrawElementsIndirectCommand* commands = reinterpret_cast<DrawElementsIndirectCommand*>(commandAlloc.Data);
+	uint32_t commandCount = 0;
+	for (DrawBatch& batch : _batches) {
+		if (batch.Pooled == nullptr) {
+			continue;
+		}
+		if (commands == nullptr) {
+			batch.InstanceCount = 0;
+			continue;
+		}
+
+		const VertexArrayObject::Sptr& mesh = batch.Renderable->GetMeshResource()->Mesh;
+		batch.FirstCommand = commandCount;
+
+		// Cull the clusters of large meshes, and only draw the ones that are left. The meshlet bounds are
+		// in model space, so this uses the object's transform rather than the position transformed one
+		if (_UsesClusterCulling(batch.Renderable)) {
+			batch.CommandCount = _clusterCuller->Cull(mesh->GetMeshlets(), batch.Renderable->GetGameObject()->GetTransform(), commands + commandCount,
+				batch.Pooled->FirstIndex, batch.Pooled->BaseVertex, batch.FirstItem);
+		} else {
+			const std::vector<MeshLod>& lods = mesh->GetLods();
+			const uint32_t lod = batch.Renderable->GetLodLevel();
+			const MeshLod level = lod < lods.size() ? lods[lod] : MeshLod{ 0, mesh->GetElementCount(), 0.0f };
+
+			DrawElementsIndirectCommand& command = commands[commandCount];
+			command.Count         = level.IndexCount;
+			command.InstanceCount = batch.InstanceCount;
+			command.FirstIndex    = batch.Pooled->FirstIndex + level.FirstIndex;
+			command.BaseVertex    = batch.Pooled->BaseVertex;
+			command.BaseInstance  = batch.FirstItem;
+			batch.CommandCount = 1;
+		}
+		commandCount += batch.CommandCount;
+	}
+	_stats.ClustersTested = _clusterCuller->GetStats().ClustersTested;
+	_stats.ClustersCulled = _clusterCuller->GetStats().FrustumCulled + _clusterCuller->GetStats().BackfaceCulled;
+
+	// All of our draws read their instance data and commands from the same places
+	if (instances != nullptr) {
+		_uniformRing->BindRange(BufferType::ShaderStorage, INSTANCE_SSBO_BINDING, instanceAlloc);
+	}
+	_uniformRing->BindAs(BufferType::DrawIndirect);
+
+	// We track what we have bound so we only change state when the sorted keys do
+	ShaderProgram*     currentShader = nullptr;
+	Material*          currentMat    = nullptr;
+	VertexArrayObject* currentVao    = nullptr;
+
+	// Render all our batches
+	for (size_t ix = 0; ix < _batches.size();) {
+		const DrawBatch& batch = _batches[ix];
+
+		Material* material = batch.Renderable->GetMaterial().get();
+		ShaderProgram* shader = material->GetShader()->GetVariant(globalKeywords | material->GetKeywords());
+
+		// Pooled batches with the same material and bucket are drawn together, since their commands are next to each other
+		size_t end = ix + 1;
+		uint32_t drawCommands = batch.CommandCount;
+		uint32_t drawInstances = batch.InstanceCount;
+		while (batch.Pooled != nullptr && end < _batches.size() &&
+			_batches[end].Pooled != nullptr && _batches[end].Pooled->Owner == batch.Pooled->Owner &&
+			_batches[end].Renderable->GetMaterial().get() == material) {
+			drawCommands += _batches[end].CommandCount;
+			drawInstances += _batches[end].InstanceCount;
+			end++;
+		}
+		ix = end;
+
+		// Skip batches we couldn't allocate for, and meshes with every cluster culled
+		if (drawInstances == 0 || (batch.Pooled != nullptr && drawCommands == 0)) {
+			continue;
+		}
+
+		VertexArrayObject* vao = batch.Pooled != nullptr ? MeshPool::GetVao(batch.Pooled->Owner).get() : batch.Renderable->GetMesh().get();
+
+		if (shader != currentShader) {
+			currentShader = shader;
+			shader->Bind();
+			_stats.ShaderBinds++;
+		}
+		if (material != currentMat) {
+			currentMat = material;
+			material->Apply(shader);
+			_stats.MaterialApplies++;
+		}
+		if (vao != currentVao) {
+			currentVao = vao;
+			vao->Bind();
+			_stats.VaoBinds++;
+		}
+
+		if (batch.Pooled != nullptr) {
+			vao->DrawIndirectBound(commandAlloc.Offset + batch.FirstCommand * static_cast<uint32_t>(sizeof(DrawElementsIndirectCommand)), drawCommands);
+			_stats.IndirectCommands += drawCommands;
+		} else {
+			// Meshes outside the pool don't have the base instance attribute, so we pass it in as the attribute's constant value
+			glVertexAttribI4ui(MeshPool::INSTANCE_ID_SLOT, batch.FirstItem, 0, 0, 0);
+			vao->DrawLodInstancedBound(batch.Renderable->GetLodLevel(), batch.InstanceCount);
+		}
+		_stats.DrawsSubmitted++;
+		_stats.InstancesDrawn += drawInstances;
+	}
+	glVertexAttribI4ui(MeshPool::INSTANCE_ID_SLOT, 0, 0, 0, 0);
+
+	// Without sorting, every object would have bound its shader, material and VAO
+	_stats.StateChangesSaved = (_stats.InstancesDrawn * 3) - (_stats.ShaderBinds + _stats.MaterialApplies + _stats.VaoBinds);
 
 	// Use our cubemap to draw our skybox
 	app.CurrentScene()->DrawSkybox();
@@ -145,6 +378,47 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	VertexArrayObject::Unbind();
 }
 
+bool RenderLayer::_UsesClusterCulling(const RenderComponent* renderable) const {
+	return _clusterCulling && renderable->GetLodLevel() == 0 && !renderable->GetMeshResource()->Mesh->GetMeshlets().empty();
+}
+
+uint32_t RenderLayer::_SelectLod(const RenderComponent* renderable, const Bounds& worldBounds, const Gameplay::Camera& camera) const {
+	const std::vector<MeshLod>& lods = renderable->GetMeshResource()->Mesh->GetLods();
+	if (lods.size() < 2 || !worldBounds.IsValid()) {
+		return 0;
+	}
+
+	// LOD errors are relative to the size of the mesh, so we scale them by the size of the object as a fraction of
+	// the screen's height. The projection maps the screen's height to 2 units, so the half size of the object cancels that out
+	const glm::vec3 extents = worldBounds.GetExtents();
+	float screenScale = glm::max(extents.x, glm::max(extents.y, extents.z)) * camera.GetProjection()[1][1];
+	if (!camera.GetOrthoEnabled()) {
+		const float distance = glm::length(worldBounds.GetCenter() - camera.GetGameObject()->GetPosition()) - worldBounds.GetRadius();
+		screenScale /= glm::max(distance, camera.GetNearPlane());
+	}
+
+	// Find the coarsest level that is still under the threshold, and the coarsest that is comfortably under it
+	const uint32_t maxLevel = glm::min(static_cast<uint32_t>(lods.size()), 1u << RenderQueue::LOD_BITS) - 1;
+	uint32_t fine = 0;
+	uint32_t coarse = 0;
+	for (uint32_t level = 1; level <= maxLevel; level++) {
+		const float error = lods[level].Error * screenScale;
+		if (error <= LOD_SCREEN_ERROR) {
+			fine = level;
+		}
+		if (error <= LOD_SCREEN_ERROR * (1.0f - LOD_HYSTERESIS)) {
+			coarse = level;
+		}
+	}
+
+	// Always refine right away when the error gets too big, but wait until it's well under the threshold to coarsen
+	const uint32_t current = renderable->GetLodLevel();
+	if (current > fine) {
+		return fine;
+	}
+	return glm::max(current, coarse);
+}
+
 void RenderLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
 {
 	if (newSize.x * newSize.y == 0) return;
@@ -162,9 +436,9 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	Application& app = Application::Get();
 
 	// GL states, we'll enable depth testing and backface fulling
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	GlState::Enable(GL_DEPTH_TEST);
+	GlState::Enable(GL_CULL_FACE);
+	GlState::CullFace(GL_BACK);
 
 	// Create a new descriptor for our FBO
 	FramebufferDescriptor fboDescriptor;
@@ -180,15 +454,25 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	// Create the primary FBO
 	_primaryFBO = std::make_shared<Framebuffer>(fboDescriptor);
 
-	// Create our common uniform buffers
-	_frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
-	_instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
+	// Create the ring buffer that will hold our frame and instance data, it will grow if a frame needs more room
+	_uniformRing = std::make_shared<UniformRingBuffer>(64 * 1024);
+
+	// Scene meshes get copied in here the first time they're drawn
+	_meshPool = std::make_shared<MeshPool>();
 }
 
 const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
 	return _primaryFBO;
 }
 
+void RenderLayer::SetClusterCullingEnabled(bool value) {
+	_clusterCulling = value;
+}
+
+bool RenderLayer::IsClusterCullingEnabled() const {
+	return _clusterCulling;
+}
+
 bool RenderLayer::IsBlitEnabled() const {
 	return _blitFbo;
 }
@@ -216,3 +500,17 @@ void RenderLayer::SetRenderFlags(RenderFlags value) {
 RenderFlags RenderLayer::GetRenderFlags() const {
 	return _renderFlags;
 }
+
+const RenderLayer::RenderStats& RenderLayer::GetStats() const {
+	return _stats;
+}
+
+const MeshPool::Sptr& RenderLayer::GetMeshPool() const {
+	return _meshPool;
+}
+
+void RenderLayer::BindFrameUniforms() const {
+	if (_frameUniforms.Data != nullptr) {
+		_uniformRing->BindRange(BufferType::Uniform, FRAME_UBO_BINDING, _frameUniforms);
+	}
+}
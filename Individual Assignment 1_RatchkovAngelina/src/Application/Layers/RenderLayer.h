@@ -1,7 +1,19 @@
 #pragma once
 #include "../ApplicationLayer.h"
 #include "Graphics/Framebuffer.h"
-#include "Graphics/Buffers/UniformBuffer.h"
+#include "Graphics/Buffers/UniformRingBuffer.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/ClusterCuller.h"
+#include "Graphics/MeshPool.h"
+#include "Utils/Bounds.h"
+#include <unordered_map>
+#include <vector>
+
+class RenderComponent;
+namespace Gameplay {
+	class Material;
+	class Camera;
+}
 
 ENUM_FLAGS(RenderFlags, uint32_t,
 	None = 0,
@@ -35,7 +47,7 @@ public:
 
 	// Structure for our instance-level uniforms, matches layout from
 	// fragments/frame_uniforms.glsl
-	// For use with a UBO.
+	// For use with an SSBO, one per object drawn in a frame
 	struct InstanceLevelUniforms {
 		// Complete MVP
 		glm::mat4 u_ModelViewProjection;
@@ -43,6 +55,35 @@ public:
 		glm::mat4 u_Model;
 		// Normal Matrix for transforming normals
 		glm::mat4 u_NormalMatrix;
+		// The object's slot in the material parameter buffer, see Material::GetParameterSlot
+		uint32_t  u_MaterialIndex;
+		// std430 rounds the struct up to a multiple of the mat4 alignment
+		uint32_t  _padding[3];
+	};
+
+	// Counters that are reset and filled in every frame by OnRender
+	struct RenderStats {
+		// The number of draw calls issued for scene objects
+		uint32_t DrawsSubmitted    = 0;
+		// The number of indirect commands that those draw calls expanded to
+		uint32_t IndirectCommands  = 0;
+		// The number of objects drawn, a single draw may contain many instances
+		uint32_t InstancesDrawn    = 0;
+		// The number of objects that were outside the camera's frustum
+		uint32_t ObjectsCulled     = 0;
+		// The number of times a shader program was bound
+		uint32_t ShaderBinds       = 0;
+		// The number of times a material was applied
+		uint32_t MaterialApplies   = 0;
+		// The number of times a mesh VAO was bound
+		uint32_t VaoBinds          = 0;
+		// The number of shader, material and VAO binds that the sorted queue let us skip
+		uint32_t StateChangesSaved = 0;
+		// The number of visible objects that were drawn with a lower level of detail
+		uint32_t ReducedLodObjects = 0;
+		// The number of meshlets that were tested, and how many of those were culled
+		uint32_t ClustersTested    = 0;
+		uint32_t ClustersCulled    = 0;
 	};
 
 	RenderLayer();
@@ -62,6 +103,27 @@ public:
 	void SetRenderFlags(RenderFlags value);
 	RenderFlags GetRenderFlags() const;
 
+	/// <summary>
+	/// Enables or disables culling the meshlets of large meshes, when disabled they are drawn whole
+	/// </summary>
+	void SetClusterCullingEnabled(bool value);
+	bool IsClusterCullingEnabled() const;
+
+	/// <summary>
+	/// Gets the render statistics from the most recently rendered frame
+	/// </summary>
+	const RenderStats& GetStats() const;
+	/// <summary>
+	/// Gets the pool that scene meshes are copied into for multi-draw rendering
+	/// </summary>
+	const MeshPool::Sptr& GetMeshPool() const;
+	/// <summary>
+	/// Binds this frame's frame level uniforms to their UBO slot again. Layers that draw after this one
+	/// should call this rather than relying on the binding, since the ring buffer may have been re-created
+	/// or the slot used by something else in between
+	/// </summary>
+	void BindFrameUniforms() const;
+
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
@@ -76,8 +138,70 @@ protected:
 	RenderFlags       _renderFlags;
 
 	const int FRAME_UBO_BINDING = 0;
-	UniformBuffer<FrameLevelUniforms>::Sptr _frameUniforms;
 
-	const int INSTANCE_UBO_BINDING = 1;
-	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+	// A batch of objects sharing a mesh and material. Neighbouring batches that share a
+	// material and mesh pool bucket are submitted together with a single multi-draw
+	struct DrawBatch {
+		RenderComponent*       Renderable;
+		// Index of the first item in the render queue that belongs to this batch, this is also
+		// the index of it's first instance in the frame's instance data
+		uint32_t               FirstItem;
+		uint32_t               InstanceCount;
+		// Where the batch's mesh lives in the mesh pool, or nullptr if it has to be drawn on it's own
+		const MeshPool::Entry* Pooled;
+		// The range of the frame's indirect commands that draw this batch
+		uint32_t               FirstCommand;
+		uint32_t               CommandCount;
+	};
+
+	const int INSTANCE_SSBO_BINDING = 1;
+	std::vector<DrawBatch> _batches;
+
+	// The largest error a LOD may have on screen, as a fraction of the screen's height (about a pixel at 1080p)
+	const float LOD_SCREEN_ERROR = 0.001f;
+	// How much lower the error needs to be before we switch back to a coarser LOD, so objects
+	// sitting right at the threshold don't flicker between two levels
+	const float LOD_HYSTERESIS   = 0.25f;
+
+	/// <summary>
+	/// Picks the level of detail to draw an object with, based on how large the error of each level will be on screen
+	/// </summary>
+	/// <param name="renderable">The object to pick a level for, it's previous level is used for hysteresis</param>
+	/// <param name="worldBounds">The world space bounds of the object</param>
+	/// <param name="camera">The camera that the object will be drawn with</param>
+	uint32_t _SelectLod(const RenderComponent* renderable, const Bounds& worldBounds, const Gameplay::Camera& camera) const;
+
+	// Culls the meshlets of large meshes, and builds the indirect draws for the clusters that are left
+	ClusterCuller::Sptr _clusterCuller;
+	bool                _clusterCulling;
+
+	/// <summary>
+	/// Returns true if an object will be drawn cluster by cluster. These objects get a batch to themselves,
+	/// since each instance would see a different set of clusters
+	/// </summary>
+	bool _UsesClusterCulling(const RenderComponent* renderable) const;
+
+	// Frame and instance data, and indirect draw commands, are sub-allocated from here each frame
+	UniformRingBuffer::Sptr _uniformRing;
+	// Where this frame's frame level uniforms were written in the ring buffer
+	UniformRingBuffer::Allocation _frameUniforms;
+	// Scene meshes are copied into shared buffers here, so many of them can be drawn from one VAO
+	MeshPool::Sptr          _meshPool;
+
+	// Model and MVP matrices for every visible object, in render queue order
+	std::vector<glm::mat4> _modelMatrices;
+	std::vector<glm::mat4> _mvpMatrices;
+
+	// Everything that could be drawn this frame, along with their world bounds and visibility
+	std::vector<RenderComponent*>  _cullList;
+	std::vector<Bounds>            _cullBounds;
+	std::vector<uint8_t>           _cullResults;
+
+	// Sorts our draws every frame, indices in the queue point into _drawList
+	RenderQueue::Sptr              _renderQueue;
+	std::vector<RenderComponent*>  _drawList;
+	// Materials have no handle of their own, so we hand out compact IDs for the sort key each frame
+	std::unordered_map<const Gameplay::Material*, uint32_t> _materialIds;
+
+	RenderStats _stats;
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Gameplay/Material.h"
+#include "Graphics/GlState.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -10,6 +12,7 @@ DebugWindow::DebugWindow() :
 	SplitDirection = ImGuiDir_::ImGuiDir_None;
 	SplitDepth = 0.5f;
 	Requirements = EditorWindowRequirements::Menubar;
+	_benchmarkObjPath[0] = '\0';
 }
 
 DebugWindow::~DebugWindow() = default;
@@ -26,6 +29,50 @@ void DebugWindow::RenderMenuBar()
 
 	ImGui::Separator();
 
+	const RenderLayer::RenderStats& stats = renderLayer->GetStats();
+	ImGui::Text("Draws: %u (%u objects, %u commands)", stats.DrawsSubmitted, stats.InstancesDrawn, stats.IndirectCommands);
+	if (renderLayer->GetMeshPool() != nullptr) {
+		MeshPool::Stats poolStats = renderLayer->GetMeshPool()->GetStats();
+		ImGui::Text("Mesh Pool: %u meshes in %u buckets (%u KB)", poolStats.Meshes, poolStats.Buckets, (poolStats.VertexBytes + poolStats.IndexBytes) / 1024);
+	}
+	if (Gameplay::Material::GetParameterBuffer() != nullptr) {
+		const MaterialBuffer::Sptr& materials = Gameplay::Material::GetParameterBuffer();
+		ImGui::Text("Material Blocks: %u (%u uploads)", materials->GetSlotsUsed(), materials->GetUploadCount());
+	}
+	const GlState::Stats& glStats = GlState::GetFrameStats();
+	ImGui::Text("GL State Calls: %u (%u skipped)", glStats.Issued, glStats.Skipped);
+	ImGui::Text("Culled: %u", stats.ObjectsCulled);
+	ImGui::Text("State Changes Saved: %u", stats.StateChangesSaved);
+	ImGui::Text("Reduced LOD: %u", stats.ReducedLodObjects);
+	ImGui::Text("Clusters Culled: %u / %u", stats.ClustersCulled, stats.ClustersTested);
+	bool clusterCulling = renderLayer->IsClusterCullingEnabled();
+	if (ImGui::Checkbox("Cluster Culling", &clusterCulling)) {
+		renderLayer->SetClusterCullingEnabled(clusterCulling);
+	}
+
+	ImGui::Separator();
+
+	// Show how the last frame's jobs were spread over the threads
+	JobSystem& jobs = app.GetJobSystem();
+	JobSystem::Stats jobStats = jobs.GetStats();
+	jobs.ResetStats();
+	uint32_t totalJobs = 0;
+	for (uint32_t count : jobStats.JobsExecuted) {
+		totalJobs += count;
+	}
+	ImGui::Text("Jobs: %u (%u stolen, %u threads)", totalJobs, jobStats.JobsStolen, jobs.GetThreadCount());
+	if (ImGui::IsItemHovered() && totalJobs > 0) {
+		ImGui::BeginTooltip();
+		for (size_t ix = 0; ix < jobStats.JobsExecuted.size(); ix++) {
+			ImGui::Text("%s %zu: %u", ix == 0 ? "Main" : "Worker", ix, jobStats.JobsExecuted[ix]);
+		}
+		ImGui::EndTooltip();
+	}
+
+	ImGui::Separator();
+
+	_RenderBenchmarks();
+
 	//RenderFlags flags = renderLayer->GetRenderFlags();
 	//
 	//bool changed = false;
@@ -40,3 +87,36 @@ void DebugWindow::RenderMenuBar()
 	//	renderLayer->SetRenderFlags(flags);
 	//}
 }
+
+void DebugWindow::_RenderBenchmarks()
+{
+	if (!ImGui::CollapsingHeader("Benchmarks")) {
+		return;
+	}
+
+	// These block the main thread until they're done, so expect the editor to freeze for a bit
+	ImGui::InputText("OBJ File", _benchmarkObjPath, 256);
+	if (ImGui::IsItemHovered()) {
+		ImGui::SetTooltip("Leave empty to generate a 2 million triangle grid");
+	}
+	if (ImGui::Button("Compare OBJ Loaders")) {
+		std::string path = _benchmarkObjPath;
+		if (path.empty()) {
+			path = "benchmark_grid.obj";
+			Benchmarks::WriteGridObj(path, 1000);
+		}
+		_objLoaderResult = Benchmarks::RunObjLoaders(path);
+	}
+	if (_objLoaderResult.Success) {
+		ImGui::Text("Legacy:    %.3fs (%u verts, %u tris)", _objLoaderResult.LegacySeconds, _objLoaderResult.LegacyVertices, _objLoaderResult.LegacyTriangles);
+		ImGui::Text("ObjParser: %.3fs (%u verts, %u tris)", _objLoaderResult.ParserSeconds, _objLoaderResult.ParserVertices, _objLoaderResult.ParserTriangles);
+	}
+
+	ImGui::Separator();
+	if (ImGui::Button("Measure Job Scaling")) {
+		_jobScalingResults = Benchmarks::RunJobScaling();
+	}
+	for (const Benchmarks::JobScalingResult& result : _jobScalingResults) {
+		ImGui::Text("%2u threads: %.2f ms (%.2fx)", result.Threads, result.Seconds * 1000.0, result.Speedup);
+	}
+}
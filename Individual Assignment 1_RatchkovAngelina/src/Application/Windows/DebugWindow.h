@@ -1,5 +1,6 @@
 #pragma once
 #include "Application/IEditorWindow.h"
+#include "Utils/Benchmarks.h"
 
 /**
  * Handles displaying debug information
@@ -15,4 +16,10 @@ public:
 	virtual void RenderMenuBar() override;
 
 protected:
+	// The OBJ file to run the loader benchmark on, left empty to generate a grid
+	char _benchmarkObjPath[256];
+	Benchmarks::ObjLoaderResult _objLoaderResult;
+	std::vector<Benchmarks::JobScalingResult> _jobScalingResults;
+
+	void _RenderBenchmarks();
 };
\ No newline at end of file
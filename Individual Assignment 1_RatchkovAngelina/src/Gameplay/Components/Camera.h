@@ -3,6 +3,7 @@
 #include <memory>
 #include <GLM/glm.hpp>
 #include "Gameplay/Components/IComponent.h"
+#include "Utils/Frustum.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -67,6 +68,14 @@ namespace Gameplay {
 		/// Gets whether this camera is in orthographic mode
 		/// </summary>
 		bool GetOrthoEnabled() const { return _isOrtho; }
+		/// <summary>
+		/// Gets the distance to this camera's near clipping plane
+		/// </summary>
+		float GetNearPlane() const { return _nearPlane; }
+		/// <summary>
+		/// Gets the distance to this camera's far clipping plane
+		/// </summary>
+		float GetFarPlane() const { return _farPlane; }
 
 		/// <summary>
 		/// Gets the view matrix for this camera
@@ -80,6 +89,10 @@ namespace Gameplay {
 		/// Gets the combined view-projection matrix for this camera, calculating if needed
 		/// </summary>
 		const glm::mat4& GetViewProjection() const;
+		/// <summary>
+		/// Gets the clipping planes of this camera in world space, recalculated from the view-projection
+		/// </summary>
+		const Frustum& GetFrustum() const;
 
 		const glm::vec4& GetClearColor() const;
 		void SetClearColor(const glm::vec4& color);
@@ -101,6 +114,9 @@ namespace Gameplay {
 		// A dirty flag that indicates whether we need to re-calculate our view projection matrix
 		mutable bool      _isDirty;
 
+		// The world space clipping planes, updated in GetFrustum
+		mutable Frustum   _frustum;
+
 		glm::vec4         _clearColor;
 
 		// Recalculates the projection matrix
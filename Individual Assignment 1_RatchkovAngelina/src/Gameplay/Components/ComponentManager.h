@@ -1,6 +1,7 @@
 #pragma once
 #include <functional>
 #include "IComponent.h"
+#include "ComponentPool.h"
 #include <typeindex>
 #include <optional>
 #include <Logging.h>
@@ -15,6 +16,17 @@ namespace Gameplay {
 	public:
 		typedef std::function<IComponent::Sptr(const nlohmann::json&)> LoadComponentFunc;
 		typedef std::function<IComponent::Sptr()> CreateComponentFunc;
+		typedef std::function<std::unique_ptr<IComponentPool>()> CreatePoolFunc;
+
+		/// <summary>
+		/// The data that a component type reads and writes in it's Update, see DECLARE_UPDATE_ACCESS
+		/// </summary>
+		struct UpdateAccess {
+			// False if the type did not declare it's access, and must be updated on the main thread
+			bool            IsDeclared = false;
+			ComponentAccess Reads      = ComponentAccess::None;
+			ComponentAccess Writes     = ComponentAccess::None;
+		};
 
 		/// <summary>
 		/// Loads a component with the given type name from a JSON blob
@@ -42,7 +54,7 @@ namespace Gameplay {
 					result->_weakSelfPtr = result;
 
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_AddToPool(result.get());
 					return result;
 				}
 			}
@@ -71,7 +83,7 @@ namespace Gameplay {
 					result->_realType = typeIndex.value();
 					result->_weakSelfPtr = result;
 					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					_AddToPool(result.get());
 					return result;
 				}
 			}
@@ -98,7 +110,7 @@ namespace Gameplay {
 				result->_realType = type;
 				result->_weakSelfPtr = result;
 				// Add the component to the global pools
-				_Components[result->_realType].push_back(result);
+				_AddToPool(result.get());
 				return result;
 			}
 			return nullptr;
@@ -139,8 +151,8 @@ namespace Gameplay {
 			// Give the component a weak pointer to itself that it can upcast to a shared pointer when needed
 			component->_weakSelfPtr = component;
 
-			// Add to global component list for that type
-			_Components[type].push_back(component);
+			// Add to global component pool for that type
+			_AddToPool(component.get());
 
 			// Return the result
 			return component;
@@ -157,56 +169,53 @@ namespace Gameplay {
 			typename ComponentType,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
 		std::shared_ptr<ComponentType> GetComponentByGUID(Guid id) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
+			auto it = _ComponentsByGuid.find(id);
 
-			// Clear any dead weak pointers
-			auto removeIt = std::remove_if(_Components[type].begin(), _Components[type].end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			_Components[type].erase(removeIt, _Components[type].end());
-
-			// Search the component store for a component that matches that ID
-			auto& it = std::find_if(_Components[type].begin(), _Components[type].end(), [&](const std::weak_ptr<IComponent>& ptr) {
-				return (ptr.lock())->GetGUID() == id;
-			});
-
-			// If the component was found, return it. Otherwise return nullptr
-			if (it != _Components[type].end()) {
-				// We need to lock the weak pointer to convert it to a shared ptr
-				return std::dynamic_pointer_cast<ComponentType>((*it).lock());
-			} else {
-				return nullptr;
+			// Make sure the component exists and is of the requested type
+			if (it != _ComponentsByGuid.end() && it->second->_realType == std::type_index(typeid(ComponentType))) {
+				// The component's self reference lets us hand out a shared ptr
+				return std::static_pointer_cast<ComponentType>(it->second->SelfRef().lock());
 			}
+			return nullptr;
 		}
 
 		/// <summary>
-		/// Iterates over all components of the given type and invokes a method with them
+		/// Iterates over all components of the given type and invokes a method with them. The callback
+		/// is invoked with a raw pointer to each component, and should not destroy components
 		/// </summary>
 		/// <typeparam name="ComponentType">The type of component to iterate on</typeparam>
+		/// <typeparam name="Func">The type of the callback, should accept a ComponentType*</typeparam>
 		/// <param name="callback">The callback to invoke with the components</param>
 		/// <param name="includeDisabled">True to include disabled components, false if otherwise</param>
 		template <
 			typename ComponentType,
+			typename Func,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
-		void Each(std::function<void(const std::shared_ptr<ComponentType>&)> callback, bool includeDisabled = false) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
-
-			// Iterate over all the components in the store
-			for (auto& wptr : _Components[type]) {
-				// Lock the weak pointer to get a shared pointer (maybe)
-				std::shared_ptr<IComponent> sptr = wptr.lock();
-				// If the pointer is alive and matches our enabled criteria, invoke the callback
-				if (sptr && sptr->IsEnabled | includeDisabled) {
-					// Upcast to component type and invoke the callback
-					callback(std::dynamic_pointer_cast<ComponentType>(sptr));
+		void Each(Func&& callback, bool includeDisabled = false) {
+			ComponentPool<ComponentType>* pool = _GetPool<ComponentType>();
+
+			// Iterate over all the components in the pool
+			const size_t count = pool->Size();
+			for (size_t ix = 0; ix < count; ix++) {
+				ComponentType* component = (*pool)[ix];
+				// If the component matches our enabled criteria, invoke the callback
+				if (component->IsEnabled || includeDisabled) {
+					callback(component);
 				}
 			}
 		}
 
+		/// <summary>
+		/// Iterates over the pools for every registered component type, in the order the types were registered
+		/// </summary>
+		/// <param name="callback">The callback to invoke with the pool and the type's declared update access</param>
+		template <typename Func>
+		void EachPool(Func&& callback) {
+			for (const std::type_index& type : _TypeOrder) {
+				callback(*_GetPool(type), _TypeAccessRegistry[type]);
+			}
+		}
+
 		/// <summary>
 		/// Attempts to register a given type as a component, should be called for each component type 
 		/// at the start of you application
@@ -226,6 +235,17 @@ namespace Gameplay {
 				// name to type index mapping
 				_TypeLoadRegistry[type] = &ComponentManager::ParseTypeFromBlob<T>;
 				_TypeCreateRegistry[type] = &ComponentManager::_InternalCreate<T>;
+				_TypePoolRegistry[type] = &ComponentManager::_InternalCreatePool<T>;
+				_TypeOrder.push_back(type);
+
+				// Store what the type touches in update, if it's told us
+				UpdateAccess access;
+				if constexpr (has_update_access<T>::value) {
+					access.IsDeclared = true;
+					access.Reads = T::UpdateReads();
+					access.Writes = T::UpdateWrites();
+				}
+				_TypeAccessRegistry[type] = access;
 				_TypeNameMap[StringTools::SanitizeClassName(typeid(T).name())] = type;
 			}
 		}
@@ -234,7 +254,8 @@ namespace Gameplay {
 		/// Removes all components of all types from the registry, whether they are referenced elsewhere or not
 		/// </summary>
 		inline void FlushAll() {
-			_Components = std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>>();
+			_Pools = std::unordered_map<std::type_index, std::unique_ptr<IComponentPool>>();
+			_ComponentsByGuid = std::unordered_map<Guid, IComponent*>();
 		}
 
 	private:
@@ -250,10 +271,18 @@ namespace Gameplay {
 		// Stores functions to load components from JSON, indexed on the type that they load
 		inline static std::unordered_map<std::type_index, CreateComponentFunc> _TypeCreateRegistry;
 
-		// Weak pointers let us store a reference to an object stored by a shared pointer, without
-		// actually increasing the reference count. Thus components will be destroyed at the correct
-		// time (when the only reference is the one stored here).
-		std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> _Components;  
+		// Stores functions to create an empty pool for a component type
+		inline static std::unordered_map<std::type_index, CreatePoolFunc> _TypePoolRegistry;
+		// Stores what each component type reads and writes during update
+		inline static std::unordered_map<std::type_index, UpdateAccess> _TypeAccessRegistry;
+		// All registered types, in the order they were registered
+		inline static std::vector<std::type_index> _TypeOrder;
+
+		// The pools only store raw pointers, components are owned by their game objects and remove
+		// themselves from their pool when destroyed
+		std::unordered_map<std::type_index, std::unique_ptr<IComponentPool>> _Pools;
+		// Lets us find components by GUID without searching the pools
+		std::unordered_map<Guid, IComponent*> _ComponentsByGuid;
 
 		template <typename T>
 		static IComponent::Sptr ParseTypeFromBlob(const nlohmann::json& blob) {
@@ -278,6 +307,37 @@ namespace Gameplay {
 			return component;
 		}
 
+		template <typename ComponentType>
+		static std::unique_ptr<IComponentPool> _InternalCreatePool() {
+			return std::make_unique<ComponentPool<ComponentType>>();
+		}
+
+		/// <summary>
+		/// Gets the pool for the given component type, creating it if it does not exist yet
+		/// </summary>
+		inline IComponentPool* _GetPool(const std::type_index& type) {
+			auto it = _Pools.find(type);
+			if (it == _Pools.end()) {
+				LOG_ASSERT(_TypePoolRegistry[type] != nullptr, "You must register component types before creating them!");
+				it = _Pools.emplace(type, _TypePoolRegistry[type]()).first;
+			}
+			return it->second.get();
+		}
+
+		template <typename ComponentType>
+		ComponentPool<ComponentType>* _GetPool() {
+			// The pool for a type is always created by _InternalCreatePool with the same type
+			return static_cast<ComponentPool<ComponentType>*>(_GetPool(std::type_index(typeid(ComponentType))));
+		}
+
+		/// <summary>
+		/// Adds a component to the pool matching it's real type, and stores the pool handle in the component
+		/// </summary>
+		inline void _AddToPool(IComponent* component) {
+			component->_poolHandle = _GetPool(component->_realType)->Add(component);
+			_ComponentsByGuid[component->GetGUID()] = component;
+		}
+
 		/// <summary>
 		/// Removes a given component from the global pools. To be used in the IComponent destructor
 		/// </summary>
@@ -288,15 +348,15 @@ namespace Gameplay {
 			// Make sure the component's type was one that was registered
 			LOG_ASSERT(_TypeLoadRegistry[component->_realType] != nullptr, "You must register component types before creating them!");
 
-			// Get a reference to the vector of components for easy access
-			std::vector<std::weak_ptr<IComponent>>& componentStore = _Components[component->_realType];
+			// The pool may have been flushed since the component was added
+			auto it = _Pools.find(component->_realType);
+			if (it != _Pools.end()) {
+				it->second->Remove(component->_poolHandle, component);
+			}
 
-			// Clear any dead weak pointers
-			auto it = std::remove_if(componentStore.begin(), componentStore.end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			if (it != componentStore.end()) {
-				componentStore.erase(it);
+			auto guidIt = _ComponentsByGuid.find(component->GetGUID());
+			if (guidIt != _ComponentsByGuid.end() && guidIt->second == component) {
+				_ComponentsByGuid.erase(guidIt);
 			}
 		}
 	};
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "IComponent.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// Type erased interface for component pools, so that the component manager can
+	/// add and remove components when it only knows their type_index
+	/// </summary>
+	class IComponentPool {
+	public:
+		typedef uint32_t Handle;
+		static constexpr Handle InvalidHandle = std::numeric_limits<uint32_t>::max();
+
+		virtual ~IComponentPool() = default;
+
+		/// <summary>
+		/// Adds a component to the pool, the component must be of the pool's type
+		/// </summary>
+		/// <returns>A handle that stays valid until the component is removed</returns>
+		virtual Handle Add(IComponent* component) = 0;
+		/// <summary>
+		/// Removes a component from the pool, moving the last component into it's slot
+		/// </summary>
+		/// <param name="handle">The handle returned when the component was added</param>
+		/// <param name="component">The component being removed, used to ignore stale handles</param>
+		virtual void Remove(Handle handle, const IComponent* component) = 0;
+		/// <summary>
+		/// Gets the number of components in the pool
+		/// </summary>
+		virtual size_t Size() const = 0;
+		/// <summary>
+		/// Gets the component at the given index in the pool, for when the concrete type is not known
+		/// </summary>
+		virtual IComponent* At(size_t ix) const = 0;
+	};
+
+	/// <summary>
+	/// Stores pointers to all the components of a single type in one contiguous array, so that
+	/// iterating over them is a linear walk with no locking or casting. Handles map to slots in
+	/// the dense array through a sparse table, so they survive other components being removed
+	///
+	/// The pool does not own the components, they are still owned by their game objects
+	/// </summary>
+	/// <typeparam name="T">The type of component stored in the pool</typeparam>
+	template <typename T>
+	class ComponentPool final : public IComponentPool {
+	public:
+		ComponentPool() = default;
+		virtual ~ComponentPool() = default;
+
+		Handle Add(IComponent* component) override {
+			// Re-use a released handle if we can, otherwise grow the sparse table
+			Handle handle;
+			if (!_freeHandles.empty()) {
+				handle = _freeHandles.back();
+				_freeHandles.pop_back();
+			} else {
+				handle = static_cast<Handle>(_sparse.size());
+				_sparse.push_back(InvalidHandle);
+			}
+
+			_sparse[handle] = static_cast<uint32_t>(_components.size());
+			_components.push_back(static_cast<T*>(component));
+			_handles.push_back(handle);
+			return handle;
+		}
+
+		void Remove(Handle handle, const IComponent* component) override {
+			if (handle >= _sparse.size() || _sparse[handle] == InvalidHandle) {
+				return;
+			}
+			const uint32_t index = _sparse[handle];
+			if (static_cast<const IComponent*>(_components[index]) != component) {
+				return;
+			}
+
+			// Swap and pop, fixing up the handle of whatever got moved
+			const uint32_t last = static_cast<uint32_t>(_components.size() - 1);
+			if (index != last) {
+				_components[index] = _components[last];
+				_handles[index] = _handles[last];
+				_sparse[_handles[index]] = index;
+			}
+			_components.pop_back();
+			_handles.pop_back();
+
+			_sparse[handle] = InvalidHandle;
+			_freeHandles.push_back(handle);
+		}
+
+		size_t Size() const override { return _components.size(); }
+		IComponent* At(size_t ix) const override { return _components[ix]; }
+
+		/// <summary>
+		/// Gets the component for a handle, or nullptr if the handle is no longer valid
+		/// </summary>
+		T* Get(Handle handle) const {
+			return handle < _sparse.size() && _sparse[handle] != InvalidHandle ? _components[_sparse[handle]] : nullptr;
+		}
+
+		T* operator[](size_t ix) const { return _components[ix]; }
+
+		typename std::vector<T*>::const_iterator begin() const { return _components.cbegin(); }
+		typename std::vector<T*>::const_iterator end() const { return _components.cend(); }
+
+	private:
+		// Dense arrays, in no particular order
+		std::vector<T*>       _components;
+		std::vector<Handle>   _handles;
+		// Maps handles to indices in the dense arrays, InvalidHandle for released handles
+		std::vector<uint32_t> _sparse;
+		std::vector<Handle>   _freeHandles;
+	};
+}
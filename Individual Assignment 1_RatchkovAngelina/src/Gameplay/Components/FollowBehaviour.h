@@ -33,6 +33,7 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static FollowBehaviour::Sptr FromJson(const nlohmann::json& blob);
 	MAKE_TYPENAME(FollowBehaviour);
+	DECLARE_UPDATE_ACCESS(Gameplay::ComponentAccess::Transform, Gameplay::ComponentAccess::Transform | Gameplay::ComponentAccess::OwnState);
 	void SetTarget(const Gameplay::GameObject::Sptr& object);
 	float Evaluate(float x);
 
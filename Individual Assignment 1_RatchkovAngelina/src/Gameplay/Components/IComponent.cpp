@@ -28,7 +28,8 @@ namespace Gameplay {
 		IResource(),
 		IsEnabled(true),
 		_realType(typeid(IComponent)),
-		_context(nullptr)
+		_context(nullptr),
+		_poolHandle(IComponentPool::InvalidHandle)
 	{ }
 
 	IComponent::~IComponent() {
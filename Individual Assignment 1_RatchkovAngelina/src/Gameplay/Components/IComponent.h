@@ -1,5 +1,7 @@
 #pragma once
 #include <memory>
+#include <type_traits>
+#include <EnumToString.h>
 #include "json.hpp"
 #include <imgui.h>
 #include <GLM/glm.hpp>
@@ -13,6 +15,20 @@ namespace Gameplay {
 	// We pre-declare GameObject to avoid circular dependencies in the headers
 	class GameObject;
 
+	/// <summary>
+	/// Describes the data that a component touches during it's Update, so that the scene
+	/// can tell which component types are safe to update at the same time
+	/// </summary>
+	ENUM_FLAGS(ComponentAccess, uint32_t,
+		None      = 0,
+		// The position, rotation and scale of game objects. Writes are deferred until the end of the update phase
+		Transform = 1 << 0,
+		// The rigidbody or trigger volume attached to the game object
+		RigidBody = 1 << 1,
+		// The fields of the component itself
+		OwnState  = 1 << 2
+	);
+
 	namespace Physics {
 		class TriggerVolume;
 		class RigidBody;
@@ -162,6 +178,8 @@ namespace Gameplay {
 
 		std::type_index _realType;
 		GameObject* _context;
+		// Our handle in the component manager's pool for our type
+		uint32_t _poolHandle;
 
 		// By storing a weak pointer to ourselves, we can pass a pointer to this
 		// for things like bullet user pointers
@@ -171,6 +189,14 @@ namespace Gameplay {
 		static void SaveBaseJson(const IComponent::Sptr& instance, nlohmann::json& data);
 	};
 
+	/// <summary>
+	/// Checks whether a component type has declared it's update access with DECLARE_UPDATE_ACCESS
+	/// </summary>
+	template <typename T, typename = void>
+	struct has_update_access : std::false_type {};
+	template <typename T>
+	struct has_update_access<T, std::void_t<decltype(T::UpdateReads()), decltype(T::UpdateWrites())>> : std::true_type {};
+
 	/// <summary>
 	/// Returns true if the given type is a valid component type
 	/// </summary>
@@ -185,3 +211,9 @@ namespace Gameplay {
 #define MAKE_TYPENAME(T) \
 	inline virtual std::string ComponentTypeName() const { \
 		static std::string name = StringTools::SanitizeClassName(typeid(T).name()); return name; }
+
+// Declares what a component type reads and writes in Update. Types with a declaration can be
+// updated on worker threads, types without one are always updated on the main thread
+#define DECLARE_UPDATE_ACCESS(reads, writes) \
+	static Gameplay::ComponentAccess UpdateReads() { return reads; } \
+	static Gameplay::ComponentAccess UpdateWrites() { return writes; }
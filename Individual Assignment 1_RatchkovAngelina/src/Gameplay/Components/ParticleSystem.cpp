@@ -3,6 +3,12 @@
 #include "Application/Timing.h"
 #include "Application/Application.h"
 #include "Utils/ImGuiHelper.h"
+#include "Graphics/GlState.h"
+
+namespace {
+	// The uniforms we set every update, hashed up front so we don't look them up by string
+	constexpr UniformId GRAVITY_UNIFORM("u_Gravity");
+}
 
 ParticleSystem::ParticleSystem() :
 	IComponent(),
@@ -11,7 +17,9 @@ ParticleSystem::ParticleSystem() :
 	_numParticles(0),
 	_particleBuffers(),
 	_feedbackBuffers(),
-	_query(0),
+	_queries(),
+	_queryPending(),
+	_queryIndex(0),
 	_currentVertexBuffer(0),
 	_currentFeedbackBuffer(1),
 	_updateShader(nullptr),
@@ -23,9 +31,11 @@ ParticleSystem::ParticleSystem() :
 ParticleSystem::~ParticleSystem()
 {
 	if (_hasInit) {
+		GlState::OnBufferDeleted(_particleBuffers[0]);
+		GlState::OnBufferDeleted(_particleBuffers[1]);
 		glDeleteBuffers(2, _particleBuffers);
 		glDeleteTransformFeedbacks(2, _feedbackBuffers);
-		glDeleteQueries(1, &_query);
+		glDeleteQueries(QUERY_FRAMES, _queries);
 		_updateShader = nullptr;
 		_renderShader = nullptr;
 	}
@@ -51,18 +61,19 @@ void ParticleSystem::Update()
 
 		// Set up our first transform feedback buffer to write to the first buffer
 		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _feedbackBuffers[0]);
-		glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[0]);
+		GlState::BindBuffer(GL_ARRAY_BUFFER, _particleBuffers[0]);
 		glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_DYNAMIC_DRAW);
-		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[0]);
+		GlState::BindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[0]);
 
 		// Set up the second transform feedback buffer to write to the second buffer
 		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _feedbackBuffers[1]);
-		glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[1]);
+		GlState::BindBuffer(GL_ARRAY_BUFFER, _particleBuffers[1]);
 		glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_DYNAMIC_DRAW);
-		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[1]);
+		GlState::BindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[1]);
 
-		// We create a query object to track the number of particles we're simulating
-		glGenQueries(1, &_query);
+		// We create a few query objects to track the number of particles we're simulating, so that we
+		// can read each one a few frames after it was issued
+		glGenQueries(QUERY_FRAMES, _queries);
 
 		// We no longer need the CPU copy
 		delete[] data;
@@ -70,22 +81,19 @@ void ParticleSystem::Update()
 
 
 	// Disable rasterization, this is update only
-	glEnable(GL_RASTERIZER_DISCARD);
+	GlState::Enable(GL_RASTERIZER_DISCARD);
 
 	// Make sure no VAOs are bound
-	glBindVertexArray(0);
+	GlState::BindVertexArray(0);
 
 	// Bind the buffer and transform feedback
-	glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[_currentVertexBuffer]);
+	GlState::BindBuffer(GL_ARRAY_BUFFER, _particleBuffers[_currentVertexBuffer]);
 	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _feedbackBuffers[_currentFeedbackBuffer]);
 
-	// Enable our attributes, aside from color since it doesn't impact simulation
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glEnableVertexAttribArray(3);
-	glEnableVertexAttribArray(4);
-	glEnableVertexAttribArray(5);
+	// Enable our attributes, these stay enabled on the default VAO so after the first update these are skipped
+	for (uint32_t ix = 0; ix < 6; ix++) {
+		GlState::EnableVertexAttribArray(ix);
+	}
 
 	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ParticleData), 0); // type
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Position)); // position
@@ -96,10 +104,13 @@ void ParticleSystem::Update()
 
 	// Bind the update shader and send our relevant uniforms
 	_updateShader->Bind();
-	_updateShader->SetUniform("u_Gravity", _gravity);
+	_updateShader->SetUniform(GRAVITY_UNIFORM, _gravity);
+
+	// The query in this slot was issued QUERY_FRAMES updates ago, grab it's result before we re-use it
+	_ReadParticleCount();
 
 	// Our particles are points that we're simulating
-	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _query);
+	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _queries[_queryIndex]);
 	glBeginTransformFeedback(GL_POINTS);
 
 	// If this is our first pass, we use drawArrays to get the initial state, otherwise we use transform feedback for rendering
@@ -113,28 +124,14 @@ void ParticleSystem::Update()
 	// End of transform feedback
 	glEndTransformFeedback();
 	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
-
-	// Use our query to get the number of particles
-	glGetQueryObjectuiv(_query, GL_QUERY_RESULT, &_numParticles);
-	if (_numParticles >= _emitters.size()) {
-		_numParticles -= _emitters.size();
-	}
-	else {
-		_numParticles = 0;
-	}
+	_queryPending[_queryIndex] = true;
+	_queryIndex = (_queryIndex + 1) % QUERY_FRAMES;
 
 	// Clean up our state
 	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
-	glDisableVertexAttribArray(3);
-	glDisableVertexAttribArray(4);
-	glDisableVertexAttribArray(5);
-
 	// Re-enable rasterization for later OpenGL calls
-	glDisable(GL_RASTERIZER_DISCARD);
+	GlState::Disable(GL_RASTERIZER_DISCARD);
 
 	_hasInit = true;
 
@@ -152,24 +149,40 @@ void ParticleSystem::Render()
 		_renderShader->Bind();
 
 		// Make sure no VAOs are bound
-		glBindVertexArray(0);
+		GlState::BindVertexArray(0);
 
 		// Bind the current feedback buffer as our drawing buffer
-		glBindBuffer(GL_ARRAY_BUFFER, _particleBuffers[_currentVertexBuffer]);
+		GlState::BindBuffer(GL_ARRAY_BUFFER, _particleBuffers[_currentVertexBuffer]);
 
-		// Enable just position and color
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(3);
+		// We only read position and color, the other attributes are still enabled from the update but
+		// our render shader doesn't use them
+		GlState::EnableVertexAttribArray(1);
+		GlState::EnableVertexAttribArray(3);
 		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Position)); // position
 		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Color)); // color 
 
 		// Draw our particles using whatever data we have in transform feedback buffer
 		glDrawTransformFeedback(GL_POINTS, _feedbackBuffers[_currentVertexBuffer]);
+	}
+}
+
+void ParticleSystem::_ReadParticleCount()
+{
+	if (!_queryPending[_queryIndex]) {
+		return;
+	}
 
-		// Clean up after ourselves
-		glDisableVertexAttribArray(1);
-		glDisableVertexAttribArray(3);
+	// Only read the result if it's ready, we'd rather show an old count than stall the CPU. If it's
+	// not ready the query just gets restarted, which throws away it's result
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuiv(_queries[_queryIndex], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available) {
+		GLuint written = 0;
+		glGetQueryObjectuiv(_queries[_queryIndex], GL_QUERY_RESULT, &written);
+		// Emitters are written out along with the particles
+		_numParticles = written >= _emitters.size() ? written - (GLuint)_emitters.size() : 0;
 	}
+	_queryPending[_queryIndex] = false;
 }
 
 void ParticleSystem::AddEmitter(const glm::vec3& position, const glm::vec3& direction, float emitRate /*= 1.0f*/, const glm::vec4& color /*= glm::vec4(1.0f)*/)
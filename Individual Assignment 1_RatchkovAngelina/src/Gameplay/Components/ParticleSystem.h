@@ -11,6 +11,9 @@ class ParticleSystem : public Gameplay::IComponent{
 public:
 	MAKE_PTRS(ParticleSystem);
 
+	// The number of updates we wait before reading back a particle count, so we never wait on the GPU
+	static constexpr uint32_t QUERY_FRAMES = 3;
+
 	ParticleSystem();
 	~ParticleSystem();
 
@@ -42,11 +45,18 @@ protected:
 	bool _hasInit;
 
 	uint32_t _maxParticles;
+	// Only used for display, this is QUERY_FRAMES updates behind the simulation
 	GLuint _numParticles;
 
 	uint32_t _particleBuffers[2];
 	uint32_t _feedbackBuffers[2];
-	uint32_t _query;
+	// A ring of primitive queries, one per update, that are read back QUERY_FRAMES updates later
+	uint32_t _queries[QUERY_FRAMES];
+	bool     _queryPending[QUERY_FRAMES];
+	uint32_t _queryIndex;
+
+	// Reads the query in the current slot of the ring if the GPU is done with it
+	void _ReadParticleCount();
 
 	uint32_t _currentVertexBuffer;
 	uint32_t _currentFeedbackBuffer;
@@ -2,22 +2,31 @@
 
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Gameplay/GameObject.h"
 
 
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
 	_mesh(mesh), 
 	_material(material), 
+	_lodLevel(0),
 	_meshBuilderParams(std::vector<MeshBuilderParam>()) 
 { }
 
 RenderComponent::RenderComponent() : 
 	_mesh(nullptr), 
 	_material(nullptr), 
+	_lodLevel(0),
 	_meshBuilderParams(std::vector<MeshBuilderParam>())
 { }
 
 void RenderComponent::SetMesh(const Gameplay::MeshResource::Sptr& mesh) {
 	_mesh = mesh;
+	_lodLevel = 0;
+
+	// Let our game object know how big it is, so it can be culled
+	if (GetGameObject() != nullptr) {
+		GetGameObject()->SetLocalBounds(_mesh != nullptr ? _mesh->LocalBounds : Bounds());
+	}
 }
 
 const Gameplay::MeshResource::Sptr& RenderComponent::GetMeshResource() const {
@@ -36,6 +45,10 @@ const Gameplay::Material::Sptr& RenderComponent::GetMaterial() const {
 	return _material;
 }
 
+void RenderComponent::OnLoad() {
+	GetGameObject()->SetLocalBounds(_mesh != nullptr ? _mesh->LocalBounds : Bounds());
+}
+
 nlohmann::json RenderComponent::ToJson() const {
 	nlohmann::json result;
 	result["mesh"] = _mesh ? _mesh->GetGUID().str() : "null";
@@ -54,6 +67,7 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 void RenderComponent::RenderImGui() {
 	ImGui::Text("Indexed:   %s", GetMesh() != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
 	ImGui::Text("Triangles: %d", GetMesh() != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
+	ImGui::Text("LOD:       %u / %u", _lodLevel, GetMesh() != nullptr ? _mesh->Mesh->GetLodCount() : 1);
 	ImGui::Text("Source:    %s", (_mesh == nullptr || _mesh->Filename.empty()) ? "Generated" : _mesh->Filename.c_str());
 	ImGui::Separator();
 	ImGui::Text("Material:  %s", _material != nullptr ? _material->Name.c_str() : "NULL");
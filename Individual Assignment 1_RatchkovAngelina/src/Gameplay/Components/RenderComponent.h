@@ -42,8 +42,19 @@ public:
 	/// <param name="mat">The material for this object</param>
 	void SetMaterial(const Gameplay::Material::Sptr& mat);
 
+	/// <summary>
+	/// Gets the level of detail that the renderer last picked for this object, 0 is full detail
+	/// </summary>
+	uint32_t GetLodLevel() const { return _lodLevel; }
+	/// <summary>
+	/// Sets the level of detail to draw, the renderer keeps this between frames so that it can
+	/// avoid flickering between two levels
+	/// </summary>
+	void SetLodLevel(uint32_t level) { _lodLevel = level; }
+
 	// Inherited from IComponent
 
+	virtual void OnLoad() override;
 	virtual void RenderImGui() override;
 	virtual nlohmann::json ToJson() const override;
 	static RenderComponent::Sptr FromJson(const nlohmann::json& data);
@@ -54,6 +65,8 @@ protected:
 	Gameplay::MeshResource::Sptr _mesh;
 	// The object's material
 	Gameplay::Material::Sptr      _material;
+	// The level of detail of the mesh that was drawn last frame
+	uint32_t                      _lodLevel;
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
@@ -19,5 +19,6 @@ public:
 	static RotatingBehaviour::Sptr FromJson(const nlohmann::json& data);
 
 	MAKE_TYPENAME(RotatingBehaviour);
+	DECLARE_UPDATE_ACCESS(Gameplay::ComponentAccess::Transform, Gameplay::ComponentAccess::Transform);
 };
 
@@ -33,6 +33,7 @@ public:
 	virtual nlohmann::json ToJson() const override;
 	static SteeringBehaviour::Sptr FromJson(const nlohmann::json& blob);
 	MAKE_TYPENAME(SteeringBehaviour);
+	DECLARE_UPDATE_ACCESS(Gameplay::ComponentAccess::None, Gameplay::ComponentAccess::Transform | Gameplay::ComponentAccess::OwnState);
 
 	void SetPoints(std::vector<glm::vec3> ps);
 	float Evaluate(float x);
@@ -14,63 +14,36 @@
 #include "Gameplay/Scene.h"
 
 namespace Gameplay {
-	GameObject::GameObject() :
+	GameObject::GameObject(Scene* scene) :
 		IResource(),
 		Name("Unknown"),
 		HideInHierarchy(false),
 		_components(std::vector<IComponent::Sptr>()),
-		_scene(nullptr),
-		_position(ZERO),
-		_rotation(glm::quat(glm::vec3(0.0f))),
-		_scale(ONE),
-		_localTransform(MAT4_IDENTITY),
-		_inverseLocalTransform(MAT4_IDENTITY),
-		_isLocalTransformDirty(true),
-		_worldTransform(MAT4_IDENTITY),
-		_inverseWorldTransform(MAT4_IDENTITY),
-		_isWorldTransformDirty(true),
+		_scene(scene),
+		_transforms(scene->_transforms),
+		_transform(TransformSystem::InvalidHandle),
+		_normalMatrix(MAT3_IDENTITY),
+		_normalMatrixVersion(0),
+		_localBounds(),
+		_worldBounds(),
+		_worldBoundsVersion(0),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
-	{ }
-
-	void GameObject::_RecalcLocalTransform() const
-	{
-		if (_isLocalTransformDirty) {
-			_localTransform = glm::translate(MAT4_IDENTITY, _position) * glm::mat4_cast(_rotation) * glm::scale(MAT4_IDENTITY, _scale);
-			_inverseLocalTransform = glm::inverse(_localTransform);
-			_isLocalTransformDirty = false;
-			_isWorldTransformDirty = true;
-
-			// Dirty all the child objects world transforms
-			for (const auto& childPtr : _children) {
-				GameObject::Sptr childSptr = childPtr;
-				if (childSptr != nullptr) {
-					childSptr->_isWorldTransformDirty = true;
-				}
-			}
-		}
+	{ 
+		_transform = _transforms->Create();
+		// Make sure our cached values get calculated on first use
+		_normalMatrixVersion = _worldBoundsVersion = _transforms->GetWorldVersion(_transform) - 1;
 	}
 
-	void GameObject::_RecalcWorldTransform() const {
-		// Start by determining our local transform if required
-		_RecalcLocalTransform();
-
-		// If our world transform has been marked as dirty, we need to recalculate it!
-		if (_isWorldTransformDirty) {
-			GameObject::Sptr parent = _parent;
-
-			// If out parent exists, we apply our local transformation relative to the parent's world transformation
-			if (parent != nullptr) {
-				_worldTransform = parent->GetTransform() * _localTransform;
-				_inverseWorldTransform = glm::inverse(_worldTransform);
-			}
+	GameObject::~GameObject() {
+		_transforms->Destroy(_transform);
+	}
 
-			// If our parent is null, we can simply use the local transform as the world transform
-			else {
-				_worldTransform = _localTransform;
-				_inverseWorldTransform = _inverseLocalTransform;
-			}
-			_isWorldTransformDirty = false;
+	void GameObject::SetName(const std::string& name) {
+		std::string oldName = Name;
+		Name = name;
+		if (_scene != nullptr) {
+			_scene->_OnObjectRenamed(this, oldName);
 		}
 	}
 
@@ -82,7 +55,7 @@ namespace Gameplay {
 	}
 
 	void GameObject::LookAt(const glm::vec3& point) {
-		glm::mat4 rot = glm::lookAt(_position, point, glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 rot = glm::lookAt(GetPosition(), point, glm::vec3(0.0f, 0.0f, 1.0f));
 		// Take the conjugate of the quaternion, as lookAt returns the *inverse* rotation
 		SetRotation(glm::conjugate(glm::quat_cast(rot)));
 	}
@@ -112,60 +85,93 @@ namespace Gameplay {
 	}
 
 	void GameObject::SetPostion(const glm::vec3& position) {
-		_position = position;
-		_isLocalTransformDirty = true;
+		if (_scene->_scheduler.IsDeferringWrites()) {
+			_scene->_scheduler.DeferPosition(this, position);
+		} else {
+			_transforms->SetPosition(_transform, position);
+		}
 	}
 
 	const glm::vec3& GameObject::GetPosition() const {
-		return _position;
+		return _transforms->GetPosition(_transform);
 	}
 
 	void GameObject::SetRotation(const glm::quat& value) {
-		_rotation = value;
-		_isLocalTransformDirty = true;
+		if (_scene->_scheduler.IsDeferringWrites()) {
+			_scene->_scheduler.DeferRotation(this, value);
+		} else {
+			_transforms->SetRotation(_transform, value);
+		}
 	}
 
 	const glm::quat& GameObject::GetRotation() const {
-		return _rotation;
+		return _transforms->GetRotation(_transform);
 	}
 
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
-		_rotation = glm::quat(glm::radians(eulerAngles));
-		_isLocalTransformDirty = true;
+		SetRotation(glm::quat(glm::radians(eulerAngles)));
 	}
 
 	glm::vec3 GameObject::GetRotationEuler() const {
-		return glm::degrees(glm::eulerAngles(_rotation));
+		return glm::degrees(glm::eulerAngles(GetRotation()));
 	}
 
 	void GameObject::SetScale(const glm::vec3& value) {
-		_scale = value;
-		_isLocalTransformDirty = true;
+		if (_scene->_scheduler.IsDeferringWrites()) {
+			_scene->_scheduler.DeferScale(this, value);
+		} else {
+			_transforms->SetScale(_transform, value);
+		}
 	}
 
 	const glm::vec3& GameObject::GetScale() const {
-		return _scale;
+		return _transforms->GetScale(_transform);
 	}
 
 	const glm::mat4& GameObject::GetTransform() const {
-		_RecalcWorldTransform();
-		return _worldTransform;
+		return _transforms->GetWorldTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetInverseTransform() const {
-		_RecalcWorldTransform();
-		return _inverseWorldTransform;
+		return _transforms->GetInverseWorldTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetLocalTransform() const
 	{
-		_RecalcLocalTransform();
-		return _localTransform;
+		return _transforms->GetLocalTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetInverseLocalTransform() const {
-		_RecalcLocalTransform();
-		return _inverseLocalTransform;
+		return _transforms->GetInverseLocalTransform(_transform);
+	}
+
+	const glm::mat3& GameObject::GetNormalMatrix() const {
+		const uint32_t version = _transforms->GetWorldVersion(_transform);
+		if (_normalMatrixVersion != version) {
+			// We already have the inverse, so this is just a transpose
+			_normalMatrix = glm::transpose(glm::mat3(GetInverseTransform()));
+			_normalMatrixVersion = version;
+		}
+		return _normalMatrix;
+	}
+
+	void GameObject::SetLocalBounds(const Bounds& bounds) {
+		_localBounds = bounds;
+		// Force the world bounds to be recalculated on next access
+		_worldBoundsVersion = _transforms->GetWorldVersion(_transform) - 1;
+	}
+
+	const Bounds& GameObject::GetLocalBounds() const {
+		return _localBounds;
+	}
+
+	const Bounds& GameObject::GetWorldBounds() const {
+		const uint32_t version = _transforms->GetWorldVersion(_transform);
+		if (_worldBoundsVersion != version) {
+			_worldBounds = _localBounds.Transformed(GetTransform());
+			_worldBoundsVersion = version;
+		}
+		return _worldBounds;
 	}
 
 	void GameObject::RenderGUI() {
@@ -212,8 +218,6 @@ namespace Gameplay {
 			}
 		}
 
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
 		_PurgeDeletedChildren();
 	}
 
@@ -275,7 +279,7 @@ namespace Gameplay {
 			// applies to the child
 			_children.push_back(child);
 			child->_parent = _selfRef.lock();
-			child->_isWorldTransformDirty = true;
+			child->_transforms->SetParent(child->_transform, _transform);
 		} else {
 			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->Name);
 		}
@@ -288,6 +292,7 @@ namespace Gameplay {
 		if (it != _children.end()) { 
 			// Clear the object's parent and remove from our list of children
 			child->_parent.Reset();
+			child->_transforms->SetParent(child->_transform, TransformSystem::InvalidHandle);
 			_children.erase(it);
 			return true;
 		} else {
@@ -320,7 +325,7 @@ namespace Gameplay {
 			memcpy(nameBuff, Name.c_str(), Name.size());
 			nameBuff[Name.size()] = '\0';
 			if (ImGui::InputText("", nameBuff, 256)) {
-				Name = nameBuff;
+				SetName(nameBuff);
 			}
 			ImGui::SameLine();
 			if (ImGuiHelper::WarningButton("Delete")) {
@@ -350,16 +355,19 @@ namespace Gameplay {
 			}
 
 			// Render position label
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
+			glm::vec3 position = GetPosition();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Position", &position.x, 0.01f)) {
+				SetPostion(position);
+			}
 			
 			// Get the ImGui storage state so we can avoid gimbal locking issues by storing euler angles in the editor
 			glm::vec3 euler = GetRotationEuler();
 			ImGuiStorage* guiStore = ImGui::GetStateStorage();
 
-			// Extract the angles from the storage, note that we're only using the address of the position for unique IDs
-			euler.x = guiStore->GetFloat(ImGui::GetID(&_position.x), euler.x);
-			euler.y = guiStore->GetFloat(ImGui::GetID(&_position.y), euler.y);
-			euler.z = guiStore->GetFloat(ImGui::GetID(&_position.z), euler.z);
+			// Extract the angles from the storage, the IDs are unique since we're inside this object's ID scope
+			euler.x = guiStore->GetFloat(ImGui::GetID("##euler_x"), euler.x);
+			euler.y = guiStore->GetFloat(ImGui::GetID("##euler_y"), euler.y);
+			euler.z = guiStore->GetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 			//Draw the slider for angles
 			if (LABEL_LEFT(ImGui::DragFloat3, "Rotation", &euler.x, 1.0f)) {
@@ -367,16 +375,19 @@ namespace Gameplay {
 				euler = Wrap(euler, -180.0f, 180.0f);
 
 				// Update the editor state with our new values
-				guiStore->SetFloat(ImGui::GetID(&_position.x), euler.x);
-				guiStore->SetFloat(ImGui::GetID(&_position.y), euler.y);
-				guiStore->SetFloat(ImGui::GetID(&_position.z), euler.z);
+				guiStore->SetFloat(ImGui::GetID("##euler_x"), euler.x);
+				guiStore->SetFloat(ImGui::GetID("##euler_y"), euler.y);
+				guiStore->SetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 				//Send new rotation to the gameobject
 				SetRotation(euler);
 			}
 			
 			// Draw the scale
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+			glm::vec3 scale = GetScale();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &scale.x, 0.01f, 0.0f)) {
+				SetScale(scale);
+			}
 
 			ImGui::Separator();
 			ImGui::TextUnformatted("Components");
@@ -434,10 +445,6 @@ namespace Gameplay {
 			ImGui::Unindent();
 		}
 		ImGui::PopID(); // Pop the ImGui ID scope for the object
-
-		// For if we're not in play mode
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
 	}
 
 	std::shared_ptr<GameObject> GameObject::SelfRef() {
@@ -448,19 +455,16 @@ namespace Gameplay {
 	{
 		// We need to manually construct since the GameObject constructor is
 		// protected. We can call it here since Scene is a friend class of GameObjects
-		GameObject::Sptr result(new GameObject());
-		result->_scene = scene;
+		GameObject::Sptr result(new GameObject(scene));
 
 		// Load in basic info
 		result->Name = data["name"];
 		result->_guid = Guid(data["guid"]);
 		result->_parent = WeakRef(Guid(data.contains("parent") ? data["parent"] : "null"), nullptr);
-		result->_position = (data["position"]);
-		result->_rotation = (data["rotation"]);
-		result->_scale    = (data["scale"]);
+		result->SetPostion((glm::vec3)(data["position"]));
+		result->SetRotation((glm::quat)(data["rotation"]));
+		result->SetScale((glm::vec3)(data["scale"]));
 		result->HideInHierarchy = JsonGet(data, "hide_in_inspector", false);
-		result->_isLocalTransformDirty = true;
-		result->_isWorldTransformDirty = true;
 
 		// Since our components are stored based on the type name, we iterate
 		// on the keys and values from the components object
@@ -485,9 +489,9 @@ namespace Gameplay {
 		nlohmann::json result = {
 			{ "name", Name },
 			{ "guid", _guid.str() },
-			{ "position", _position },
-			{ "rotation", _rotation },
-			{ "scale",    _scale },
+			{ "position", GetPosition() },
+			{ "rotation", GetRotation() },
+			{ "scale",    GetScale() },
 			{ "parent",   parent == nullptr ? "null" : parent->_guid.str() },
 			{ "hide_in_inspector", HideInHierarchy }
 		};
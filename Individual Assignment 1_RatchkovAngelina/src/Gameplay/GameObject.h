@@ -12,6 +12,8 @@
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Utils/ResourceManager/IResource.h"
+#include "Utils/Bounds.h"
+#include "Gameplay/TransformSystem.h"
 
 class InspectorWindow;
 class HierarchyWindow;
@@ -133,12 +135,21 @@ namespace Gameplay {
 			void Reset();
 		};
 
-		// Human readable name for the object
+		// Human readable name for the object, use SetName to rename objects that
+		// have been added to a scene so that FindObjectByName stays in sync
 		std::string             Name;
 
 		// Hack to hide instances from the hierarchy (like when adding lots of instances)
 		bool HideInHierarchy = false;
 
+		virtual ~GameObject();
+
+		/// <summary>
+		/// Renames this object, updating the scene's name lookup
+		/// </summary>
+		/// <param name="name">The new name for the object</param>
+		void SetName(const std::string& name);
+
 		/// <summary>
 		/// Rotates this object to look at the given point in world coordinates
 		/// </summary>
@@ -172,6 +183,9 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Sets the game object's world position
+		/// 
+		/// Note that while components are being updated on worker threads, changes to the position, rotation
+		/// or scale are applied at the end of the update phase rather than immediately
 		/// </summary>
 		/// <param name="position">The new position for the object in world space</param>
 		void SetPostion(const glm::vec3& position);
@@ -224,6 +238,26 @@ namespace Gameplay {
 		const glm::mat4& GetLocalTransform() const;
 		const glm::mat4& GetInverseLocalTransform() const;
 
+		/// <summary>
+		/// Gets or recalculates the matrix for transforming normals into world space (the
+		/// transpose of the inverse world transform)
+		/// </summary>
+		const glm::mat3& GetNormalMatrix() const;
+
+		/// <summary>
+		/// Sets the bounds of this object in model space, usually set by the object's render component
+		/// </summary>
+		void SetLocalBounds(const Bounds& bounds);
+		/// <summary>
+		/// Gets the bounds of this object in model space
+		/// </summary>
+		const Bounds& GetLocalBounds() const;
+		/// <summary>
+		/// Gets or recalculates the bounds of this object in world space, will be invalid
+		/// if the object has no local bounds
+		/// </summary>
+		const Bounds& GetWorldBounds() const;
+
 		/// <summary>
 		/// Allows components to render GUI elements to the screen
 		/// </summary>
@@ -337,21 +371,18 @@ namespace Gameplay {
 		friend class InspectorWindow;
 		friend class HierarchyWindow;
 
-		// Rotation of the object as a quaternion
-		glm::quat _rotation;
-		// Position of the object
-		glm::vec3 _position;
-		// The scale of the object
-		glm::vec3 _scale;
+		// The scene's transform storage, and our node within it. We hold a reference
+		// to the system so that it outlives us even if the scene is destroyed first
+		std::shared_ptr<TransformSystem> _transforms;
+		TransformSystem::Handle          _transform;
 
-		// The object's world transform
-		mutable glm::mat4 _localTransform;
-		mutable glm::mat4 _inverseLocalTransform;
-		mutable bool _isLocalTransformDirty;
+		// The world version of our transform that the cached values below were calculated from
+		mutable glm::mat3 _normalMatrix;
+		mutable uint32_t  _normalMatrixVersion;
 
-		mutable glm::mat4 _worldTransform;
-		mutable glm::mat4 _inverseWorldTransform;
-		mutable bool _isWorldTransformDirty;
+		Bounds         _localBounds;
+		mutable Bounds _worldBounds;
+		mutable uint32_t _worldBoundsVersion;
 
 		// For the hierarchy
 		WeakRef _parent;
@@ -369,11 +400,8 @@ namespace Gameplay {
 		/// <summary>
 		/// Only scenes will be allowed to create gameobjects
 		/// </summary>
-		GameObject();
-
-		// Recalculates the transform matrix for the object when required
-		void _RecalcLocalTransform() const;
-		void _RecalcWorldTransform() const;
+		/// <param name="scene">The scene that will own the object</param>
+		GameObject(Scene* scene);
 
 		void _PurgeDeletedChildren();
 	};
@@ -1,4 +1,6 @@
 #include "Gameplay/Material.h"
+#include <algorithm>
+#include <unordered_map>
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Graphics/Textures/TextureCube.h"
@@ -9,10 +11,24 @@
 #include "Graphics/Textures/Texture3D.h"
 
 namespace Gameplay {
+	MaterialBuffer::Sptr Material::__parameterBuffer = nullptr;
+
+	// Parameters that were renamed when they moved into the material block, so older manifests still load
+	static const std::unordered_map<std::string, std::string> LEGACY_PARAMETER_NAMES = {
+		{ "u_Material.Shininess", "u_Shininess" },
+		{ "u_Material.Threshold", "u_Threshold" },
+		{ "u_Material.Steps",     "u_Steps" }
+	};
+
 	Material::Material(const ShaderProgram::Sptr& shader) :
 		IResource(),
 		_shader(shader),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_uniforms(std::vector<UniformData>()),
+		_keywords(0),
+		_blockSize(0),
+		_blockSlot(MaterialBuffer::NO_SLOT),
+		_blockDirty(true),
+		_variantLocations()
 	{
 		_PopulateUniforms();
 	}
@@ -20,35 +36,28 @@ namespace Gameplay {
 	Material::Material() :
 		IResource(),
 		_shader(nullptr),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_uniforms(std::vector<UniformData>()),
+		_keywords(0),
+		_blockSize(0),
+		_blockSlot(MaterialBuffer::NO_SLOT),
+		_blockDirty(true),
+		_variantLocations()
 	{ }
 
+	Material::~Material() {
+		if (_blockSlot != MaterialBuffer::NO_SLOT && __parameterBuffer != nullptr) {
+			__parameterBuffer->Release(_blockSlot);
+		}
+	}
+
 	void Material::Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize)
 	{
 		// Try and find the matching uniform
-		UniformData& uniform = _GetUniform(name);
+		UniformData* uniform = _FindUniform(UniformId(name));
 
 		// We have a uniform, let's see if we can update it
-		if (uniform.Location != -2) {
-			// If it's a texture, we update TextureAsset so it adds to the ref count
-			if (GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && type == ShaderDataType::None) {
-				uniform.TextureAsset = *reinterpret_cast<const ITexture::Sptr*>(value);
-			}
-			// Check for type mismatch
-			else if (uniform.Type != type && uniform.Type != ShaderDataType::None) {
-				LOG_ERROR("Type mismatch for \"{}\", uniform is {}, passed {} in material \"{}\"", name, ~uniform.Type, ~type, Name);
-			}
-			// Types match, we're good to go
-			else {
-				// if it's an array, copy all the elements
-				if (uniform.ArraySize > 1) {
-					memcpy(uniform.ArrayBlock, value, ShaderDataTypeSize(type) * arraySize);
-				} 
-				// if it's just a value, copy the value
-				else {
-					memcpy(uniform.Value, value, ShaderDataTypeSize(type));
-				}
-			}
+		if (uniform != nullptr && uniform->Location != -2) {
+			_SetValue(*uniform, type, value, arraySize);
 		}
 		// We couldn't find that uniform, log a warning
 		else {
@@ -56,17 +65,77 @@ namespace Gameplay {
 		}
 	}
 
+	void Material::Set(UniformId id, ShaderDataType type, const void* value, size_t arraySize)
+	{
+		UniformData* uniform = _FindUniform(id);
+		if (uniform != nullptr && uniform->Location != -2) {
+			_SetValue(*uniform, type, value, arraySize);
+		} else {
+			LOG_WARN("Failed to set parameter {:016x} in material \"{}\", shader uniform not found", id.Value, Name);
+		}
+	}
+
+	void Material::_SetValue(UniformData& uniform, ShaderDataType type, const void* value, size_t arraySize)
+	{
+		// If it's a texture, we update TextureAsset so it adds to the ref count
+		if (GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && type == ShaderDataType::None) {
+			uniform.TextureAsset = *reinterpret_cast<const ITexture::Sptr*>(value);
+		}
+		// Check for type mismatch
+		else if (uniform.Type != type && uniform.Type != ShaderDataType::None) {
+			LOG_ERROR("Type mismatch for \"{}\", uniform is {}, passed {} in material \"{}\"", uniform.Name, ~uniform.Type, ~type, Name);
+		}
+		// Types match, we're good to go
+		else {
+			// if it's an array, copy all the elements, otherwise just the value
+			void* dest = uniform.ArraySize > 1 ? uniform.ArrayBlock : uniform.Value;
+			const size_t size = ShaderDataTypeSize(type) * (uniform.ArraySize > 1 ? arraySize : 1);
+			// Scenes tend to set the same values every frame, so only re-upload the block if something changed
+			if (memcmp(dest, value, size) != 0) {
+				memcpy(dest, value, size);
+				_blockDirty |= uniform.IsInBlock();
+			}
+		}
+	}
+
 	const ShaderProgram::Sptr& Material::GetShader() const {
 		return _shader;
 	}
 
+	void Material::SetKeyword(const std::string& keyword, bool enabled) {
+		uint32_t mask = ShaderProgram::GetKeywordMask(keyword);
+		_keywords = enabled ? (_keywords | mask) : (_keywords & ~mask);
+	}
+
 	void Material::Apply() {
-		if (_shader != nullptr) {
+		Apply(_shader.get());
+	}
+
+	void Material::Apply(ShaderProgram* program) {
+		if (program != nullptr) {
+			// Variants are linked separately, so their uniforms may not be where our shader's are
+			const int* variantLocations = program != _shader.get() ? _GetVariantLocations(program).data() : nullptr;
+
+			// Everything in our block is bound in one go, variants share our block layout since it's std140
+			if (_blockSize > 0) {
+				_UpdateBlock();
+				if (_blockSlot != MaterialBuffer::NO_SLOT) {
+					__parameterBuffer->BindSlot(_blockSlot, _blockSize);
+				}
+			}
+
 			// Skip the reserved # of texture slots
 			int textureSlot = 0;
 			
-			// Iterate over the uniforms map
-			for (auto&[name, data] : _uniforms) {
+			// Iterate over the uniforms, these are already in a flat array so there's nothing to look up
+			for (size_t ix = 0; ix < _uniforms.size(); ix++) {
+				UniformData& data = _uniforms[ix];
+				// Skip uniforms the shader doesn't have, and our reserved textures
+				if (data.Location < 0) {
+					continue;
+				}
+				int location = variantLocations != nullptr ? variantLocations[ix] : data.Location;
+
 				// The typecode is basically the underlying type of the uniform
 				// ex: float, matrix, texture, etc...
 				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
@@ -85,13 +154,13 @@ namespace Gameplay {
 							ITexture::Unbind(textureSlot);
 						}
 						// Send the slot to the shader
-						_shader->SetUniform(data.Location, data.Type, &textureSlot);
+						program->SetUniform(location, data.Type, &textureSlot);
 						textureSlot++;
 					}
 				}
 				// The uniform is a plain ol' value type, send it in
 				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+					program->SetUniform(location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
 				}
 			}
 		}
@@ -107,9 +176,9 @@ namespace Gameplay {
 		if (open) {
 			ImGui::Text("Shader: %s", _shader != nullptr ? _shader->GetDebugName().c_str() : "null");
 			// Draw all of our valid uniforms
-			for (auto&[key, value] : _uniforms) {
-				if (value.Location != -2 && value.Location != -1) {
-					value.RenderImGui();
+			for (UniformData& value : _uniforms) {
+				if (value.Location >= 0 || value.IsInBlock()) {
+					_blockDirty |= value.RenderImGui() && value.IsInBlock();
 				}
 			}
 
@@ -134,14 +203,26 @@ namespace Gameplay {
 		result->_shader = ResourceManager::Get<ShaderProgram>(Guid(data["shader"]));
 		result->_PopulateUniforms();
 
+		// Keywords are stored by name, since their bits depend on the order shaders were loaded in
+		if (data.contains("keywords") && data["keywords"].is_array()) {
+			for (auto& keyword : data["keywords"]) {
+				result->SetKeyword(keyword.get<std::string>(), true);
+			}
+		}
+
 		// material specific parameters'
 		if (data.contains("parameters") && data["parameters"].is_object()) {
 			// Iterate over all objects
-			for (auto& [key, value] : data["parameters"].items()) {
+			for (auto& [blobKey, value] : data["parameters"].items()) {
+				auto legacy = LEGACY_PARAMETER_NAMES.find(blobKey);
+				const std::string& key = legacy != LEGACY_PARAMETER_NAMES.end() ? legacy->second : blobKey;
+
 				// Try loading a uniform from the blob, if successful, store it
 				Material::UniformData uniform = Material::UniformData::FromJson(value, key, result->_shader);
 				if (uniform.Location != -2) {
-					result->_uniforms[key] = uniform;
+					result->_GetUniform(key) = uniform;
+				} else {
+					LOG_WARN("Dropping parameter \"{}\" from material \"{}\", the shader does not have it", blobKey, result->Name);
 				}
 			}
 		}
@@ -156,10 +237,14 @@ namespace Gameplay {
 			{ "parameters", nlohmann::json() }
 		};
 
+		if (_keywords != 0) {
+			result["keywords"] = ShaderProgram::GetKeywordNames(_keywords);
+		}
+
 		// Store all the uniforms
-		for (auto& [key, value] : _uniforms) {
-			if (value.Location != -1) {
-				result["parameters"][key] = value.ToJson();
+		for (const UniformData& value : _uniforms) {
+			if (value.Location != -1 || value.IsInBlock()) {
+				result["parameters"][value.Name] = value.ToJson();
 			}
 		}
 
@@ -168,7 +253,19 @@ namespace Gameplay {
 
 	Material::UniformData& Material::_GetUniform(const std::string& name)
 	{
-		UniformData& data = _uniforms[name];
+		UniformId id = UniformId(name);
+		auto it = std::lower_bound(_uniforms.begin(), _uniforms.end(), id, [](const UniformData& uniform, UniformId value) {
+			return uniform.Id < value;
+		});
+		if (it != _uniforms.end() && it->Id == id) {
+			return *it;
+		}
+
+		// Insert in place so the array stays sorted, this shifts the indices our variant tables use
+		_variantLocations.clear();
+		UniformData& data = *_uniforms.emplace(it);
+		data.Name = name;
+		data.Id = id;
 		if (data.Location == -2) {
 			ShaderProgram::UniformInfo uniform;
 			if (_shader->FindUniform(name, &uniform)) {
@@ -180,18 +277,100 @@ namespace Gameplay {
 					data = UniformData(name, _shader);
 				}
 			} else {
-				data.Location = -1;
+				// It may still be in our material block, otherwise the shader doesn't have it
+				UniformData blockData = UniformData(name, _shader);
+				if (blockData.IsInBlock()) {
+					data = blockData;
+				} else {
+					data.Location = -1;
+				}
 			}
 		}
 		return data;
 	}
 
+	const std::vector<int>& Material::_GetVariantLocations(const ShaderProgram* program)
+	{
+		auto it = _variantLocations.find(program);
+		if (it != _variantLocations.end()) {
+			return it->second;
+		}
+
+		std::vector<int>& locations = _variantLocations[program];
+		locations.resize(_uniforms.size(), -1);
+		for (size_t ix = 0; ix < _uniforms.size(); ix++) {
+			if (_uniforms[ix].Location >= 0) {
+				locations[ix] = program->GetUniformLocation(_uniforms[ix].Id);
+			}
+		}
+		return locations;
+	}
+
+	Material::UniformData* Material::_FindUniform(UniformId id)
+	{
+		auto it = std::lower_bound(_uniforms.begin(), _uniforms.end(), id, [](const UniformData& uniform, UniformId value) {
+			return uniform.Id < value;
+		});
+		return (it != _uniforms.end() && it->Id == id) ? &(*it) : nullptr;
+	}
+
 	void Material::_PopulateUniforms()
 	{
 		const auto& uniforms = _shader->GetUniforms();
+		const ShaderProgram::UniformBlockInfo* block = _shader->GetUniformBlock(MaterialBuffer::BLOCK_NAME);
+
+		_uniforms.reserve(uniforms.size() + (block != nullptr ? block->SubUniforms.size() : 0));
 		for (const auto& [key, value] : uniforms) {
-			_uniforms[key] = _GetUniform(key);
+			_GetUniform(key);
 		}
+		if (block != nullptr) {
+			for (const ShaderProgram::UniformInfo& value : block->SubUniforms) {
+				_GetUniform(value.Name);
+			}
+		}
+		_blockSize = block != nullptr ? static_cast<uint32_t>(block->SizeInBytes) : 0;
+		_blockDirty = true;
+	}
+
+	void Material::_UpdateBlock()
+	{
+		if (__parameterBuffer == nullptr) {
+			__parameterBuffer = std::make_shared<MaterialBuffer>();
+		}
+		if (_blockSize > __parameterBuffer->GetSlotSize()) {
+			LOG_ERROR("Material block of \"{}\" is {} bytes, but material slots only hold {}", _shader->GetDebugName(), _blockSize, __parameterBuffer->GetSlotSize());
+			_blockSize = 0;
+			return;
+		}
+
+		if (_blockSlot == MaterialBuffer::NO_SLOT) {
+			_blockSlot = __parameterBuffer->Allocate();
+			_blockDirty = true;
+		}
+		if (!_blockDirty) {
+			return;
+		}
+
+		// Anything the shader has in the block that we don't set (like padding) is left as zero
+		std::vector<uint8_t> block(_blockSize, 0);
+		for (const UniformData& uniform : _uniforms) {
+			if (uniform.IsInBlock()) {
+				uniform.Pack(block.data());
+			}
+		}
+		__parameterBuffer->Upload(_blockSlot, block.data(), _blockSize);
+		_blockDirty = false;
+	}
+
+	uint32_t Material::GetParameterSlot() {
+		if (_blockSize > 0) {
+			_UpdateBlock();
+		}
+		return _blockSize > 0 ? _blockSlot : MaterialBuffer::NO_SLOT;
+	}
+
+	const MaterialBuffer::Sptr& Material::GetParameterBuffer() {
+		return __parameterBuffer;
 	}
 
 	bool Material::UniformData::RenderImGui() {
@@ -403,8 +582,44 @@ namespace Gameplay {
 	{
 		// We extract the uniform info from the shader to populate our info
 		ShaderProgram::UniformInfo uniform;
-		if (shader != nullptr && shader->FindUniform(uniformName, &uniform)) {
+		const ShaderProgram::UniformInfo* blockUniform = nullptr;
+		const ShaderProgram::UniformBlockInfo* block = shader != nullptr ? shader->GetUniformBlock(MaterialBuffer::BLOCK_NAME) : nullptr;
+		if (block != nullptr) {
+			for (const ShaderProgram::UniformInfo& value : block->SubUniforms) {
+				if (value.Name == uniformName) {
+					blockUniform = &value;
+					break;
+				}
+			}
+		}
+
+		if (blockUniform != nullptr) {
+			// Uniforms in a block don't have a location, the block's layout gives us their offset instead
+			Name = uniformName;
+			Id = UniformId(uniformName);
+			Location = -1;
+			Type = blockUniform->Type;
+			ArraySize = blockUniform->ArraySize;
+			BindingSlot = -1;
+			BlockOffset = blockUniform->Location;
+			ArrayStride = blockUniform->ArrayStride;
+			MatrixStride = blockUniform->MatrixStride;
+
+			// These get uploaded as a whole block, so start them at zero rather than whatever was in memory,
+			// or at the value the shader declares for them since block members can't have initializers
+			if (ArraySize > 1) {
+				ArrayBlock = calloc(ArraySize, ShaderDataTypeSize(Type));
+			} else {
+				memset(Value, 0, sizeof(Value));
+				const std::vector<double>* defaults = shader->GetUniformDefault(uniformName);
+				if (defaults != nullptr) {
+					SetDefault(*defaults);
+				}
+			}
+		}
+		else if (shader != nullptr && shader->FindUniform(uniformName, &uniform)) {
 			Name = uniformName;
+			Id = UniformId(uniformName);
 			Location = uniform.Location;
 			Type = uniform.Type;
 			ArraySize = uniform.ArraySize;
@@ -421,7 +636,11 @@ namespace Gameplay {
 		TextureAsset(nullptr) 
 	{
 		Name = other.Name;
+		Id = other.Id;
 		Location = other.Location;
+		BlockOffset = other.BlockOffset;
+		ArrayStride = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 		ArraySize = other.ArraySize;
 		Type = other.Type;
 
@@ -432,7 +651,7 @@ namespace Gameplay {
 		if (ArraySize > 1) {
 			ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
 			memcpy(ArrayBlock, other.ArrayBlock, ShaderDataTypeSize(Type) * ArraySize);
-		} else {
+		} else if (Type != ShaderDataType::None) {
 			memcpy(Value, other.Value, ShaderDataTypeSize(Type));
 		}
 	}
@@ -441,7 +660,11 @@ namespace Gameplay {
 		TextureAsset(nullptr) 
 	{
 		Name      = other.Name;
+		Id        = other.Id;
 		Location  = other.Location;
+		BlockOffset  = other.BlockOffset;
+		ArrayStride  = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 		ArraySize = other.ArraySize;
 		Type      = other.Type;
 
@@ -453,11 +676,70 @@ namespace Gameplay {
 			ArrayBlock = other.ArrayBlock;
 			other.ArrayBlock = nullptr;
 			other.ArraySize  = 0;
-		} else {
+		} else if (Type != ShaderDataType::None) {
 			memcpy(Value, other.Value, ShaderDataTypeSize(Type));
 		}
 	}
 
+	void Material::UniformData::SetDefault(const std::vector<double>& values)
+	{
+		const ShaderDataTypecode typeCode = GetShaderDataTypeCode(Type);
+		const uint32_t components = std::min(ShaderDataTypeComponentCount(Type), static_cast<uint32_t>(values.size()));
+		for (uint32_t ix = 0; ix < components; ix++) {
+			switch (typeCode) {
+				case ShaderDataTypecode::Bool:   reinterpret_cast<bool*>(Value)[ix]     = values[ix] != 0.0; break;
+				case ShaderDataTypecode::Float:  reinterpret_cast<float*>(Value)[ix]    = static_cast<float>(values[ix]); break;
+				case ShaderDataTypecode::Double: reinterpret_cast<double*>(Value)[ix]   = values[ix]; break;
+				case ShaderDataTypecode::Int:    reinterpret_cast<int32_t*>(Value)[ix]  = static_cast<int32_t>(values[ix]); break;
+				case ShaderDataTypecode::Uint:   reinterpret_cast<uint32_t*>(Value)[ix] = static_cast<uint32_t>(values[ix]); break;
+				default:
+					LOG_WARN("Ignoring default value for \"{}\", {} uniforms can't have defaults", Name, ~Type);
+					return;
+			}
+		}
+	}
+
+	void Material::UniformData::Pack(uint8_t* block) const
+	{
+		const uint8_t* source = ArraySize > 1 ? static_cast<const uint8_t*>(ArrayBlock) : Value;
+		if (source == nullptr) {
+			return;
+		}
+
+		const ShaderDataTypecode typeCode = GetShaderDataTypeCode(Type);
+		const uint32_t elementSize = ShaderDataTypeSize(Type);
+		const size_t count = ArraySize > 1 ? ArraySize : 1;
+
+		for (size_t ix = 0; ix < count; ix++) {
+			const uint8_t* element = source + ix * elementSize;
+			uint8_t* target = block + BlockOffset + ix * ArrayStride;
+
+			switch (typeCode) {
+				// GLSL bools are 32 bits in a block, where ours are 8
+				case ShaderDataTypecode::Bool:
+					for (uint32_t component = 0; component < ShaderDataTypeComponentCount(Type); component++) {
+						uint32_t value = element[component] ? 1 : 0;
+						memcpy(target + component * sizeof(uint32_t), &value, sizeof(uint32_t));
+					}
+					break;
+				// std140 pads every column out to a vec4, so we copy them one at a time
+				case ShaderDataTypecode::Matrix:
+				case ShaderDataTypecode::MatrixD: {
+					const uint32_t rows = (uint32_t)Type & ShaderDataType_Size1Mask;
+					const uint32_t columns = ((uint32_t)Type & ShaderDataType_Size2Mask) >> 3;
+					const uint32_t columnSize = rows * (typeCode == ShaderDataTypecode::Matrix ? sizeof(float) : sizeof(double));
+					for (uint32_t column = 0; column < columns; column++) {
+						memcpy(target + column * MatrixStride, element + column * columnSize, columnSize);
+					}
+					break;
+				}
+				default:
+					memcpy(target, element, elementSize);
+					break;
+			}
+		}
+	}
+
 	Material::UniformData::~UniformData()
 	{
 		// Explicitly release the texture asset handle, since it's in a union
@@ -1,12 +1,19 @@
 #pragma once
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/ITexture.h"
+#include "Graphics/Buffers/MaterialBuffer.h"
 
 namespace Gameplay {
 	/// <summary>
 	/// Helper structure for material parameters to our shader
 	/// THIS IS VERY TEMPORARY
+	/// 
+	/// Parameters that the shader declares in it's b_Material uniform block are packed into a slot of a
+	/// MaterialBuffer shared by all materials, and are only re-uploaded when they change. Textures, and
+	/// parameters declared as plain uniforms, are still sent to the shader every time the material is applied
 	/// </summary>
 	class Material : public IResource {
 	public:
@@ -33,6 +40,7 @@ namespace Gameplay {
 		/// </summary>
 		/// <param name="shader">The shader for the material</param>
 		Material(const ShaderProgram::Sptr& shader);
+		virtual ~Material();
 
 		/// <summary>
 		/// Sets a material parameter with the given name and type
@@ -45,6 +53,15 @@ namespace Gameplay {
 			ShaderDataType type = GetShaderDataType<T>();
 			Set(name, type, &value, 1);
 		}
+		/// <summary>
+		/// Sets a material parameter by it's interned name, this skips hashing the name and is preferred
+		/// for parameters that are updated often
+		/// </summary>
+		template <typename T>
+		void Set(UniformId id, const T& value) {
+			ShaderDataType type = GetShaderDataType<T>();
+			Set(id, type, &value, 1);
+		}
 
 		/// <summary>
 		/// Sets a material parameter with the given name and type
@@ -54,23 +71,54 @@ namespace Gameplay {
 		/// <param name="value">A raw pointer to the underlying data to set the parameter to</param>
 		/// <param name="arraySize">The array size in the event that the value is an array</param>
 		void Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize = 1ul);
+		void Set(UniformId id, ShaderDataType type, const void* value, size_t arraySize = 1ul);
 
 		/// <summary>
 		/// Gets the shader that this material is using
 		/// </summary>
 		const ShaderProgram::Sptr& GetShader() const;
 
+		/// <summary>
+		/// Enables or disables a shader keyword for everything drawn with this material, see ShaderProgram::GetVariant
+		/// </summary>
+		/// <param name="keyword">The name of the keyword, as declared with #pragma keyword</param>
+		/// <param name="enabled">True to define the keyword, false to leave it out</param>
+		void SetKeyword(const std::string& keyword, bool enabled);
+		/// <summary>
+		/// Gets the mask of keywords that this material enables
+		/// </summary>
+		uint32_t GetKeywords() const { return _keywords; }
+
 		/// <summary>
 		/// Handles applying this material's state to the OpenGL pipeline
 		/// Will bind the shader, update material uniforms, and bind textures
 		/// </summary>
 		virtual void Apply();
+		/// <summary>
+		/// Applies this material's uniforms and textures to a variant of it's shader. Uniform locations can
+		/// differ between variants, so they are looked up once per variant and cached
+		/// </summary>
+		/// <param name="program">The program to apply to, normally a variant of GetShader()</param>
+		virtual void Apply(ShaderProgram* program);
 
 		/// <summary>
 		/// Renders some UI controls for manipulating a material at runtime
 		/// </summary>
 		void RenderImGui();
 
+		/// <summary>
+		/// Gets this material's slot in the parameter buffer, allocating it and uploading our block if needed.
+		/// The block starts at slot * GetParameterBuffer()->GetSlotSize() bytes, so instanced and indirect draws
+		/// can find the parameters of each object's material
+		/// </summary>
+		/// <returns>The slot, or MaterialBuffer::NO_SLOT if our shader has no material block</returns>
+		uint32_t GetParameterSlot();
+
+		/// <summary>
+		/// Gets the buffer that holds the parameter blocks of all materials, or nullptr if no material has been applied yet
+		/// </summary>
+		static const MaterialBuffer::Sptr& GetParameterBuffer();
+
 		/// <summary>
 		/// Creates a clone of this material, useful for cases where you have many similar 
 		/// materials with slight variations
@@ -93,6 +141,8 @@ namespace Gameplay {
 		struct UniformData {
 			// The name of the uniform in the shader
 			std::string    Name;
+			// The interned name, which is what we sort and search by
+			UniformId      Id;
 			// Location of the uniform within the shader
 			int            Location = -2;
 			union {
@@ -108,6 +158,10 @@ namespace Gameplay {
 			// The size of the array, in elements
 			size_t         ArraySize;
 			int            BindingSlot;
+			// For parameters in the material block, where they go in the block, -1 for plain uniforms
+			int            BlockOffset = -1;
+			int            ArrayStride = 0;
+			int            MatrixStride = 0;
 
 			// The type of uniform
 			ShaderDataType Type = ShaderDataType::None;
@@ -164,6 +218,23 @@ namespace Gameplay {
 			inline bool IsTextureResource() const {
 				return GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture;
 			}
+
+			/// <summary>
+			/// Returns true if the uniform lives in the shader's material block rather than being a plain uniform
+			/// </summary>
+			inline bool IsInBlock() const {
+				return BlockOffset >= 0;
+			}
+
+			/// <summary>
+			/// Writes this uniform into a std140 block at it's offset, expanding bools to 32 bits and
+			/// padding out matrix columns and array elements to their strides
+			/// </summary>
+			void Pack(uint8_t* block) const;
+			/// <summary>
+			/// Fills in a non-array value from a "#pragma default" declaration, see ShaderProgram::GetUniformDefault
+			/// </summary>
+			void SetDefault(const std::vector<double>& values);
 		};
 	
 		/// <summary>
@@ -171,11 +242,38 @@ namespace Gameplay {
 		/// </summary>
 		ShaderProgram::Sptr    _shader;
 		/// <summary>
-		/// The uniforms that the material will be modifying
+		/// The uniforms that the material will be modifying, sorted by ID so that Apply can walk them
+		/// in order and lookups can binary search them
+		/// </summary>
+		std::vector<UniformData> _uniforms;
+		/// <summary>
+		/// The shader keywords that this material enables
 		/// </summary>
-		std::unordered_map<std::string, UniformData> _uniforms;
+		uint32_t _keywords;
+
+		// The size of the shader's material block, or 0 if it doesn't have one
+		uint32_t _blockSize;
+		// Our slot in the parameter buffer, allocated the first time we're applied
+		uint32_t _blockSlot;
+		// True if a parameter in the block has changed since we last uploaded it
+		bool     _blockDirty;
+
+		// The location of each of our uniforms in the variants of our shader we've been applied to, in the
+		// same order as _uniforms. Built the first time we're applied to a variant
+		std::unordered_map<const ShaderProgram*, std::vector<int>> _variantLocations;
+
+		static MaterialBuffer::Sptr __parameterBuffer;
 
+		// Gets the uniform with the given name, adding it if it hasn't been seen yet
 		UniformData& _GetUniform(const std::string& name);
+		// Gets the uniform with the given ID, or nullptr if the material doesn't have it
+		UniformData* _FindUniform(UniformId id);
+		// Copies a value into a uniform, checking that the types match
+		void _SetValue(UniformData& uniform, ShaderDataType type, const void* value, size_t arraySize);
+		// Packs and uploads our block if anything has changed, allocating our slot if needed
+		void _UpdateBlock();
+		// Gets the location of each of our uniforms in a variant of our shader, building the table if needed
+		const std::vector<int>& _GetVariantLocations(const ShaderProgram* program);
 		void _PopulateUniforms();
 	};
 }
\ No newline at end of file
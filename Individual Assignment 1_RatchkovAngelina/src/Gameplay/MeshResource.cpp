@@ -2,6 +2,7 @@
 #include <filesystem>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
 
 namespace Gameplay {
 	MeshResource::MeshResource() :
@@ -9,6 +10,7 @@ namespace Gameplay {
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
+		LocalBounds(),
 		BulletTriMesh(nullptr)
 	{ }
 
@@ -17,9 +19,11 @@ namespace Gameplay {
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
+		LocalBounds(),
 		BulletTriMesh(nullptr)
 	{
 		Mesh = ObjLoader::LoadFromFile(filename);
+		CacheBounds();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -46,12 +50,11 @@ namespace Gameplay {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
 			MeshBuilder<VertexPosNormTexColTangents> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
-			MeshFactory::CalculateTBN(mesh);
+			std::vector<MeshLod> lods = MeshFactory::AddParameterizedWithLods(mesh, result->MeshBuilderParams);
 			result->Mesh = mesh.Bake();
+			result->Mesh->SetLods(lods);
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
 			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
@@ -63,19 +66,71 @@ namespace Gameplay {
 
 			}
 		}
+		result->CacheBounds();
 		return result;
 	}
 
+	std::function<MeshResource::Sptr()> MeshResource::Decode(const nlohmann::json& blob)
+	{
+		// Generated meshes are built here, so only the bake is left for the main thread
+		if (blob.contains("params") && blob["params"].is_array()) {
+			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
+			std::vector<MeshBuilderParam> params;
+			std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>> mesh = std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>();
+			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
+				params.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
+			}
+			std::vector<MeshLod> lods = MeshFactory::AddParameterizedWithLods(*mesh, params);
+
+			return [params, mesh, lods]() {
+				MeshResource::Sptr result = std::make_shared<MeshResource>();
+				result->MeshBuilderParams = params;
+				result->Mesh = mesh->Bake();
+				result->Mesh->SetLods(lods);
+				result->CacheBounds();
+				return result;
+			};
+		}
+
+		std::string filename = JsonGet<std::string>(blob, "filename", "null");
+		bool exists = filename != "null" && std::filesystem::exists(filename);
+
+		#ifdef OPTIMIZED_OBJ_LOADER
+		std::shared_ptr<OptimizedObjLoader::MeshData> data = std::make_shared<OptimizedObjLoader::MeshData>();
+		bool loaded = exists && OptimizedObjLoader::LoadMeshData(filename, *data);
+		return [filename, data, loaded]() {
+			MeshResource::Sptr result = std::make_shared<MeshResource>();
+			result->Filename = filename;
+			result->Mesh = loaded ? OptimizedObjLoader::CreateVao(*data) : nullptr;
+			result->CacheBounds();
+			return result;
+		};
+		#else
+		std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>> mesh = exists ? 
+			std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>(ObjLoader::LoadMeshData(filename)) : nullptr;
+		return [filename, mesh]() {
+			MeshResource::Sptr result = std::make_shared<MeshResource>();
+			result->Filename = filename;
+			result->Mesh = mesh != nullptr ? mesh->Bake() : nullptr;
+			result->CacheBounds();
+			return result;
+		};
+		#endif
+	}
+
 	void MeshResource::GenerateMesh() {
 		MeshBuilder<VertexPosNormTexColTangents> mesh;
-		for (auto& param : MeshBuilderParams) {
-			MeshFactory::AddParameterized(mesh, param);
-		}
-		MeshFactory::CalculateTBN(mesh);
+		std::vector<MeshLod> lods = MeshFactory::AddParameterizedWithLods(mesh, MeshBuilderParams);
 		Mesh = mesh.Bake();
+		Mesh->SetLods(lods);
+		CacheBounds();
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	void MeshResource::CacheBounds() {
+		LocalBounds = Mesh != nullptr ? Mesh->GetBounds() : Bounds();
+	}
 }
\ No newline at end of file
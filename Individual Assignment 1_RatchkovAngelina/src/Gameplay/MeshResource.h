@@ -1,7 +1,9 @@
 #pragma once
+#include <functional>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
+#include "Utils/Bounds.h"
 
 // bullet triangle mesh pre-declaration
 class btTriangleMesh;
@@ -40,7 +42,10 @@ namespace Gameplay {
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
-
+		/// <summary>
+		/// The bounding box of the mesh in model space, cached whenever the mesh is loaded or generated
+		/// </summary>
+		Bounds                          LocalBounds;
 
 		/// <summary>
 		/// The optional mesh resource for generating colliders from this mesh
@@ -61,9 +66,20 @@ namespace Gameplay {
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Updates LocalBounds from the current mesh, should be called whenever Mesh is replaced
+		/// </summary>
+		void CacheBounds();
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+		/// <summary>
+		/// Parses or generates the mesh for a resource from it's JSON blob, and returns a function that
+		/// will upload it to OpenGL. Parsing can happen on any thread, but the returned function must be
+		/// invoked on the main thread
+		/// </summary>
+		static std::function<MeshResource::Sptr()> Decode(const nlohmann::json& blob);
 	};
 }
\ No newline at end of file
@@ -13,11 +13,18 @@
 #include "Gameplay/Material.h"
 
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlState.h"
 #include "Graphics/Textures/TextureCube.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Application/Application.h"
 
 namespace Gameplay {
+	namespace {
+		// The skybox uniforms, set every frame
+		constexpr UniformId CLIPPED_VIEW_UNIFORM("u_ClippedView");
+		constexpr UniformId ENVIRONMENT_ROTATION_UNIFORM("u_EnvironmentRotation");
+	}
+
 	Scene::Scene() :
 		_objects(std::vector<GameObject::Sptr>()),
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
@@ -31,7 +38,8 @@ namespace Gameplay {
 		_skyboxMesh(nullptr),
 		_skyboxTexture(nullptr),
 		_skyboxRotation(glm::mat3(1.0f)),
-		_gravity(glm::vec3(0.0f, 0.0f, -9.81f))
+		_gravity(glm::vec3(0.0f, 0.0f, -9.81f)),
+		_transforms(std::make_shared<TransformSystem>())
 	{
 		_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>();
 		_lightingUbo->GetData().AmbientCol = glm::vec3(0.1f);
@@ -100,11 +108,11 @@ namespace Gameplay {
 
 	GameObject::Sptr Scene::CreateGameObject(const std::string& name)
 	{
-		GameObject::Sptr result(new GameObject());
+		GameObject::Sptr result(new GameObject(this));
 		result->Name = name;
-		result->_scene = this;
 		result->_selfRef = result;
 		_objects.push_back(result);
+		_IndexObject(result.get());
 		return result;
 	}
 
@@ -113,17 +121,13 @@ namespace Gameplay {
 	}
 
 	GameObject::Sptr Scene::FindObjectByName(const std::string name) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->Name == name;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		auto it = _objectsByName.find(name);
+		return it == _objectsByName.end() ? nullptr : it->second.front()->SelfRef();
 	}
 
 	GameObject::Sptr Scene::FindObjectByGUID(Guid id) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->_guid == id;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		auto it = _objectsByGuid.find(id);
+		return it == _objectsByGuid.end() ? nullptr : it->second->SelfRef();
 	}
 
 	void Scene::SetAmbientLight(const glm::vec3& value) {
@@ -162,10 +166,10 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
-		_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+		_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody* body) {
 			body->PhysicsPreStep(dt);
 		});
-		_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
+		_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume* body) {
 			body->PhysicsPreStep(dt);
 		});
 
@@ -173,10 +177,10 @@ namespace Gameplay {
 
 			_physicsWorld->stepSimulation(dt, 1);
 
-			_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+			_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody* body) {
 				body->PhysicsPostStep(dt);
 			});
-			_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
+			_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume* body) {
 				body->PhysicsPostStep(dt);
 			});
 		}
@@ -192,14 +196,17 @@ namespace Gameplay {
 	void Scene::Update(float dt) {
 		_FlushDeleteQueue();
 		if (IsPlaying) {
+			_scheduler.Update(_components, *_transforms, Application::Get().GetJobSystem(), dt);
 			for (auto& obj : _objects) {
-				obj->Update(dt);
+				obj->_PurgeDeletedChildren();
 			}
 		}
 		_FlushDeleteQueue();
 	}
 
 	void Scene::PreRender() {
+		// Bring all the world transforms up to date in one pass before anything reads them
+		_transforms->UpdateAll(&Application::Get().GetJobSystem());
 		_lightingUbo->Bind(LIGHT_UBO_BINDING);
 	}
 
@@ -255,6 +262,8 @@ namespace Gameplay {
 		Scene::Sptr result = std::make_shared<Scene>();
 		result->MainCamera = nullptr;
 		result->_objects.clear();
+		result->_objectsByGuid.clear();
+		result->_objectsByName.clear();
 		result->DefaultMaterial = ResourceManager::Get<Material>(Guid(data["default_material"]));
 
 		if (data.contains("ambient")) {
@@ -277,6 +286,7 @@ namespace Gameplay {
 			obj->_parent.SceneContext = result.get();
 			obj->_selfRef = obj;
 			result->_objects.push_back(obj);
+			result->_IndexObject(obj.get());
 		}
 
 		// Re-build the parent hierarchy 
@@ -394,12 +404,50 @@ namespace Gameplay {
 			if (weakPtr.expired()) continue;
 			auto& it = std::find(_objects.begin(), _objects.end(), weakPtr.lock());
 			if (it != _objects.end()) {
+				_UnindexObject(it->get());
 				_objects.erase(it);
 			}
 		}
 		_deletionQueue.clear();
 	}
 
+	void Scene::_IndexObject(GameObject* object) {
+		_objectsByGuid[object->_guid] = object;
+		_objectsByName[object->Name].push_back(object);
+	}
+
+	void Scene::_UnindexObject(GameObject* object) {
+		auto guidIt = _objectsByGuid.find(object->_guid);
+		if (guidIt != _objectsByGuid.end() && guidIt->second == object) {
+			_objectsByGuid.erase(guidIt);
+		}
+		_RemoveNameIndex(object, object->Name);
+	}
+
+	void Scene::_RemoveNameIndex(GameObject* object, const std::string& name) {
+		auto nameIt = _objectsByName.find(name);
+		if (nameIt != _objectsByName.end()) {
+			std::vector<GameObject*>& bucket = nameIt->second;
+			auto it = std::find(bucket.begin(), bucket.end(), object);
+			if (it != bucket.end()) {
+				bucket.erase(it);
+			}
+			if (bucket.empty()) {
+				_objectsByName.erase(nameIt);
+			}
+		}
+	}
+
+	void Scene::_OnObjectRenamed(GameObject* object, const std::string& oldName) {
+		// Objects that are still being loaded will be indexed once they are added to the scene
+		auto guidIt = _objectsByGuid.find(object->_guid);
+		if (guidIt == _objectsByGuid.end() || guidIt->second != object) {
+			return;
+		}
+		_RemoveNameIndex(object, oldName);
+		_objectsByName[object->Name].push_back(object);
+	}
+
 	void Scene::DrawAllGameObjectGUIs()
 	{
 		for (auto& object : _objects) {
@@ -423,19 +471,21 @@ namespace Gameplay {
 			_skyboxTexture != nullptr &&
 			MainCamera != nullptr) {
 			
-			glDepthMask(false);
-			glDisable(GL_CULL_FACE);
-			glDepthFunc(GL_LEQUAL); 
-
-			_skyboxShader->Bind();
-			_skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
-			_skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation);
+			GlState::DepthMask(false);
+			GlState::Disable(GL_CULL_FACE);
+			GlState::DepthFunc(GL_LEQUAL);
+
+			// Use the same keywords as the rest of the frame, in case the skybox is color corrected
+			ShaderProgram* shader = _skyboxShader->GetVariant(ShaderProgram::GetGlobalKeywords());
+			shader->Bind();
+			shader->SetUniformMatrix(CLIPPED_VIEW_UNIFORM, MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
+			shader->SetUniformMatrix(ENVIRONMENT_ROTATION_UNIFORM, _skyboxRotation);
 			_skyboxTexture->Bind(0);
 			_skyboxMesh->Mesh->Draw();
 
-			glDepthFunc(GL_LESS);
-			glEnable(GL_CULL_FACE);
-			glDepthMask(true);
+			GlState::DepthFunc(GL_LESS);
+			GlState::Enable(GL_CULL_FACE);
+			GlState::DepthMask(true);
 
 		}
 	}
@@ -5,6 +5,7 @@
 #include "Gameplay/Components/Camera.h"
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Light.h"
+#include "Gameplay/UpdateScheduler.h"
 
 #include "Physics/BulletDebugDraw.h"
 
@@ -241,6 +242,13 @@ namespace Gameplay {
 
 		// Stores all the objects in our scene
 		std::vector<GameObject::Sptr>  _objects;
+		// Lookup tables for finding objects, kept in sync when objects are added, removed or renamed
+		std::unordered_map<Guid, GameObject*> _objectsByGuid;
+		std::unordered_map<std::string, std::vector<GameObject*>> _objectsByName;
+		// Stores the transforms for all of our objects, sorted by hierarchy depth
+		TransformSystem::Sptr _transforms;
+		// Decides which components can be updated in parallel, and runs their updates
+		UpdateScheduler       _scheduler;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
 
 		// Info for rendering our skybox will be stored in the scene itself
@@ -295,5 +303,11 @@ namespace Gameplay {
 		void _CleanupPhysics();
 
 		void _FlushDeleteQueue();
+
+		// Helpers for maintaining the object lookup tables
+		void _IndexObject(GameObject* object);
+		void _UnindexObject(GameObject* object);
+		void _RemoveNameIndex(GameObject* object, const std::string& name);
+		void _OnObjectRenamed(GameObject* object, const std::string& oldName);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,363 @@
+#include "TransformSystem.h"
+
+#include <algorithm>
+#include <type_traits>
+#include "GLM/gtc/matrix_transform.hpp"
+
+#include "Utils/GlmDefines.h"
+#include "Utils/JobSystem.h"
+
+namespace Gameplay {
+	TransformSystem::TransformSystem() :
+		_sparse(),
+		_freeHandles(),
+		_handles(),
+		_levelStarts(1, 0),
+		_isOrderDirty(false),
+		_hasDirty(false)
+	{ }
+
+	TransformSystem::~TransformSystem() = default;
+
+	TransformSystem::Handle TransformSystem::Create()
+	{
+		// Re-use a released handle if we can, otherwise grow the sparse table
+		Handle handle;
+		if (!_freeHandles.empty()) {
+			handle = _freeHandles.back();
+			_freeHandles.pop_back();
+		} else {
+			handle = static_cast<Handle>(_sparse.size());
+			_sparse.push_back(InvalidHandle);
+		}
+
+		_sparse[handle] = static_cast<uint32_t>(_handles.size());
+		_handles.push_back(handle);
+		_positions.push_back(ZERO_3);
+		_rotations.push_back(glm::quat(glm::vec3(0.0f)));
+		_scales.push_back(ONE_3);
+		_localTransforms.push_back(MAT4_IDENTITY);
+		_inverseLocalTransforms.push_back(MAT4_IDENTITY);
+		_worldTransforms.push_back(MAT4_IDENTITY);
+		_inverseWorldTransforms.push_back(MAT4_IDENTITY);
+		_worldVersions.push_back(0);
+		_flags.push_back(LocalDirty | WorldDirty);
+		_parents.push_back(InvalidHandle);
+		_firstChildren.push_back(InvalidHandle);
+		_nextSiblings.push_back(InvalidHandle);
+		_depths.push_back(0);
+
+		_isOrderDirty = true;
+		_hasDirty = true;
+		return handle;
+	}
+
+	void TransformSystem::Destroy(Handle handle)
+	{
+		const uint32_t index = _sparse[handle];
+		_Unlink(index);
+
+		// Any children we have become roots
+		Handle child = _firstChildren[index];
+		while (child != InvalidHandle) {
+			const uint32_t childIx = _sparse[child];
+			child = _nextSiblings[childIx];
+			_parents[childIx] = InvalidHandle;
+			_nextSiblings[childIx] = InvalidHandle;
+			_flags[childIx] |= WorldDirty;
+		}
+
+		// Swap the last node into our slot, and pop the back off all the arrays
+		const uint32_t last = static_cast<uint32_t>(_handles.size() - 1);
+		_ForEachArray([&](auto& arr) {
+			if (index != last) {
+				arr[index] = arr[last];
+			}
+			arr.pop_back();
+		});
+		if (index != last) {
+			_sparse[_handles[index]] = index;
+		}
+
+		_sparse[handle] = InvalidHandle;
+		_freeHandles.push_back(handle);
+
+		_isOrderDirty = true;
+		_hasDirty = true;
+	}
+
+	void TransformSystem::SetParent(Handle handle, Handle parent)
+	{
+		const uint32_t index = _sparse[handle];
+		if (_parents[index] == parent) {
+			return;
+		}
+
+		_Unlink(index);
+
+		// Push to the front of the parent's list of children
+		if (parent != InvalidHandle) {
+			const uint32_t parentIx = _sparse[parent];
+			_parents[index] = parent;
+			_nextSiblings[index] = _firstChildren[parentIx];
+			_firstChildren[parentIx] = handle;
+		}
+
+		_flags[index] |= WorldDirty;
+		_isOrderDirty = true;
+		_hasDirty = true;
+	}
+
+	TransformSystem::Handle TransformSystem::GetParent(Handle handle) const {
+		return _parents[_sparse[handle]];
+	}
+
+	void TransformSystem::SetPosition(Handle handle, const glm::vec3& value) {
+		const uint32_t index = _sparse[handle];
+		_positions[index] = value;
+		_MarkLocalDirty(index);
+	}
+
+	const glm::vec3& TransformSystem::GetPosition(Handle handle) const {
+		return _positions[_sparse[handle]];
+	}
+
+	void TransformSystem::SetRotation(Handle handle, const glm::quat& value) {
+		const uint32_t index = _sparse[handle];
+		_rotations[index] = value;
+		_MarkLocalDirty(index);
+	}
+
+	const glm::quat& TransformSystem::GetRotation(Handle handle) const {
+		return _rotations[_sparse[handle]];
+	}
+
+	void TransformSystem::SetScale(Handle handle, const glm::vec3& value) {
+		const uint32_t index = _sparse[handle];
+		_scales[index] = value;
+		_MarkLocalDirty(index);
+	}
+
+	const glm::vec3& TransformSystem::GetScale(Handle handle) const {
+		return _scales[_sparse[handle]];
+	}
+
+	const glm::mat4& TransformSystem::GetLocalTransform(Handle handle) {
+		const uint32_t index = _sparse[handle];
+		_RecalcLocal(index);
+		return _localTransforms[index];
+	}
+
+	const glm::mat4& TransformSystem::GetInverseLocalTransform(Handle handle) {
+		const uint32_t index = _sparse[handle];
+		_RecalcLocal(index);
+		return _inverseLocalTransforms[index];
+	}
+
+	const glm::mat4& TransformSystem::GetWorldTransform(Handle handle) {
+		const uint32_t index = _sparse[handle];
+		if (_hasDirty) {
+			_ResolveWorld(index);
+		}
+		return _worldTransforms[index];
+	}
+
+	const glm::mat4& TransformSystem::GetInverseWorldTransform(Handle handle) {
+		const uint32_t index = _sparse[handle];
+		if (_hasDirty) {
+			_ResolveWorld(index);
+		}
+		return _inverseWorldTransforms[index];
+	}
+
+	uint32_t TransformSystem::GetWorldVersion(Handle handle) {
+		const uint32_t index = _sparse[handle];
+		if (_hasDirty) {
+			_ResolveWorld(index);
+		}
+		return _worldVersions[index];
+	}
+
+	void TransformSystem::UpdateAll(JobSystem* jobs)
+	{
+		if (_isOrderDirty) {
+			_RebuildOrder();
+		}
+		if (!_hasDirty) {
+			return;
+		}
+
+		// Each level only reads from the level above it, and every node only writes to it's own
+		// slot, so the nodes within a level can be split up between threads
+		for (size_t level = 0; level + 1 < _levelStarts.size(); level++) {
+			const uint32_t begin = _levelStarts[level];
+			const uint32_t end = _levelStarts[level + 1];
+			if (jobs == nullptr || end - begin <= UPDATE_BATCH_SIZE) {
+				_UpdateRange(begin, end);
+				continue;
+			}
+
+			// ParallelFor waits for every batch, so the next level sees all of this one's results
+			const uint32_t batches = (end - begin + UPDATE_BATCH_SIZE - 1) / UPDATE_BATCH_SIZE;
+			jobs->ParallelFor(batches, 1, [this, begin, end](uint32_t batch) {
+				const uint32_t start = begin + batch * UPDATE_BATCH_SIZE;
+				_UpdateRange(start, std::min(start + UPDATE_BATCH_SIZE, end));
+			});
+		}
+
+		_hasDirty = false;
+	}
+
+	void TransformSystem::_MarkLocalDirty(uint32_t index) {
+		_flags[index] |= LocalDirty;
+		_hasDirty = true;
+	}
+
+	void TransformSystem::_MarkChildrenDirty(uint32_t index) {
+		for (Handle child = _firstChildren[index]; child != InvalidHandle; child = _nextSiblings[_sparse[child]]) {
+			_flags[_sparse[child]] |= WorldDirty;
+		}
+	}
+
+	void TransformSystem::_Unlink(uint32_t index)
+	{
+		const Handle parent = _parents[index];
+		if (parent == InvalidHandle) {
+			return;
+		}
+
+		// Find whatever points to us in the parent's child list, and point it past us
+		const uint32_t parentIx = _sparse[parent];
+		const Handle self = _handles[index];
+		if (_firstChildren[parentIx] == self) {
+			_firstChildren[parentIx] = _nextSiblings[index];
+		} else {
+			Handle prev = _firstChildren[parentIx];
+			while (prev != InvalidHandle) {
+				const uint32_t prevIx = _sparse[prev];
+				if (_nextSiblings[prevIx] == self) {
+					_nextSiblings[prevIx] = _nextSiblings[index];
+					break;
+				}
+				prev = _nextSiblings[prevIx];
+			}
+		}
+
+		_parents[index] = InvalidHandle;
+		_nextSiblings[index] = InvalidHandle;
+	}
+
+	void TransformSystem::_RecalcLocal(uint32_t index)
+	{
+		if (_flags[index] & LocalDirty) {
+			glm::mat4& local = _localTransforms[index];
+			local = glm::translate(MAT4_IDENTITY, _positions[index]) * glm::mat4_cast(_rotations[index]) * glm::scale(MAT4_IDENTITY, _scales[index]);
+			_inverseLocalTransforms[index] = glm::inverse(local);
+			_flags[index] = (_flags[index] & ~LocalDirty) | WorldDirty;
+		}
+	}
+
+	void TransformSystem::_RecalcWorld(uint32_t index, const glm::mat4* parentWorld)
+	{
+		// With a parent, we apply our local transformation relative to the parent's world transformation,
+		// otherwise we can simply use the local transform as the world transform
+		if (parentWorld != nullptr) {
+			_worldTransforms[index] = *parentWorld * _localTransforms[index];
+			_inverseWorldTransforms[index] = glm::inverse(_worldTransforms[index]);
+		} else {
+			_worldTransforms[index] = _localTransforms[index];
+			_inverseWorldTransforms[index] = _inverseLocalTransforms[index];
+		}
+		_flags[index] &= ~WorldDirty;
+		_worldVersions[index]++;
+	}
+
+	void TransformSystem::_ResolveWorld(uint32_t index)
+	{
+		// Make sure the parent chain is up to date first, this will dirty us if the parent changed
+		const Handle parent = _parents[index];
+		const uint32_t parentIx = parent == InvalidHandle ? InvalidHandle : _sparse[parent];
+		if (parentIx != InvalidHandle) {
+			_ResolveWorld(parentIx);
+		}
+
+		_RecalcLocal(index);
+		if (_flags[index] & WorldDirty) {
+			_RecalcWorld(index, parentIx != InvalidHandle ? &_worldTransforms[parentIx] : nullptr);
+			_MarkChildrenDirty(index);
+		}
+	}
+
+	void TransformSystem::_UpdateRange(uint32_t begin, uint32_t end)
+	{
+		for (uint32_t ix = begin; ix < end; ix++) {
+			_RecalcLocal(ix);
+
+			const Handle parent = _parents[ix];
+			const uint32_t parentIx = parent == InvalidHandle ? InvalidHandle : _sparse[parent];
+			if (parentIx != InvalidHandle && (_flags[parentIx] & Changed)) {
+				_flags[ix] |= WorldDirty;
+			}
+
+			if (_flags[ix] & WorldDirty) {
+				_RecalcWorld(ix, parentIx != InvalidHandle ? &_worldTransforms[parentIx] : nullptr);
+				_flags[ix] |= Changed;
+			} else {
+				_flags[ix] &= ~Changed;
+			}
+		}
+	}
+
+	void TransformSystem::_RebuildOrder()
+	{
+		const uint32_t count = static_cast<uint32_t>(_handles.size());
+
+		// Determine the depth of every node, walking up until we find a parent we already know the depth of
+		std::fill(_depths.begin(), _depths.end(), InvalidHandle);
+		uint32_t maxDepth = 0;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			uint32_t steps = 0;
+			uint32_t depth = InvalidHandle;
+			for (Handle parent = _parents[ix]; parent != InvalidHandle; ) {
+				const uint32_t parentIx = _sparse[parent];
+				steps++;
+				if (_depths[parentIx] != InvalidHandle) {
+					depth = _depths[parentIx] + steps;
+					break;
+				}
+				parent = _parents[parentIx];
+			}
+			_depths[ix] = depth == InvalidHandle ? steps : depth;
+			maxDepth = std::max(maxDepth, _depths[ix]);
+		}
+
+		// Counting sort by depth, which also gives us the start of each level
+		_levelStarts.assign(count > 0 ? maxDepth + 2 : 1, 0);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			_levelStarts[_depths[ix] + 1]++;
+		}
+		for (size_t level = 1; level < _levelStarts.size(); level++) {
+			_levelStarts[level] += _levelStarts[level - 1];
+		}
+
+		std::vector<uint32_t> order(count);
+		std::vector<uint32_t> cursors(_levelStarts.begin(), _levelStarts.end());
+		for (uint32_t ix = 0; ix < count; ix++) {
+			order[cursors[_depths[ix]]++] = ix;
+		}
+
+		// Apply the new order to all the dense arrays
+		_ForEachArray([&](auto& arr) {
+			std::remove_reference_t<decltype(arr)> sorted(arr.size());
+			for (uint32_t ix = 0; ix < count; ix++) {
+				sorted[ix] = arr[order[ix]];
+			}
+			arr.swap(sorted);
+		});
+		for (uint32_t ix = 0; ix < count; ix++) {
+			_sparse[_handles[ix]] = ix;
+		}
+
+		_isOrderDirty = false;
+	}
+}
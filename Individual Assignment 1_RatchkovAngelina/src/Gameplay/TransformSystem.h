@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <limits>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "Utils/Macros.h"
+
+class JobSystem;
+
+namespace Gameplay {
+	/// <summary>
+	/// Stores the transforms for all the game objects in a scene in flat arrays (one array
+	/// per field), ordered by the depth of each node in the hierarchy. Since parents always come
+	/// before their children, all dirty world matrices can be updated in a single linear pass,
+	/// and all the nodes at the same depth can be updated independently of each other
+	///
+	/// Nodes are referenced by handles, which stay valid while the dense arrays get re-ordered
+	/// </summary>
+	class TransformSystem final {
+	public:
+		MAKE_PTRS(TransformSystem);
+		NO_COPY(TransformSystem);
+		NO_MOVE(TransformSystem);
+
+		typedef uint32_t Handle;
+		static constexpr Handle InvalidHandle = std::numeric_limits<uint32_t>::max();
+		// The number of nodes each job updates, levels smaller than this are updated on the calling thread
+		static constexpr uint32_t UPDATE_BATCH_SIZE = 256;
+
+		TransformSystem();
+		~TransformSystem();
+
+		/// <summary>
+		/// Creates a new root node with an identity transform
+		/// </summary>
+		Handle Create();
+		/// <summary>
+		/// Releases a node, any children of the node will become root nodes
+		/// </summary>
+		void Destroy(Handle handle);
+
+		/// <summary>
+		/// Re-parents a node, pass InvalidHandle to make the node a root
+		/// </summary>
+		void SetParent(Handle handle, Handle parent);
+		Handle GetParent(Handle handle) const;
+
+		void SetPosition(Handle handle, const glm::vec3& value);
+		const glm::vec3& GetPosition(Handle handle) const;
+
+		void SetRotation(Handle handle, const glm::quat& value);
+		const glm::quat& GetRotation(Handle handle) const;
+
+		void SetScale(Handle handle, const glm::vec3& value);
+		const glm::vec3& GetScale(Handle handle) const;
+
+		/// <summary>
+		/// Gets the local transform of a node, recalculating it if needed
+		/// </summary>
+		const glm::mat4& GetLocalTransform(Handle handle);
+		const glm::mat4& GetInverseLocalTransform(Handle handle);
+
+		/// <summary>
+		/// Gets the world transform of a node. If the node or any of it's parents have been
+		/// modified since the last update, only the affected chain is recalculated
+		/// </summary>
+		const glm::mat4& GetWorldTransform(Handle handle);
+		const glm::mat4& GetInverseWorldTransform(Handle handle);
+
+		/// <summary>
+		/// Gets a counter that is incremented every time the world transform of the node changes,
+		/// useful for caching values that are derived from the world transform
+		/// </summary>
+		uint32_t GetWorldVersion(Handle handle);
+
+		/// <summary>
+		/// Updates all dirty local and world transforms, one depth level at a time. Should be invoked
+		/// once per frame before rendering
+		/// </summary>
+		/// <param name="jobs">If set, large levels are split into batches that are updated in parallel</param>
+		void UpdateAll(JobSystem* jobs = nullptr);
+
+		/// <summary>
+		/// Gets the number of live nodes in the system
+		/// </summary>
+		size_t Size() const { return _handles.size(); }
+		/// <summary>
+		/// Gets the number of depth levels in the hierarchy, as of the last update
+		/// </summary>
+		size_t LevelCount() const { return _levelStarts.empty() ? 0 : _levelStarts.size() - 1; }
+
+	private:
+		enum Flags : uint8_t {
+			LocalDirty = 1 << 0,
+			WorldDirty = 1 << 1,
+			// Set during UpdateAll if the world transform was recalculated, so children know to update
+			Changed    = 1 << 2
+		};
+
+		// Maps handles to indices in the dense arrays, InvalidHandle for free handles
+		std::vector<uint32_t> _sparse;
+		std::vector<Handle>   _freeHandles;
+
+		// Dense arrays, all indexed the same way and sorted by depth
+		std::vector<Handle>    _handles;
+		std::vector<glm::vec3> _positions;
+		std::vector<glm::quat> _rotations;
+		std::vector<glm::vec3> _scales;
+		std::vector<glm::mat4> _localTransforms;
+		std::vector<glm::mat4> _inverseLocalTransforms;
+		std::vector<glm::mat4> _worldTransforms;
+		std::vector<glm::mat4> _inverseWorldTransforms;
+		std::vector<uint32_t>  _worldVersions;
+		std::vector<uint8_t>   _flags;
+
+		// Hierarchy links, stored as handles so they survive re-ordering
+		std::vector<Handle>   _parents;
+		std::vector<Handle>   _firstChildren;
+		std::vector<Handle>   _nextSiblings;
+		std::vector<uint32_t> _depths;
+
+		// The first dense index of each depth level, with one extra entry marking the end
+		std::vector<uint32_t> _levelStarts;
+
+		// Set when nodes are added, removed or re-parented, and the arrays need to be re-sorted
+		bool _isOrderDirty;
+		// Set when any node is dirtied, lets us skip work when nothing has moved
+		bool _hasDirty;
+
+		void _MarkLocalDirty(uint32_t index);
+		void _MarkChildrenDirty(uint32_t index);
+		void _Unlink(uint32_t index);
+
+		void _RecalcLocal(uint32_t index);
+		void _RecalcWorld(uint32_t index, const glm::mat4* parentWorld);
+		void _ResolveWorld(uint32_t index);
+
+		void _UpdateRange(uint32_t begin, uint32_t end);
+		void _RebuildOrder();
+
+		/// <summary>
+		/// Invokes a callback on every dense array, so that they can be kept in lockstep
+		/// when nodes are removed or re-ordered
+		/// </summary>
+		template <typename Func>
+		void _ForEachArray(Func&& func) {
+			func(_handles);
+			func(_positions);
+			func(_rotations);
+			func(_scales);
+			func(_localTransforms);
+			func(_inverseLocalTransforms);
+			func(_worldTransforms);
+			func(_inverseWorldTransforms);
+			func(_worldVersions);
+			func(_flags);
+			func(_parents);
+			func(_firstChildren);
+			func(_nextSiblings);
+			func(_depths);
+		}
+	};
+}
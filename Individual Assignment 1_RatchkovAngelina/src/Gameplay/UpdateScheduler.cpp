@@ -0,0 +1,155 @@
+#include "UpdateScheduler.h"
+
+#include "Gameplay/GameObject.h"
+#include "Gameplay/TransformSystem.h"
+
+namespace Gameplay {
+	UpdateScheduler::UpdateScheduler() :
+		_serialTypes(),
+		_phases(),
+		_commandBuffers(),
+		_isDeferring(false)
+	{ }
+
+	UpdateScheduler::~UpdateScheduler() = default;
+
+	void UpdateScheduler::Update(ComponentManager& components, TransformSystem& transforms, JobSystem& jobs, float dt)
+	{
+		_BuildPhases(components);
+
+		// Types that haven't told us what they touch could do anything, so they get the main thread to themselves
+		for (const TypeUpdate& type : _serialTypes) {
+			for (size_t ix = 0; ix < type.Pool->Size(); ix++) {
+				IComponent* component = type.Pool->At(ix);
+				if (component->IsEnabled) {
+					component->Update(dt);
+				}
+			}
+		}
+
+		if (_phases.empty()) {
+			return;
+		}
+
+		_commandBuffers.resize(jobs.GetThreadCount());
+		for (const auto& phase : _phases) {
+			// Make sure all transforms are clean, so that reading them from multiple threads won't trigger a recalculation.
+			// This has to happen before every phase, since the previous sync point leaves the transforms it changed dirty
+			transforms.UpdateAll(&jobs);
+
+			_isDeferring = true;
+			_RunPhase(phase, jobs, dt);
+			_isDeferring = false;
+
+			// Sync point, apply all the transform changes from the phase
+			_ApplyCommands();
+		}
+	}
+
+	void UpdateScheduler::DeferPosition(GameObject* object, const glm::vec3& value) {
+		_Defer(object, TransformCommand::Position, glm::vec4(value, 0.0f));
+	}
+
+	void UpdateScheduler::DeferRotation(GameObject* object, const glm::quat& value) {
+		_Defer(object, TransformCommand::Rotation, glm::vec4(value.x, value.y, value.z, value.w));
+	}
+
+	void UpdateScheduler::DeferScale(GameObject* object, const glm::vec3& value) {
+		_Defer(object, TransformCommand::Scale, glm::vec4(value, 0.0f));
+	}
+
+	void UpdateScheduler::_BuildPhases(ComponentManager& components)
+	{
+		_serialTypes.clear();
+		_phases.clear();
+
+		// Transform writes are deferred and own state is private to each component, so
+		// neither can conflict with another type
+		const uint32_t privateWrites = *ComponentAccess::Transform | *ComponentAccess::OwnState;
+
+		components.EachPool([&](IComponentPool& pool, const ComponentManager::UpdateAccess& access) {
+			if (pool.Size() == 0) {
+				return;
+			}
+
+			if (!access.IsDeclared) {
+				_serialTypes.push_back({ &pool, 0, 0, 0 });
+				return;
+			}
+
+			TypeUpdate type;
+			type.Pool = &pool;
+			type.Reads = *access.Reads;
+			type.Writes = *access.Writes;
+			type.SharedWrites = type.Writes & ~privateWrites;
+
+			// Find the first phase that has no conflicts with this type
+			for (auto& phase : _phases) {
+				bool conflicts = false;
+				for (const TypeUpdate& other : phase) {
+					if ((type.SharedWrites & (other.Reads | other.Writes)) != 0 ||
+						(other.SharedWrites & (type.Reads | type.Writes)) != 0) {
+						conflicts = true;
+						break;
+					}
+				}
+				if (!conflicts) {
+					phase.push_back(type);
+					return;
+				}
+			}
+			_phases.push_back({ type });
+		});
+	}
+
+	void UpdateScheduler::_RunPhase(const std::vector<TypeUpdate>& phase, JobSystem& jobs, float dt)
+	{
+		JobCounter counter;
+		for (const TypeUpdate& type : phase) {
+			const uint32_t count = static_cast<uint32_t>(type.Pool->Size());
+			// Types that write to shared data could step on themselves, so they are updated in a single job
+			const uint32_t batchSize = type.SharedWrites == 0 ? BATCH_SIZE : count;
+
+			for (uint32_t start = 0; start < count; start += batchSize) {
+				const uint32_t end = std::min(start + batchSize, count);
+				IComponentPool* pool = type.Pool;
+				jobs.Submit([pool, start, end, dt]() {
+					for (uint32_t ix = start; ix < end; ix++) {
+						IComponent* component = pool->At(ix);
+						if (component->IsEnabled) {
+							component->Update(dt);
+						}
+					}
+				}, &counter);
+			}
+		}
+		jobs.Wait(counter);
+	}
+
+	void UpdateScheduler::_Defer(GameObject* object, TransformCommand::Field target, const glm::vec4& value) {
+		_commandBuffers[JobSystem::GetThreadIndex()].push_back({ object, target, value });
+	}
+
+	void UpdateScheduler::_ApplyCommands()
+	{
+		// Buffers are applied in thread order, and commands within a buffer in the order they were recorded
+		for (auto& buffer : _commandBuffers) {
+			for (const TransformCommand& command : buffer) {
+				switch (command.Target) {
+					case TransformCommand::Position:
+						command.Object->SetPostion(glm::vec3(command.Value));
+						break;
+					case TransformCommand::Rotation:
+						command.Object->SetRotation(glm::quat(command.Value.w, command.Value.x, command.Value.y, command.Value.z));
+						break;
+					case TransformCommand::Scale:
+						command.Object->SetScale(glm::vec3(command.Value));
+						break;
+					default:
+						break;
+				}
+			}
+			buffer.clear();
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "Gameplay/Components/ComponentManager.h"
+#include "Utils/JobSystem.h"
+
+namespace Gameplay {
+	class GameObject;
+	class TransformSystem;
+
+	/// <summary>
+	/// Runs the Update for all the components in a scene, using the access that each component type
+	/// declares (see DECLARE_UPDATE_ACCESS) to decide what can run in parallel:
+	///   - Types without a declaration are updated first, one at a time on the main thread
+	///   - Declared types are packed into phases, where no type in a phase writes to something
+	///     another type in that phase uses. All types in a phase are updated at the same time
+	///   - Types that only write their own state and transforms are also split across threads
+	///
+	/// Transform writes made during a phase are recorded into per-thread command buffers, and applied
+	/// once the phase is done, so every component in a phase sees the transforms from the start of it
+	/// </summary>
+	class UpdateScheduler final {
+	public:
+		NO_COPY(UpdateScheduler);
+		NO_MOVE(UpdateScheduler);
+
+		// The number of components of a single type that are updated in each job
+		static constexpr uint32_t BATCH_SIZE = 64;
+
+		UpdateScheduler();
+		~UpdateScheduler();
+
+		/// <summary>
+		/// Updates all enabled components
+		/// </summary>
+		/// <param name="components">The components to update</param>
+		/// <param name="transforms">The transforms for the scene, brought up to date before the parallel phases start</param>
+		/// <param name="jobs">The job system to run updates on</param>
+		/// <param name="dt">The time since the last frame, in seconds</param>
+		void Update(ComponentManager& components, TransformSystem& transforms, JobSystem& jobs, float dt);
+
+		/// <summary>
+		/// Returns true while components are being updated in parallel, at which point transform
+		/// changes should be sent to the scheduler instead of being applied
+		/// </summary>
+		bool IsDeferringWrites() const { return _isDeferring; }
+
+		void DeferPosition(GameObject* object, const glm::vec3& value);
+		void DeferRotation(GameObject* object, const glm::quat& value);
+		void DeferScale(GameObject* object, const glm::vec3& value);
+
+	private:
+		struct TransformCommand {
+			enum Field : uint8_t {
+				Position,
+				Rotation,
+				Scale
+			};
+
+			GameObject* Object;
+			Field       Target;
+			glm::vec4   Value;
+		};
+
+		struct TypeUpdate {
+			IComponentPool* Pool;
+			uint32_t        Reads;
+			uint32_t        Writes;
+			// Writes that happen immediately, and can conflict with other types
+			uint32_t        SharedWrites;
+		};
+
+		std::vector<TypeUpdate>              _serialTypes;
+		std::vector<std::vector<TypeUpdate>> _phases;
+
+		// One command buffer per job system thread, indexed by JobSystem::GetThreadIndex
+		std::vector<std::vector<TransformCommand>> _commandBuffers;
+		bool _isDeferring;
+
+		void _BuildPhases(ComponentManager& components);
+		void _RunPhase(const std::vector<TypeUpdate>& phase, JobSystem& jobs, float dt);
+		void _Defer(GameObject* object, TransformCommand::Field target, const glm::vec4& value);
+		void _ApplyCommands();
+	};
+}
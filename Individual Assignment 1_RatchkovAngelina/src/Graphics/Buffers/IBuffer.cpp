@@ -1,4 +1,5 @@
 #include "IBuffer.h"
+#include "Graphics/GlState.h"
 #include "Logging.h"
 
 IBuffer::IBuffer(BufferType type, BufferUsage usage) :
@@ -18,6 +19,7 @@ GlResourceType IBuffer::GetResourceClass() const {
 
 IBuffer::~IBuffer() {
 	if (_rendererId != 0) {
+		GlState::OnBufferDeleted(_rendererId);
 		glDeleteBuffers(1, &_rendererId);
 		_rendererId = 0;
 	}
@@ -68,18 +70,23 @@ void IBuffer::Unmap() {
 }
 
 void IBuffer::Bind() const {
-	glBindBuffer((GLenum)_type, _rendererId);
+	GlState::BindBuffer((GLenum)_type, _rendererId);
 }
 
 void IBuffer::Bind(uint32_t slot) const
 {
-	glBindBufferBase((GLenum)_type, slot, _rendererId);
+	GlState::BindBufferBase((GLenum)_type, slot, _rendererId);
+}
+
+void IBuffer::BindRange(uint32_t slot, uint32_t offset, uint32_t size) const
+{
+	GlState::BindBufferRange((GLenum)_type, slot, _rendererId, (GLintptr)offset, (GLsizeiptr)size);
 }
 
 void IBuffer::UnBind(BufferType type) {
-	glBindBuffer((GLenum)type, 0);
+	GlState::BindBuffer((GLenum)type, 0);
 }
 
 void IBuffer::UnBind(BufferType type, uint32_t slot) {
-	glBindBufferBase((GLenum)type, slot, 0);
+	GlState::BindBufferBase((GLenum)type, slot, 0);
 }
@@ -107,6 +107,14 @@ public:
 	/// <param name="slot">The buffer slot to bind to, for the vast majority of cases this should be 0</param>
 	virtual void Bind(uint32_t slot) const;
 	/// <summary>
+	/// Binds a sub-range of this buffer to an indexed slot, only valid for indexed buffer
+	/// types (uniform and shader storage buffers). Offset must respect the GL offset alignment for the type
+	/// </summary>
+	/// <param name="slot">The buffer slot to bind to</param>
+	/// <param name="offset">The offset in bytes from the start of the buffer</param>
+	/// <param name="size">The size in bytes of the range to bind</param>
+	void BindRange(uint32_t slot, uint32_t offset, uint32_t size) const;
+	/// <summary>
 	/// Unbinds the buffer bound to the slot given by type
 	/// </summary>
 	/// <param name="type">The type or slot of buffer to unbind (ex: GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)</param>
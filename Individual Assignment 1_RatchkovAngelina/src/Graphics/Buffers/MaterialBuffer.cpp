@@ -0,0 +1,77 @@
+#include "MaterialBuffer.h"
+#include <algorithm>
+#include "Graphics/GlState.h"
+#include "Logging.h"
+
+MaterialBuffer::MaterialBuffer(uint32_t slotSize, uint32_t initialSlots) :
+	IBuffer(BufferType::Uniform, BufferUsage::DynamicDraw),
+	_slotSize(0),
+	_capacity(0),
+	_nextSlot(0),
+	_freeSlots(),
+	_uploadCount(0)
+{
+	// Every slot has to start on an offset we can bind
+	GLint alignment = 1;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	const uint32_t align = static_cast<uint32_t>(std::max(alignment, 1));
+	_slotSize = ((std::max(slotSize, 1u) + align - 1) / align) * align;
+
+	_Grow(std::max(initialSlots, 1u));
+}
+
+uint32_t MaterialBuffer::Allocate()
+{
+	if (!_freeSlots.empty()) {
+		uint32_t slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		return slot;
+	}
+	if (_nextSlot >= _capacity) {
+		_Grow(_capacity * 2);
+	}
+	return _nextSlot++;
+}
+
+void MaterialBuffer::Release(uint32_t slot)
+{
+	if (slot < _nextSlot) {
+		_freeSlots.push_back(slot);
+	}
+}
+
+void MaterialBuffer::Upload(uint32_t slot, const void* data, uint32_t size)
+{
+	LOG_ASSERT(slot < _nextSlot, "Uploading to a material slot that was never allocated");
+	LOG_ASSERT(size <= _slotSize, "Material block does not fit in a slot");
+	glNamedBufferSubData(_rendererId, static_cast<GLintptr>(slot) * _slotSize, size, data);
+	_uploadCount++;
+}
+
+void MaterialBuffer::BindSlot(uint32_t slot, uint32_t size) const
+{
+	BindRange(BINDING, slot * _slotSize, size);
+}
+
+void MaterialBuffer::_Grow(uint32_t capacity)
+{
+	GLuint buffer = 0;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferData(buffer, static_cast<GLsizeiptr>(capacity) * _slotSize, nullptr, (GLenum)_usage);
+
+	// Slots keep their index when we grow, so materials don't need to know it happened
+	if (_nextSlot > 0) {
+		glCopyNamedBufferSubData(_rendererId, buffer, 0, 0, static_cast<GLsizeiptr>(_nextSlot) * _slotSize);
+		LOG_INFO("Expanding material buffer from {} to {} slots", _capacity, capacity);
+	}
+	if (_rendererId != 0) {
+		GlState::OnBufferDeleted(_rendererId);
+		glDeleteBuffers(1, &_rendererId);
+	}
+
+	_rendererId = buffer;
+	_capacity = capacity;
+	_elementSize = _slotSize;
+	_elementCount = capacity;
+	_size = capacity * _slotSize;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// Holds the parameter blocks of every material in one uniform buffer. Each material gets a fixed size
+/// slot that it writes it's std140 b_Material block into whenever one of it's parameters changes, so
+/// binding a material is just a glBindBufferRange to BINDING
+/// </summary>
+class MaterialBuffer final : public IBuffer {
+public:
+	typedef std::shared_ptr<MaterialBuffer> Sptr;
+
+	// The uniform block binding that shaders declare b_Material at
+	static constexpr int BINDING = 3;
+	// The name of the uniform block that holds a shader's material parameters
+	static constexpr const char* BLOCK_NAME = "b_Material";
+	// Returned by Allocate when there is no slot
+	static constexpr uint32_t NO_SLOT = ~0u;
+
+	/// <summary>
+	/// Creates a new material buffer
+	/// </summary>
+	/// <param name="slotSize">The largest parameter block a material can have, will be rounded up to the UBO offset alignment</param>
+	/// <param name="initialSlots">The number of slots to start with, the buffer doubles in size when it runs out</param>
+	MaterialBuffer(uint32_t slotSize = 256, uint32_t initialSlots = 64);
+	virtual ~MaterialBuffer() = default;
+
+	/// <summary>
+	/// Reserves a slot for a material's parameters, the contents are undefined until the first Upload
+	/// </summary>
+	uint32_t Allocate();
+	/// <summary>
+	/// Hands a slot back so it can be used by another material
+	/// </summary>
+	void Release(uint32_t slot);
+
+	/// <summary>
+	/// Replaces the contents of a slot
+	/// </summary>
+	/// <param name="slot">The slot to write to</param>
+	/// <param name="data">The packed std140 block</param>
+	/// <param name="size">The size of the block in bytes, must be no larger than GetSlotSize</param>
+	void Upload(uint32_t slot, const void* data, uint32_t size);
+
+	/// <summary>
+	/// Binds a slot to BINDING
+	/// </summary>
+	/// <param name="slot">The slot to bind</param>
+	/// <param name="size">The size of the material's block in bytes</param>
+	void BindSlot(uint32_t slot, uint32_t size) const;
+
+	/// <summary>
+	/// Gets the number of bytes available to each material
+	/// </summary>
+	uint32_t GetSlotSize() const { return _slotSize; }
+	/// <summary>
+	/// Gets the number of slots currently handed out
+	/// </summary>
+	uint32_t GetSlotsUsed() const { return _nextSlot - static_cast<uint32_t>(_freeSlots.size()); }
+	/// <summary>
+	/// Gets the number of slot uploads since the buffer was created, this should only go up when materials are edited
+	/// </summary>
+	uint32_t GetUploadCount() const { return _uploadCount; }
+
+protected:
+	uint32_t              _slotSize;
+	uint32_t              _capacity;
+	// Every slot at or past this one has never been handed out
+	uint32_t              _nextSlot;
+	std::vector<uint32_t> _freeSlots;
+	uint32_t              _uploadCount;
+
+	// Re-creates the buffer with room for more slots, keeping the slots we've already written
+	void _Grow(uint32_t capacity);
+};
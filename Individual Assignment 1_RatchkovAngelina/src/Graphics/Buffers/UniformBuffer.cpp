@@ -1,4 +1,5 @@
 #include "UniformBuffer.h"
+#include "Graphics/GlState.h"
 #include "Logging.h"
 
 AbstractUniformBuffer::~AbstractUniformBuffer() {
@@ -25,11 +26,11 @@ void AbstractUniformBuffer::LoadData(const void* data, uint32_t elementSize, uin
 }
 
 void AbstractUniformBuffer::Bind() const {
-	glBindBufferBase(GL_UNIFORM_BUFFER, 0, _rendererId);
+	GlState::BindBufferBase(GL_UNIFORM_BUFFER, 0, _rendererId);
 }
 
 void AbstractUniformBuffer::Bind(int slot) const
 {
-	glBindBufferBase(GL_UNIFORM_BUFFER, slot, _rendererId);
+	GlState::BindBufferBase(GL_UNIFORM_BUFFER, slot, _rendererId);
 }
 
@@ -0,0 +1,126 @@
+#include "UniformRingBuffer.h"
+#include <algorithm>
+#include "Graphics/GlState.h"
+#include "Logging.h"
+
+UniformRingBuffer::UniformRingBuffer(uint32_t bytesPerFrame, uint32_t framesInFlight) :
+	IBuffer(BufferType::Uniform, BufferUsage::DynamicDraw),
+	_mappedData(nullptr),
+	_frameSize(0),
+	_numFrames(framesInFlight),
+	_currentFrame(0),
+	_cursor(0),
+	_alignment(1),
+	_stallCount(0),
+	_fences(framesInFlight, nullptr)
+{
+	// Our slices may be used as either UBOs or SSBOs, so we need to respect the stricter of the two alignments
+	GLint uboAlignment = 1, ssboAlignment = 1;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssboAlignment);
+	_alignment = static_cast<uint32_t>(std::max(uboAlignment, ssboAlignment));
+
+	_CreateStorage(bytesPerFrame);
+}
+
+UniformRingBuffer::~UniformRingBuffer() {
+	_ReleaseStorage();
+}
+
+void UniformRingBuffer::BeginFrame(uint32_t requiredBytes)
+{
+	// Fence off the region we just finished with, all the commands that read it have been submitted
+	if (_fences[_currentFrame] != nullptr) {
+		glDeleteSync(_fences[_currentFrame]);
+	}
+	_fences[_currentFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// If we need more room than we have, we need new storage, since glBufferStorage can't be resized
+	if (requiredBytes > _frameSize) {
+		uint32_t newSize = std::max(requiredBytes, _frameSize * 2);
+		LOG_INFO("Expanding uniform ring buffer from {} bytes to {} bytes per frame", _frameSize, newSize);
+		_ReleaseStorage();
+		_CreateStorage(newSize);
+	}
+
+	_currentFrame = (_currentFrame + 1) % _numFrames;
+	_cursor = 0;
+
+	// Wait for the GPU to finish with the region we're about to write into
+	GLsync fence = _fences[_currentFrame];
+	if (fence != nullptr) {
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			_stallCount++;
+			while (result == GL_TIMEOUT_EXPIRED) {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			}
+		}
+		glDeleteSync(fence);
+		_fences[_currentFrame] = nullptr;
+	}
+}
+
+UniformRingBuffer::Allocation UniformRingBuffer::Allocate(uint32_t sizeInBytes)
+{
+	Allocation result;
+	uint32_t alignedSize = AlignSize(sizeInBytes);
+	if (_cursor + alignedSize > _frameSize) {
+		LOG_WARN("Uniform ring buffer is out of space ({} of {} bytes used), pass a larger size to BeginFrame", _cursor, _frameSize);
+		return result;
+	}
+
+	result.Offset = (_currentFrame * _frameSize) + _cursor;
+	result.Size   = sizeInBytes;
+	result.Data   = _mappedData + result.Offset;
+	_cursor += alignedSize;
+	return result;
+}
+
+void UniformRingBuffer::BindRange(BufferType type, uint32_t slot, const Allocation& allocation) const
+{
+	GlState::BindBufferRange((GLenum)type, slot, _rendererId, (GLintptr)allocation.Offset, (GLsizeiptr)allocation.Size);
+}
+
+void UniformRingBuffer::BindAs(BufferType type) const
+{
+	GlState::BindBuffer((GLenum)type, _rendererId);
+}
+
+void UniformRingBuffer::_CreateStorage(uint32_t bytesPerFrame)
+{
+	// Keep each region aligned, so the offsets we hand out are aligned as well
+	_frameSize = AlignSize(std::max(bytesPerFrame, 1u));
+	_size = _frameSize * _numFrames;
+	_elementSize = 1;
+	_elementCount = _size;
+
+	if (_rendererId == 0) {
+		glCreateBuffers(1, &_rendererId);
+	}
+
+	GLbitfield flags = *(BufferMapMode::Write | BufferMapMode::Persistent | BufferMapMode::Coherent);
+	glNamedBufferStorage(_rendererId, _size, nullptr, flags);
+	_mappedData = reinterpret_cast<uint8_t*>(glMapNamedBufferRange(_rendererId, 0, _size, flags));
+	LOG_ASSERT(_mappedData != nullptr, "Failed to map uniform ring buffer");
+}
+
+void UniformRingBuffer::_ReleaseStorage()
+{
+	// We can't delete the buffer out from under the GPU, so make sure it's done with every region
+	for (GLsync& fence : _fences) {
+		if (fence != nullptr) {
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (_rendererId != 0) {
+		glUnmapNamedBuffer(_rendererId);
+		GlState::OnBufferDeleted(_rendererId);
+		glDeleteBuffers(1, &_rendererId);
+		_rendererId = 0;
+	}
+	_mappedData = nullptr;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include <vector>
+#include <cstring>
+
+/// <summary>
+/// A persistently mapped buffer that is split into one region per frame in flight. Each frame,
+/// we hand out aligned slices of the current region for per-frame and per-draw data, and bind them
+/// with glBindBufferRange. Fences make sure we never write into a region the GPU is still reading,
+/// so we never stall on a buffer update or make the driver orphan the buffer.
+/// 
+/// Slices can be bound as either uniform or shader storage buffers, or hold indirect draw commands
+/// </summary>
+class UniformRingBuffer : public IBuffer {
+public:
+	typedef std::shared_ptr<UniformRingBuffer> Sptr;
+
+	/// <summary>
+	/// A slice of the ring buffer, valid until the next call to BeginFrame
+	/// </summary>
+	struct Allocation {
+		// Pointer to the mapped memory, write your data here
+		void*    Data   = nullptr;
+		// The offset in bytes from the start of the buffer
+		uint32_t Offset = 0;
+		// The size of the allocation in bytes
+		uint32_t Size   = 0;
+	};
+
+	/// <summary>
+	/// Creates a new ring buffer
+	/// </summary>
+	/// <param name="bytesPerFrame">The initial number of bytes available each frame, will grow as needed in BeginFrame</param>
+	/// <param name="framesInFlight">The number of frames the GPU may be behind the CPU</param>
+	UniformRingBuffer(uint32_t bytesPerFrame, uint32_t framesInFlight = 3);
+	virtual ~UniformRingBuffer();
+
+	/// <summary>
+	/// Moves to the next region of the buffer, waiting for the GPU to finish with it if needed.
+	/// If more space is requested than a region holds, the buffer will be re-created large enough
+	/// </summary>
+	/// <param name="requiredBytes">The number of bytes the caller expects to allocate this frame, including alignment</param>
+	void BeginFrame(uint32_t requiredBytes = 0);
+
+	/// <summary>
+	/// Allocates an aligned slice from the current frame's region
+	/// </summary>
+	/// <param name="sizeInBytes">The number of bytes to allocate</param>
+	/// <returns>The allocation, Data will be nullptr if the region is out of space</returns>
+	Allocation Allocate(uint32_t sizeInBytes);
+
+	/// <summary>
+	/// Allocates a slice for a structure, copies the value into it and returns the allocation
+	/// </summary>
+	template <typename T>
+	Allocation Allocate(const T& value) {
+		Allocation result = Allocate(sizeof(T));
+		if (result.Data != nullptr) {
+			memcpy(result.Data, &value, sizeof(T));
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Binds an allocation to an indexed binding slot
+	/// </summary>
+	/// <param name="type">The binding target, should be Uniform or ShaderStorage</param>
+	/// <param name="slot">The binding slot</param>
+	/// <param name="allocation">The allocation to bind</param>
+	void BindRange(BufferType type, uint32_t slot, const Allocation& allocation) const;
+	/// <summary>
+	/// Binds the whole buffer to a non-indexed target, ex: DrawIndirect so that allocations can
+	/// hold draw commands. Draws then take the offset of the allocation
+	/// </summary>
+	/// <param name="type">The binding target</param>
+	void BindAs(BufferType type) const;
+
+	/// <summary>
+	/// Gets the alignment that all allocations respect, in bytes
+	/// </summary>
+	uint32_t GetAlignment() const { return _alignment; }
+	/// <summary>
+	/// Rounds a size up to the allocation alignment, useful for working out what to pass to BeginFrame
+	/// </summary>
+	uint32_t AlignSize(uint32_t size) const { return ((size + _alignment - 1) / _alignment) * _alignment; }
+	/// <summary>
+	/// Gets the number of bytes available to each frame
+	/// </summary>
+	uint32_t GetFrameCapacity() const { return _frameSize; }
+	/// <summary>
+	/// Gets the number of bytes that have been allocated so far this frame
+	/// </summary>
+	uint32_t GetBytesUsed() const { return _cursor; }
+	/// <summary>
+	/// Gets the number of times we've had to wait on the GPU to release a region
+	/// </summary>
+	uint32_t GetStallCount() const { return _stallCount; }
+
+protected:
+	uint8_t*            _mappedData;
+	uint32_t            _frameSize;
+	uint32_t            _numFrames;
+	uint32_t            _currentFrame;
+	uint32_t            _cursor;
+	uint32_t            _alignment;
+	uint32_t            _stallCount;
+	std::vector<GLsync> _fences;
+
+	// Creates and maps immutable storage for all our frame regions
+	void _CreateStorage(uint32_t bytesPerFrame);
+	// Unmaps and deletes the storage, waiting for all fences first
+	void _ReleaseStorage();
+};
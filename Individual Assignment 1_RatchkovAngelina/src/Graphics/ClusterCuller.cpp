@@ -0,0 +1,77 @@
+#include "ClusterCuller.h"
+
+ClusterCuller::ClusterCuller() :
+	_frustum(),
+	_cameraPosition(glm::vec3(0.0f)),
+	_viewDirection(glm::vec3(0.0f, 0.0f, -1.0f)),
+	_isOrtho(false),
+	_stats()
+{ }
+
+ClusterCuller::~ClusterCuller() = default;
+
+void ClusterCuller::BeginFrame(const Frustum& frustum, const glm::vec3& cameraPosition, bool isOrtho, const glm::vec3& viewDirection) {
+	_frustum = frustum;
+	_cameraPosition = cameraPosition;
+	_viewDirection = viewDirection;
+	_isOrtho = isOrtho;
+	_stats = Stats();
+}
+
+uint32_t ClusterCuller::Cull(const std::vector<Meshlet>& meshlets, const glm::mat4& model, DrawElementsIndirectCommand* commands, uint32_t firstIndex, int32_t baseVertex, uint32_t baseInstance) {
+	// Spheres get scaled by the largest axis scale, so they still enclose their cluster after a non-uniform scale
+	const float radiusScale = glm::sqrt(glm::max(
+		glm::dot(glm::vec3(model[0]), glm::vec3(model[0])), glm::max(
+		glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+		glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+
+	// Which side of a triangle the camera is on doesn't change under an affine transform, so we can do the cone
+	// test in model space and skip transforming the cones. A mirrored transform flips the winding that OpenGL
+	// sees, so those don't get their back faces culled at all
+	const bool canCullBackfaces = glm::determinant(glm::mat3(model)) > 0.0f;
+	const glm::mat4 inverseModel = glm::inverse(model);
+	const glm::vec3 localCamera = glm::vec3(inverseModel * glm::vec4(_cameraPosition, 1.0f));
+	const glm::vec3 localViewDirection = glm::vec3(inverseModel * glm::vec4(_viewDirection, 0.0f));
+
+	uint32_t count = 0;
+	for (const Meshlet& meshlet : meshlets) {
+		_stats.ClustersTested++;
+
+		if (!_frustum.Intersects(glm::vec3(model * glm::vec4(meshlet.Center, 1.0f)), meshlet.Radius * radiusScale)) {
+			_stats.FrustumCulled++;
+			continue;
+		}
+
+		// Every triangle in the cluster faces away from every point in the sphere if the view direction is far
+		// enough inside the cone. For orthographic cameras, every point is viewed from the same direction
+		if (canCullBackfaces && meshlet.ConeCutoff < 1.0f) {
+			bool isBackfacing;
+			if (_isOrtho) {
+				const float length = glm::length(localViewDirection);
+				isBackfacing = glm::dot(localViewDirection, meshlet.ConeAxis) >= meshlet.ConeCutoff * length;
+			} else {
+				const glm::vec3 toCluster = meshlet.Center - localCamera;
+				isBackfacing = glm::dot(toCluster, meshlet.ConeAxis) >= meshlet.ConeCutoff * glm::length(toCluster) + meshlet.Radius;
+			}
+			if (isBackfacing) {
+				_stats.BackfaceCulled++;
+				continue;
+			}
+		}
+
+		// Extend the last command if this cluster picks up where it left off
+		if (count > 0 && commands[count - 1].FirstIndex + commands[count - 1].Count == firstIndex + meshlet.FirstIndex) {
+			commands[count - 1].Count += meshlet.IndexCount;
+		} else {
+			DrawElementsIndirectCommand& command = commands[count++];
+			command.Count         = meshlet.IndexCount;
+			command.InstanceCount = 1;
+			command.FirstIndex    = firstIndex + meshlet.FirstIndex;
+			command.BaseVertex    = baseVertex;
+			command.BaseInstance  = baseInstance;
+		}
+	}
+
+	_stats.CommandsEmitted += count;
+	return count;
+}
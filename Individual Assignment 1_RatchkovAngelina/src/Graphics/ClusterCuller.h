@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/Frustum.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Culls the meshlets of large meshes against the camera, and turns the ones that survive into indirect
+/// draw commands. Clusters outside of the frustum are dropped, as are clusters whose normal cone points
+/// away from the camera, since back face culling would throw out all of their triangles anyways.
+///
+/// Visible clusters that are next to each other in the index buffer are merged into a single command
+/// </summary>
+class ClusterCuller final {
+public:
+	MAKE_PTRS(ClusterCuller);
+
+	/// <summary>
+	/// Counters for the clusters tested since the last call to BeginFrame
+	/// </summary>
+	struct Stats {
+		// The number of clusters that were tested
+		uint32_t ClustersTested  = 0;
+		// The number of clusters that were outside of the frustum
+		uint32_t FrustumCulled   = 0;
+		// The number of clusters that were facing away from the camera
+		uint32_t BackfaceCulled  = 0;
+		// The number of draw commands that were emitted, after merging neighbouring clusters
+		uint32_t CommandsEmitted = 0;
+	};
+
+	ClusterCuller();
+	~ClusterCuller();
+
+	/// <summary>
+	/// Sets the camera that clusters will be culled against for this frame, and resets the stats
+	/// </summary>
+	/// <param name="frustum">The camera's world space frustum</param>
+	/// <param name="cameraPosition">The world space position of the camera</param>
+	/// <param name="isOrtho">True if the camera uses an orthographic projection</param>
+	/// <param name="viewDirection">The world space direction the camera faces, only used for orthographic cameras</param>
+	void BeginFrame(const Frustum& frustum, const glm::vec3& cameraPosition, bool isOrtho = false, const glm::vec3& viewDirection = glm::vec3(0.0f, 0.0f, -1.0f));
+
+	/// <summary>
+	/// Culls an object's clusters, and writes a draw command for each run of visible clusters
+	/// </summary>
+	/// <param name="meshlets">The clusters of the object's mesh</param>
+	/// <param name="model">The object's model matrix</param>
+	/// <param name="commands">The array to write commands to, must have room for meshlets.size() commands</param>
+	/// <param name="firstIndex">Added to the first index of each cluster, for meshes stored in a MeshPool</param>
+	/// <param name="baseVertex">The base vertex to write to each command</param>
+	/// <param name="baseInstance">The base instance to write to each command, the index of the object's instance data</param>
+	/// <returns>The number of commands written</returns>
+	uint32_t Cull(const std::vector<Meshlet>& meshlets, const glm::mat4& model, DrawElementsIndirectCommand* commands,
+		uint32_t firstIndex = 0, int32_t baseVertex = 0, uint32_t baseInstance = 0);
+
+	/// <summary>
+	/// Gets the counters for everything culled since the last call to BeginFrame
+	/// </summary>
+	const Stats& GetStats() const { return _stats; }
+
+protected:
+	Frustum   _frustum;
+	glm::vec3 _cameraPosition;
+	glm::vec3 _viewDirection;
+	bool      _isOrtho;
+	Stats     _stats;
+};
@@ -1,4 +1,9 @@
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlState.h"
+
+namespace {
+	constexpr UniformId MVP_UNIFORM("u_MVP");
+}
 
 DebugDrawer::DebugDrawer() :
 	_colorStack(std::stack<glm::vec3>()),
@@ -69,7 +74,7 @@ void DebugDrawer::FlushLines()
 {
 	if (_lineOffset > 0) {
 		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
+		__Shader->SetUniformMatrix(MVP_UNIFORM, _viewProjection * _transformStack.top());
 		int restorePoint = 0;
 		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
 		VertexArrayObject::Unbind();
@@ -79,7 +84,7 @@ void DebugDrawer::FlushLines()
 		_linesVAO->Unbind();
 		_lineOffset = 0;
 		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
+			GlState::BindVertexArray(restorePoint);
 		}
 	}
 }
@@ -112,7 +117,7 @@ void DebugDrawer::FlushTris()
 {
 	if (_triangleOffset > 0) {
 		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
+		__Shader->SetUniformMatrix(MVP_UNIFORM, _viewProjection * _transformStack.top());
 		int restorePoint = 0;
 		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
 		VertexArrayObject::Unbind();
@@ -122,7 +127,7 @@ void DebugDrawer::FlushTris()
 		_trisVAO->Unbind();
 		_triangleOffset = 0;
 		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
+			GlState::BindVertexArray(restorePoint);
 		}
 	}
 }
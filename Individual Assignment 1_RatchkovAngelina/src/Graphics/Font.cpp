@@ -85,6 +85,11 @@ void Font::AddGlyphRange(uint32_t min, uint32_t max) {
 
 void Font::Bake() {
 	LOG_ASSERT(_atlas == nullptr, "Bake has already been called!");
+	_PackAtlas();
+	_UploadAtlas();
+}
+
+void Font::_PackAtlas() {
 	LOG_ASSERT(_fontInfo.data != nullptr, "Have not loaded a font asset!");
 
 	uint8_t* rawFontData = reinterpret_cast<uint8_t*>(_fontData.data());
@@ -154,21 +159,12 @@ void Font::Bake() {
 
 	_CrtCheckMemory();
 
-	// Create a texture to store the atlas
-	Texture2DDescription desc;
-	desc.Width = _atlasWidth;
-	desc.Height = _atlasHeight;
-	desc.Format = InternalFormat::R8;
-	_atlas = std::make_shared<Texture2D>(desc);
-
 	// Allocate memory for the image, and point rect pack at it
-	uint8_t* atlasData = new uint8_t[desc.Width * (size_t)desc.Height];
-	memset(atlasData, 0, desc.Width * desc.Height);
+	std::vector<uint8_t> atlasData((size_t)_atlasWidth * _atlasHeight, 0);
 
 	stbtt_pack_context context;
-	if (!stbtt_PackBegin(&context, atlasData, _atlasWidth, _atlasHeight, 0, 1, nullptr)) {
+	if (!stbtt_PackBegin(&context, atlasData.data(), _atlasWidth, _atlasHeight, 0, 1, nullptr)) {
 		LOG_ERROR("Failed to pack font texture");
-		delete[] atlasData;
 		return;
 	}
 	_CrtCheckMemory();
@@ -177,7 +173,6 @@ void Font::Bake() {
 	for (auto& range : ranges) {
 		if (!stbtt_PackFontRange(&context, rawFontData, 0, range.font_size, range.first_unicode_codepoint_in_range, range.num_chars, range.chardata_for_range)) {
 			LOG_ERROR("Failed to pack font range");
-			delete[] atlasData;
 			return;
 		}
 		_CrtCheckMemory();
@@ -186,9 +181,8 @@ void Font::Bake() {
 
 	_CrtCheckMemory();
 
-	// Upload data into the image
-	_atlas->LoadData(desc.Width, desc.Height, PixelFormat::Red, PixelType::UByte, atlasData);
-	delete[] atlasData;
+	// Hold on to the pixels until the atlas is uploaded
+	_atlasData = std::move(atlasData);
 
 	uint32_t index = 0;
 	for (uint32_t codepoint : codePoints) {
@@ -200,6 +194,22 @@ void Font::Bake() {
 	}
 }
 
+void Font::_UploadAtlas() {
+	// Create a texture to store the atlas
+	Texture2DDescription desc;
+	desc.Width = _atlasWidth;
+	desc.Height = _atlasHeight;
+	desc.Format = InternalFormat::R8;
+	_atlas = std::make_shared<Texture2D>(desc);
+
+	// Upload data into the image, if packing failed the atlas is left blank
+	if (!_atlasData.empty()) {
+		_atlas->LoadData(desc.Width, desc.Height, PixelFormat::Red, PixelType::UByte, _atlasData.data());
+		_atlasData.clear();
+		_atlasData.shrink_to_fit();
+	}
+}
+
 const Texture2D::Sptr& Font::GetAtlas() {
 	return _atlas;
 }
@@ -310,7 +320,7 @@ nlohmann::json Font::ToJson() const
 	return blob;
 }
 
-Font::Sptr Font::FromJson(const nlohmann::json& data) {
+Font::Sptr Font::_LoadFromJson(const nlohmann::json& data) {
 	Font::Sptr result = std::make_shared<Font>();
 		
 	// Load the path and font size so we can grab the font file
@@ -326,7 +336,23 @@ Font::Sptr Font::FromJson(const nlohmann::json& data) {
 		}
 	}
 
+	return result;
+}
+
+Font::Sptr Font::FromJson(const nlohmann::json& data) {
+	Font::Sptr result = _LoadFromJson(data);
+
 	// Bake font texture and return
 	result->Bake();
 	return result;
 }
+
+std::function<Font::Sptr()> Font::Decode(const nlohmann::json& data) {
+	// Fonts don't touch OpenGL until the atlas is uploaded, so everything up to that can happen here
+	Font::Sptr result = _LoadFromJson(data);
+	result->_PackAtlas();
+	return [result]() {
+		result->_UploadAtlas();
+		return result;
+	};
+}
@@ -3,6 +3,9 @@
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/Textures/Texture2D.h"
 
+#include <functional>
+#include <vector>
+
 #include <stb_truetype.h>
 
 	struct GlyphInfo {
@@ -91,6 +94,12 @@
 
 		virtual nlohmann::json ToJson() const override;
 		static Font::Sptr FromJson(const nlohmann::json& data);
+		/// <summary>
+		/// Loads the font file and packs the glyphs for a font from it's JSON blob, and returns a
+		/// function that will upload the atlas. Packing can happen on any thread, but the returned
+		/// function must be invoked on the main thread
+		/// </summary>
+		static std::function<Font::Sptr()> Decode(const nlohmann::json& data);
 
 	protected:
 		std::vector<glm::uvec2> _glyphRanges;
@@ -99,6 +108,8 @@
 		Texture2D::Sptr   _atlas;
 		std::string       _fontPath;
 		std::string       _fontData;
+		// The packed atlas pixels, only held between packing and uploading
+		std::vector<uint8_t> _atlasData;
 		float             _fontSize;
 
 		float             _pixelHeightScale;
@@ -114,4 +125,18 @@
 		stbtt_fontinfo    _fontInfo;
 
 		GlyphInfo __CreateGlyph(uint32_t index);
+
+		/// <summary>
+		/// Packs all the glyphs into the atlas pixels, does not touch OpenGL
+		/// </summary>
+		void _PackAtlas();
+		/// <summary>
+		/// Creates the atlas texture and uploads the packed pixels
+		/// </summary>
+		void _UploadAtlas();
+
+		/// <summary>
+		/// Creates a font and loads the font file and glyph ranges from a JSON blob, without baking it
+		/// </summary>
+		static Font::Sptr _LoadFromJson(const nlohmann::json& data);
 	};
\ No newline at end of file
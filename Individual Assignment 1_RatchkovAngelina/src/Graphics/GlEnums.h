@@ -745,9 +745,11 @@ ENUM(BlendEquation, uint32_t,
 /// </summary>
 /// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferData.xhtml</see>
 ENUM(BufferType, GLenum,
-	Vertex  = GL_ARRAY_BUFFER,
-	Index   = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Vertex        = GL_ARRAY_BUFFER,
+	Index         = GL_ELEMENT_ARRAY_BUFFER,
+	Uniform       = GL_UNIFORM_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+	DrawIndirect  = GL_DRAW_INDIRECT_BUFFER
 )
 
 /// <summary>
@@ -811,6 +813,10 @@ ENUM(AttributeType, GLenum,
 	 UInt    = GL_UNSIGNED_INT,
 	 Float   = GL_FLOAT,
 	 Double  = GL_DOUBLE,
+	 // 16 bit floating point, for quantized attributes
+	 HalfFloat     = GL_HALF_FLOAT,
+	 // Three signed 10 bit values and a 2 bit value packed into 32 bits, for quantized normals and tangents
+	 Int2101010Rev = GL_INT_2_10_10_10_REV,
 	 Unknown = GL_NONE
 )
 
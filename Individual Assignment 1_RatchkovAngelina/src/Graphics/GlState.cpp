@@ -0,0 +1,286 @@
+#include "GlState.h"
+
+GLuint GlState::__program = GlState::UNKNOWN;
+GLuint GlState::__vertexArray = GlState::UNKNOWN;
+std::unordered_map<GLenum, GLuint> GlState::__buffers;
+std::unordered_map<uint64_t, GlState::BufferRange> GlState::__bufferRanges;
+std::vector<GLuint> GlState::__textures;
+std::vector<GLuint> GlState::__samplers;
+std::unordered_map<GLenum, bool> GlState::__caps;
+std::unordered_map<GLuint, GlState::AttribArrays> GlState::__attribArrays;
+std::unordered_map<GLenum, GLenum> GlState::__polygonModes;
+
+int    GlState::__depthMask = -1;
+GLenum GlState::__depthFunc = GlState::UNKNOWN;
+GLenum GlState::__cullFace = GlState::UNKNOWN;
+GLenum GlState::__blendFunc[4] = { GlState::UNKNOWN, GlState::UNKNOWN, GlState::UNKNOWN, GlState::UNKNOWN };
+GLenum GlState::__blendEquation[2] = { GlState::UNKNOWN, GlState::UNKNOWN };
+
+GlState::Stats GlState::__frameStats = GlState::Stats();
+GlState::Stats GlState::__lastFrameStats = GlState::Stats();
+
+void GlState::Reset()
+{
+	__program = UNKNOWN;
+	__vertexArray = UNKNOWN;
+	__buffers.clear();
+	__bufferRanges.clear();
+	__textures.clear();
+	__samplers.clear();
+	__caps.clear();
+	__attribArrays.clear();
+	__polygonModes.clear();
+	__depthMask = -1;
+	__depthFunc = UNKNOWN;
+	__cullFace = UNKNOWN;
+	__blendFunc[0] = __blendFunc[1] = __blendFunc[2] = __blendFunc[3] = UNKNOWN;
+	__blendEquation[0] = __blendEquation[1] = UNKNOWN;
+}
+
+void GlState::BeginFrame()
+{
+	__lastFrameStats = __frameStats;
+	__frameStats = Stats();
+}
+
+void GlState::UseProgram(GLuint program)
+{
+	if (_Changed(__program != program)) {
+		glUseProgram(program);
+		__program = program;
+	}
+}
+
+void GlState::BindVertexArray(GLuint vao)
+{
+	if (_Changed(__vertexArray != vao)) {
+		glBindVertexArray(vao);
+		__vertexArray = vao;
+		// The element buffer binding belongs to the VAO, so we don't know what it is anymore
+		__buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+}
+
+void GlState::BindBuffer(GLenum target, GLuint buffer)
+{
+	// Without a known VAO we can't know which one the element buffer binding would go to
+	bool known = target != GL_ELEMENT_ARRAY_BUFFER || __vertexArray != UNKNOWN;
+	auto it = __buffers.find(target);
+	if (_Changed(!known || it == __buffers.end() || it->second != buffer)) {
+		glBindBuffer(target, buffer);
+		if (known) {
+			__buffers[target] = buffer;
+		}
+	}
+}
+
+void GlState::BindBufferBase(GLenum target, uint32_t index, GLuint buffer)
+{
+	BindBufferRange(target, index, buffer, 0, -1);
+}
+
+void GlState::BindBufferRange(GLenum target, uint32_t index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	// Transform feedback bindings are owned by the bound transform feedback object, which we don't track
+	if (target == GL_TRANSFORM_FEEDBACK_BUFFER) {
+		_Changed(true);
+		size < 0 ? glBindBufferBase(target, index, buffer) : glBindBufferRange(target, index, buffer, offset, size);
+		__buffers[target] = buffer;
+		return;
+	}
+
+	BufferRange& range = __bufferRanges[(static_cast<uint64_t>(target) << 32) | index];
+	if (_Changed(range.Buffer != buffer || range.Offset != offset || range.Size != size)) {
+		size < 0 ? glBindBufferBase(target, index, buffer) : glBindBufferRange(target, index, buffer, offset, size);
+		range = { buffer, offset, size };
+		// Indexed binds also bind to the generic target
+		__buffers[target] = buffer;
+	}
+}
+
+void GlState::BindTextureUnit(uint32_t unit, GLuint texture)
+{
+	GLuint& slot = _Slot(__textures, unit);
+	if (_Changed(slot != texture)) {
+		glBindTextureUnit(unit, texture);
+		slot = texture;
+	}
+}
+
+void GlState::BindSampler(uint32_t unit, GLuint sampler)
+{
+	GLuint& slot = _Slot(__samplers, unit);
+	if (_Changed(slot != sampler)) {
+		glBindSampler(unit, sampler);
+		slot = sampler;
+	}
+}
+
+void GlState::Enable(GLenum cap)
+{
+	auto it = __caps.find(cap);
+	if (_Changed(it == __caps.end() || !it->second)) {
+		glEnable(cap);
+		__caps[cap] = true;
+	}
+}
+
+void GlState::Disable(GLenum cap)
+{
+	auto it = __caps.find(cap);
+	if (_Changed(it == __caps.end() || it->second)) {
+		glDisable(cap);
+		__caps[cap] = false;
+	}
+}
+
+void GlState::EnableVertexAttribArray(uint32_t index)
+{
+	_SetAttribArray(index, true);
+}
+
+void GlState::DisableVertexAttribArray(uint32_t index)
+{
+	_SetAttribArray(index, false);
+}
+
+void GlState::DepthMask(bool enabled)
+{
+	if (_Changed(__depthMask != (int)enabled)) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+		__depthMask = (int)enabled;
+	}
+}
+
+void GlState::DepthFunc(GLenum func)
+{
+	if (_Changed(__depthFunc != func)) {
+		glDepthFunc(func);
+		__depthFunc = func;
+	}
+}
+
+void GlState::CullFace(GLenum mode)
+{
+	if (_Changed(__cullFace != mode)) {
+		glCullFace(mode);
+		__cullFace = mode;
+	}
+}
+
+void GlState::PolygonMode(GLenum face, GLenum mode)
+{
+	auto front = __polygonModes.find(GL_FRONT);
+	auto back = __polygonModes.find(GL_BACK);
+	bool frontMatches = front != __polygonModes.end() && front->second == mode;
+	bool backMatches = back != __polygonModes.end() && back->second == mode;
+
+	bool matches = face == GL_FRONT ? frontMatches : face == GL_BACK ? backMatches : frontMatches && backMatches;
+	if (_Changed(!matches)) {
+		glPolygonMode(face, mode);
+		if (face != GL_BACK) {
+			__polygonModes[GL_FRONT] = mode;
+		}
+		if (face != GL_FRONT) {
+			__polygonModes[GL_BACK] = mode;
+		}
+	}
+}
+
+void GlState::BlendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha)
+{
+	if (_Changed(__blendFunc[0] != srcRgb || __blendFunc[1] != dstRgb || __blendFunc[2] != srcAlpha || __blendFunc[3] != dstAlpha)) {
+		glBlendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha);
+		__blendFunc[0] = srcRgb;
+		__blendFunc[1] = dstRgb;
+		__blendFunc[2] = srcAlpha;
+		__blendFunc[3] = dstAlpha;
+	}
+}
+
+void GlState::BlendEquationSeparate(GLenum rgb, GLenum alpha)
+{
+	if (_Changed(__blendEquation[0] != rgb || __blendEquation[1] != alpha)) {
+		glBlendEquationSeparate(rgb, alpha);
+		__blendEquation[0] = rgb;
+		__blendEquation[1] = alpha;
+	}
+}
+
+void GlState::OnProgramDeleted(GLuint program)
+{
+	_Forget(__program, program);
+}
+
+void GlState::OnVertexArrayDeleted(GLuint vao)
+{
+	_Forget(__vertexArray, vao);
+	__attribArrays.erase(vao);
+}
+
+void GlState::OnBufferDeleted(GLuint buffer)
+{
+	for (auto& [target, bound] : __buffers) {
+		_Forget(bound, buffer);
+	}
+	for (auto& [key, range] : __bufferRanges) {
+		_Forget(range.Buffer, buffer);
+	}
+}
+
+void GlState::OnTextureDeleted(GLuint texture)
+{
+	for (GLuint& bound : __textures) {
+		_Forget(bound, texture);
+	}
+}
+
+void GlState::OnSamplerDeleted(GLuint sampler)
+{
+	for (GLuint& bound : __samplers) {
+		_Forget(bound, sampler);
+	}
+}
+
+void GlState::_SetAttribArray(uint32_t index, bool enabled)
+{
+	const uint32_t bit = 1u << index;
+	if (__vertexArray == UNKNOWN) {
+		_Changed(true);
+		enabled ? glEnableVertexAttribArray(index) : glDisableVertexAttribArray(index);
+		return;
+	}
+
+	// VAOs can also have attributes enabled with glEnableVertexArrayAttrib, so we only know the ones we've set
+	AttribArrays& attribs = __attribArrays[__vertexArray];
+	if (_Changed((attribs.Known & bit) == 0 || ((attribs.Enabled & bit) != 0) != enabled)) {
+		enabled ? glEnableVertexAttribArray(index) : glDisableVertexAttribArray(index);
+		attribs.Known |= bit;
+		attribs.Enabled = enabled ? (attribs.Enabled | bit) : (attribs.Enabled & ~bit);
+	}
+}
+
+bool GlState::_Changed(bool changed)
+{
+	if (changed) {
+		__frameStats.Issued++;
+	} else {
+		__frameStats.Skipped++;
+	}
+	return changed;
+}
+
+GLuint& GlState::_Slot(std::vector<GLuint>& slots, uint32_t index)
+{
+	if (index >= slots.size()) {
+		slots.resize(index + 1, UNKNOWN);
+	}
+	return slots[index];
+}
+
+void GlState::_Forget(GLuint& value, GLuint handle)
+{
+	if (value == handle) {
+		value = UNKNOWN;
+	}
+}
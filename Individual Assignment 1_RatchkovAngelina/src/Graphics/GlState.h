@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "glad/glad.h"
+
+/// <summary>
+/// Remembers the OpenGL state that we've set, so that binds and state changes that would not
+/// change anything can be skipped. All of the Graphics wrappers (shaders, VAOs, buffers, textures
+/// and the rasterizer state) go through this class, so anything else that changes these states
+/// directly needs to either do the same, or call Reset afterwards
+///
+/// Only the state that this class has set is known, anything it has not seen will always be issued
+/// </summary>
+class GlState final {
+public:
+	/// <summary>
+	/// The number of calls that were passed to OpenGL, and the number that were skipped since the
+	/// state already matched
+	/// </summary>
+	struct Stats {
+		uint32_t Issued  = 0;
+		uint32_t Skipped = 0;
+	};
+
+	/// <summary>
+	/// Forgets all of the state we know about, the next call for every state will be issued. Use this
+	/// after code that we don't control (ImGui, other libraries) has been touching the context
+	/// </summary>
+	static void Reset();
+
+	/// <summary>
+	/// Starts a new frame of statistics, the counters for the frame that just ended can be fetched
+	/// with GetFrameStats
+	/// </summary>
+	static void BeginFrame();
+	/// <summary>
+	/// Gets the counters for the last full frame
+	/// </summary>
+	static const Stats& GetFrameStats() { return __lastFrameStats; }
+
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vao);
+	/// <summary>
+	/// Binds a buffer to a non-indexed target, note that GL_ELEMENT_ARRAY_BUFFER is part of the bound VAO
+	/// </summary>
+	static void BindBuffer(GLenum target, GLuint buffer);
+	/// <summary>
+	/// Binds a whole buffer to an indexed target, this also replaces the buffer bound to the non-indexed target
+	/// </summary>
+	static void BindBufferBase(GLenum target, uint32_t index, GLuint buffer);
+	/// <summary>
+	/// Binds part of a buffer to an indexed target, this also replaces the buffer bound to the non-indexed target
+	/// </summary>
+	static void BindBufferRange(GLenum target, uint32_t index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	static void BindTextureUnit(uint32_t unit, GLuint texture);
+	static void BindSampler(uint32_t unit, GLuint sampler);
+
+	static void Enable(GLenum cap);
+	static void Disable(GLenum cap);
+	static void SetEnabled(GLenum cap, bool enabled) { enabled ? Enable(cap) : Disable(cap); }
+	/// <summary>
+	/// Enables or disables a vertex attribute of the bound VAO, for code that does not use the
+	/// VertexArrayObject class
+	/// </summary>
+	static void EnableVertexAttribArray(uint32_t index);
+	static void DisableVertexAttribArray(uint32_t index);
+
+	static void DepthMask(bool enabled);
+	static void DepthFunc(GLenum func);
+	static void CullFace(GLenum mode);
+	static void PolygonMode(GLenum face, GLenum mode);
+	static void BlendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha);
+	static void BlendEquationSeparate(GLenum rgb, GLenum alpha);
+
+	/// <summary>
+	/// Should be called before deleting an object, since OpenGL will unbind it for us and the name can be
+	/// handed out again for a new object
+	/// </summary>
+	static void OnProgramDeleted(GLuint program);
+	static void OnVertexArrayDeleted(GLuint vao);
+	static void OnBufferDeleted(GLuint buffer);
+	static void OnTextureDeleted(GLuint texture);
+	static void OnSamplerDeleted(GLuint sampler);
+
+protected:
+	// Used for any state that we have not set yet
+	static constexpr GLuint UNKNOWN = ~0u;
+
+	struct BufferRange {
+		GLuint     Buffer = UNKNOWN;
+		GLintptr   Offset = 0;
+		// -1 if the whole buffer is bound with glBindBufferBase
+		GLsizeiptr Size   = -1;
+	};
+
+	struct AttribArrays {
+		// Bitmasks of attribute slots
+		uint32_t Known   = 0;
+		uint32_t Enabled = 0;
+	};
+
+	static GLuint __program;
+	static GLuint __vertexArray;
+	static std::unordered_map<GLenum, GLuint> __buffers;
+	// Keyed by the target in the upper bits and the index in the lower
+	static std::unordered_map<uint64_t, BufferRange> __bufferRanges;
+	static std::vector<GLuint> __textures;
+	static std::vector<GLuint> __samplers;
+	static std::unordered_map<GLenum, bool> __caps;
+	// The attributes that we've enabled or disabled on each VAO
+	static std::unordered_map<GLuint, AttribArrays> __attribArrays;
+	static std::unordered_map<GLenum, GLenum> __polygonModes;
+
+	static int    __depthMask;
+	static GLenum __depthFunc;
+	static GLenum __cullFace;
+	static GLenum __blendFunc[4];
+	static GLenum __blendEquation[2];
+
+	static Stats __frameStats;
+	static Stats __lastFrameStats;
+
+	// Updates the counters, returns true if the call should be issued
+	static bool _Changed(bool changed);
+	static void _SetAttribArray(uint32_t index, bool enabled);
+	static GLuint& _Slot(std::vector<GLuint>& slots, uint32_t index);
+	static void _Forget(GLuint& value, GLuint handle);
+};
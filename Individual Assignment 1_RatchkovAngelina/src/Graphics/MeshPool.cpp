@@ -0,0 +1,295 @@
+#include "MeshPool.h"
+#include <algorithm>
+#include <numeric>
+#include "Logging.h"
+
+// Dividing the instance ID attribute by a huge divisor makes it advance once per draw instead of once per instance,
+// so it only ever reads the entry at the draw's base instance. Shaders add gl_InstanceID to that themselves
+static constexpr GLuint INSTANCE_ID_DIVISOR = 1u << 30;
+
+struct MeshPool::Bucket {
+	std::vector<BufferAttribute> Attributes;
+	uint32_t                     Stride;
+	IndexType                    ElementType;
+	VertexBuffer::Sptr           Vertices;
+	IndexBuffer::Sptr            Indices;
+	RangeAllocator               VertexRanges;
+	RangeAllocator               IndexRanges;
+	VertexArrayObject::Sptr      Vao;
+	uint32_t                     MeshCount = 0;
+};
+
+namespace {
+	bool AttributesMatch(const std::vector<BufferAttribute>& a, const std::vector<BufferAttribute>& b) {
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const BufferAttribute& left, const BufferAttribute& right) {
+			return left.Slot == right.Slot && left.Size == right.Size && left.Type == right.Type &&
+				left.Normalized == right.Normalized && left.Stride == right.Stride && left.Offset == right.Offset;
+		});
+	}
+}
+
+bool MeshPool::RangeAllocator::Allocate(uint32_t count, uint32_t& offset) {
+	// Re-use the first released range that is big enough
+	for (auto it = FreeRanges.begin(); it != FreeRanges.end(); it++) {
+		if (it->second >= count) {
+			offset = it->first;
+			it->first += count;
+			it->second -= count;
+			if (it->second == 0) {
+				FreeRanges.erase(it);
+			}
+			return true;
+		}
+	}
+	if (End + count > Capacity) {
+		return false;
+	}
+	offset = End;
+	End += count;
+	return true;
+}
+
+void MeshPool::RangeAllocator::Release(uint32_t offset, uint32_t count) {
+	auto it = std::lower_bound(FreeRanges.begin(), FreeRanges.end(), std::make_pair(offset, 0u));
+	it = FreeRanges.insert(it, std::make_pair(offset, count));
+
+	// Merge with the ranges on either side, so the free list doesn't fragment
+	if (it + 1 != FreeRanges.end() && it->first + it->second == (it + 1)->first) {
+		it->second += (it + 1)->second;
+		FreeRanges.erase(it + 1);
+	}
+	if (it != FreeRanges.begin() && (it - 1)->first + (it - 1)->second == it->first) {
+		(it - 1)->second += it->second;
+		it = FreeRanges.erase(it) - 1;
+	}
+
+	// Space at the end goes back to the untouched part of the buffer
+	if (it->first + it->second == End) {
+		End = it->first;
+		FreeRanges.erase(it);
+	}
+}
+
+MeshPool::MeshPool(uint32_t initialVertexBytes, uint32_t initialIndexBytes) :
+	_initialVertexBytes(initialVertexBytes),
+	_initialIndexBytes(initialIndexBytes),
+	_buckets(),
+	_records(),
+	_instanceIds(VertexBuffer::Create()),
+	_instanceCapacity(0)
+{
+	ReserveInstances(1024);
+}
+
+MeshPool::~MeshPool() = default;
+
+const MeshPool::Entry* MeshPool::Get(const VertexArrayObject::Sptr& mesh) {
+	if (mesh == nullptr) {
+		return nullptr;
+	}
+
+	const auto& bindings = mesh->GetVertexBuffers();
+	const IBuffer* vertices = bindings.empty() ? nullptr : bindings[0]->GetBuffer().get();
+	const IBuffer* indices = mesh->GetIndexBuffer().get();
+
+	auto it = _records.find(mesh.get());
+	if (it != _records.end()) {
+		Record& record = it->second;
+		// The pointer may have been re-used by a new mesh, or the mesh may have been given new buffers
+		if (!record.Mesh.expired() && record.SourceVertices == vertices && record.SourceIndices == indices) {
+			return record.Location.Owner != nullptr ? &record.Location : nullptr;
+		}
+		_Release(record.Location);
+		_records.erase(it);
+	}
+
+	Record& record = _records[mesh.get()];
+	record.Mesh = mesh;
+	record.SourceVertices = vertices;
+	record.SourceIndices = indices;
+	// We keep a record even if the mesh can't be pooled, so we don't try again every frame
+	if (!_Add(*mesh, record)) {
+		record.Location = Entry();
+		return nullptr;
+	}
+	return &record.Location;
+}
+
+const VertexArrayObject::Sptr& MeshPool::GetVao(const Bucket* bucket) {
+	return bucket->Vao;
+}
+
+void MeshPool::CollectGarbage() {
+	for (auto it = _records.begin(); it != _records.end();) {
+		if (it->second.Mesh.expired()) {
+			_Release(it->second.Location);
+			it = _records.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+void MeshPool::ReserveInstances(uint32_t count) {
+	if (count <= _instanceCapacity) {
+		return;
+	}
+
+	_instanceCapacity = std::max(count, _instanceCapacity * 2);
+	std::vector<uint32_t> ids(_instanceCapacity);
+	std::iota(ids.begin(), ids.end(), 0u);
+	_instanceIds->LoadData(ids.data(), _instanceCapacity);
+
+	// Storage was re-created, so every bucket needs to point at it again
+	for (auto& bucket : _buckets) {
+		_BindInstanceIds(*bucket);
+	}
+}
+
+MeshPool::Stats MeshPool::GetStats() const {
+	Stats result;
+	result.Buckets = static_cast<uint32_t>(_buckets.size());
+	for (const auto& bucket : _buckets) {
+		result.Meshes += bucket->MeshCount;
+
+		uint32_t freeVertices = 0, freeIndices = 0;
+		for (const auto& range : bucket->VertexRanges.FreeRanges) { freeVertices += range.second; }
+		for (const auto& range : bucket->IndexRanges.FreeRanges) { freeIndices += range.second; }
+		result.VertexBytes += (bucket->VertexRanges.End - freeVertices) * bucket->Stride;
+		result.IndexBytes += (bucket->IndexRanges.End - freeIndices) * static_cast<uint32_t>(GetIndexTypeSize(bucket->ElementType));
+	}
+	return result;
+}
+
+bool MeshPool::_Add(VertexArrayObject& mesh, Record& record) {
+	// We can only describe a mesh with a base vertex if all of it's attributes come from one buffer
+	const auto& bindings = mesh.GetVertexBuffers();
+	if (bindings.size() != 1 || bindings[0]->IsInstanced() || bindings[0]->GetAttributes().empty()) {
+		return false;
+	}
+
+	const VertexBuffer::Sptr& sourceVertices = bindings[0]->GetBuffer();
+	const IndexBuffer::Sptr& sourceIndices = mesh.GetIndexBuffer();
+	const uint32_t stride = sourceVertices->GetElementSize();
+	const uint32_t vertexCount = sourceVertices->GetElementCount();
+	const uint32_t indexCount = sourceIndices != nullptr ? sourceIndices->GetElementCount() : vertexCount;
+	const IndexType indexType = sourceIndices != nullptr ? sourceIndices->GetElementType() : IndexType::UInt;
+	if (stride == 0 || vertexCount == 0 || indexCount == 0 || GetIndexTypeSize(indexType) == 0) {
+		return false;
+	}
+
+	Bucket* bucket = _FindBucket(bindings[0]->GetAttributes(), stride, indexType);
+
+	uint32_t firstVertex = 0, firstIndex = 0;
+	if (!bucket->VertexRanges.Allocate(vertexCount, firstVertex)) {
+		_GrowVertices(*bucket, vertexCount);
+		bucket->VertexRanges.Allocate(vertexCount, firstVertex);
+	}
+	if (!bucket->IndexRanges.Allocate(indexCount, firstIndex)) {
+		_GrowIndices(*bucket, indexCount);
+		bucket->IndexRanges.Allocate(indexCount, firstIndex);
+	}
+
+	// Copy the mesh across without it ever leaving the GPU
+	glCopyNamedBufferSubData(sourceVertices->GetHandle(), bucket->Vertices->GetHandle(),
+		0, static_cast<GLintptr>(firstVertex) * stride, static_cast<GLsizeiptr>(vertexCount) * stride);
+
+	const size_t indexSize = GetIndexTypeSize(indexType);
+	if (sourceIndices != nullptr) {
+		glCopyNamedBufferSubData(sourceIndices->GetHandle(), bucket->Indices->GetHandle(),
+			0, static_cast<GLintptr>(firstIndex * indexSize), static_cast<GLsizeiptr>(indexCount * indexSize));
+	} else {
+		// Meshes without indices get a list that walks through the vertices in order
+		std::vector<uint32_t> generated(indexCount);
+		std::iota(generated.begin(), generated.end(), 0u);
+		glNamedBufferSubData(bucket->Indices->GetHandle(), static_cast<GLintptr>(firstIndex * indexSize),
+			static_cast<GLsizeiptr>(indexCount * indexSize), generated.data());
+	}
+
+	record.Location.Owner = bucket;
+	record.Location.BaseVertex = static_cast<int32_t>(firstVertex);
+	record.Location.FirstIndex = firstIndex;
+	record.Location.VertexCount = vertexCount;
+	record.Location.IndexCount = indexCount;
+	bucket->MeshCount++;
+	return true;
+}
+
+void MeshPool::_Release(const Entry& entry) {
+	if (entry.Owner == nullptr) {
+		return;
+	}
+	entry.Owner->VertexRanges.Release(static_cast<uint32_t>(entry.BaseVertex), entry.VertexCount);
+	entry.Owner->IndexRanges.Release(entry.FirstIndex, entry.IndexCount);
+	entry.Owner->MeshCount--;
+}
+
+MeshPool::Bucket* MeshPool::_FindBucket(const std::vector<BufferAttribute>& attributes, uint32_t stride, IndexType indexType) {
+	for (auto& bucket : _buckets) {
+		if (bucket->Stride == stride && bucket->ElementType == indexType && AttributesMatch(bucket->Attributes, attributes)) {
+			return bucket.get();
+		}
+	}
+
+	std::unique_ptr<Bucket> bucket = std::make_unique<Bucket>();
+	bucket->Attributes = attributes;
+	bucket->Stride = stride;
+	bucket->ElementType = indexType;
+
+	const uint32_t indexSize = static_cast<uint32_t>(GetIndexTypeSize(indexType));
+	bucket->VertexRanges.Capacity = std::max(_initialVertexBytes / stride, 1u);
+	bucket->IndexRanges.Capacity = std::max(_initialIndexBytes / indexSize, 1u);
+	bucket->Vertices = VertexBuffer::Create();
+	bucket->Vertices->LoadData(nullptr, stride, bucket->VertexRanges.Capacity);
+	bucket->Indices = IndexBuffer::Create();
+	bucket->Indices->LoadData(nullptr, indexSize, bucket->IndexRanges.Capacity, indexType);
+	_BuildVao(*bucket);
+
+	LOG_INFO("Created mesh pool bucket {} with a {} byte stride and {} indices", _buckets.size(), stride, ~indexType);
+	_buckets.push_back(std::move(bucket));
+	return _buckets.back().get();
+}
+
+void MeshPool::_GrowVertices(Bucket& bucket, uint32_t vertexCount) {
+	const uint32_t capacity = std::max(bucket.VertexRanges.Capacity * 2, bucket.VertexRanges.End + vertexCount);
+	LOG_INFO("Growing mesh pool vertex buffer from {} bytes to {} bytes", bucket.VertexRanges.Capacity * bucket.Stride, capacity * bucket.Stride);
+
+	VertexBuffer::Sptr vertices = VertexBuffer::Create();
+	vertices->LoadData(nullptr, bucket.Stride, capacity);
+	glCopyNamedBufferSubData(bucket.Vertices->GetHandle(), vertices->GetHandle(), 0, 0, static_cast<GLsizeiptr>(bucket.VertexRanges.End) * bucket.Stride);
+
+	bucket.Vertices = vertices;
+	bucket.VertexRanges.Capacity = capacity;
+	_BuildVao(bucket);
+}
+
+void MeshPool::_GrowIndices(Bucket& bucket, uint32_t indexCount) {
+	const uint32_t indexSize = static_cast<uint32_t>(GetIndexTypeSize(bucket.ElementType));
+	const uint32_t capacity = std::max(bucket.IndexRanges.Capacity * 2, bucket.IndexRanges.End + indexCount);
+	LOG_INFO("Growing mesh pool index buffer from {} bytes to {} bytes", bucket.IndexRanges.Capacity * indexSize, capacity * indexSize);
+
+	IndexBuffer::Sptr indices = IndexBuffer::Create();
+	indices->LoadData(nullptr, indexSize, capacity, bucket.ElementType);
+	glCopyNamedBufferSubData(bucket.Indices->GetHandle(), indices->GetHandle(), 0, 0, static_cast<GLsizeiptr>(bucket.IndexRanges.End) * indexSize);
+
+	bucket.Indices = indices;
+	bucket.IndexRanges.Capacity = capacity;
+	_BuildVao(bucket);
+}
+
+void MeshPool::_BuildVao(Bucket& bucket) {
+	bucket.Vao = VertexArrayObject::Create();
+	bucket.Vao->SetDebugName("Mesh Pool");
+	bucket.Vao->AddVertexBuffer(bucket.Vertices, bucket.Attributes);
+	bucket.Vao->SetIndexBuffer(bucket.Indices);
+	_BindInstanceIds(bucket);
+}
+
+void MeshPool::_BindInstanceIds(Bucket& bucket) {
+	const GLuint vao = bucket.Vao->GetHandle();
+	glEnableVertexArrayAttrib(vao, INSTANCE_ID_SLOT);
+	glVertexArrayAttribIFormat(vao, INSTANCE_ID_SLOT, 1, GL_UNSIGNED_INT, 0);
+	glVertexArrayAttribBinding(vao, INSTANCE_ID_SLOT, INSTANCE_ID_SLOT);
+	glVertexArrayVertexBuffer(vao, INSTANCE_ID_SLOT, _instanceIds->GetHandle(), 0, sizeof(uint32_t));
+	glVertexArrayBindingDivisor(vao, INSTANCE_ID_SLOT, INSTANCE_ID_DIVISOR);
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/Buffers/VertexBuffer.h"
+#include "Graphics/Buffers/IndexBuffer.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Packs the vertices and indices of many meshes into a few large shared buffers, so that every mesh with
+/// the same vertex layout can be drawn from one VAO. Each mesh is addressed by a base vertex and first index,
+/// which lets the renderer draw all of them with a single glMultiDrawElementsIndirect.
+///
+/// Meshes are copied into the pool on the GPU the first time they are requested, and their space is handed
+/// back once the original VAO is destroyed. Every pooled VAO also has a per-draw attribute at INSTANCE_ID_SLOT
+/// that holds the draw's base instance, so shaders can find their instance data (see vs_common.glsl)
+/// </summary>
+class MeshPool final {
+public:
+	MAKE_PTRS(MeshPool);
+	NO_COPY(MeshPool);
+	NO_MOVE(MeshPool);
+
+	// The vertex attribute slot that receives the base instance of each draw
+	static constexpr uint32_t INSTANCE_ID_SLOT = 15;
+
+	/// <summary>
+	/// A set of shared buffers for all meshes with the same vertex layout and index type
+	/// </summary>
+	struct Bucket;
+
+	/// <summary>
+	/// Where a mesh lives in the pool
+	/// </summary>
+	struct Entry {
+		// The bucket holding the mesh, draw with it's VAO
+		Bucket*  Owner       = nullptr;
+		// Added to every index of the mesh, the offset of it's first vertex in the bucket
+		int32_t  BaseVertex  = 0;
+		// The offset of the mesh's first index in the bucket, LOD and meshlet ranges are relative to this
+		uint32_t FirstIndex  = 0;
+		uint32_t VertexCount = 0;
+		uint32_t IndexCount  = 0;
+	};
+
+	/// <summary>
+	/// Counters for how much of the pool is in use
+	/// </summary>
+	struct Stats {
+		// The number of distinct vertex layouts, each is drawn from it's own VAO
+		uint32_t Buckets     = 0;
+		// The number of meshes stored in the pool
+		uint32_t Meshes      = 0;
+		// The number of bytes used by vertices and indices, not including free space
+		uint32_t VertexBytes = 0;
+		uint32_t IndexBytes  = 0;
+	};
+
+	/// <summary>
+	/// Creates an empty pool, buckets will be created as meshes are added
+	/// </summary>
+	/// <param name="initialVertexBytes">The size of the vertex buffer when a bucket is created</param>
+	/// <param name="initialIndexBytes">The size of the index buffer when a bucket is created</param>
+	MeshPool(uint32_t initialVertexBytes = 4 * 1024 * 1024, uint32_t initialIndexBytes = 1024 * 1024);
+	~MeshPool();
+
+	/// <summary>
+	/// Gets the location of a mesh in the pool, copying it in if this is the first time we've seen it.
+	/// Meshes with more than one vertex buffer, or with per instance attributes, can't be pooled
+	/// </summary>
+	/// <param name="mesh">The mesh to look up</param>
+	/// <returns>The mesh's entry, or nullptr if it can't be pooled. Valid until the next call to CollectGarbage</returns>
+	const Entry* Get(const VertexArrayObject::Sptr& mesh);
+
+	/// <summary>
+	/// Gets the VAO that draws all the meshes in a bucket
+	/// </summary>
+	static const VertexArrayObject::Sptr& GetVao(const Bucket* bucket);
+
+	/// <summary>
+	/// Releases the space of any meshes that have been destroyed since the last call
+	/// </summary>
+	void CollectGarbage();
+
+	/// <summary>
+	/// Makes sure that draws can use base instances up to count - 1
+	/// </summary>
+	/// <param name="count">The number of instances that will be drawn this frame</param>
+	void ReserveInstances(uint32_t count);
+
+	/// <summary>
+	/// Gets the current usage of the pool
+	/// </summary>
+	Stats GetStats() const;
+
+protected:
+	/// <summary>
+	/// Hands out ranges of elements from a buffer, re-using the space of released ranges
+	/// </summary>
+	struct RangeAllocator {
+		uint32_t Capacity = 0;
+		// Everything past this point has never been handed out
+		uint32_t End      = 0;
+		// Released ranges as (offset, count), sorted by offset
+		std::vector<std::pair<uint32_t, uint32_t>> FreeRanges;
+
+		// Returns false if there is no room, the caller should grow the buffer and try again
+		bool Allocate(uint32_t count, uint32_t& offset);
+		void Release(uint32_t offset, uint32_t count);
+	};
+
+	// Remembers where a mesh was copied from, so we can notice if it's buffers change or it's destroyed
+	struct Record {
+		VertexArrayObject::Wptr Mesh;
+		const IBuffer*          SourceVertices = nullptr;
+		const IBuffer*          SourceIndices  = nullptr;
+		Entry                   Location;
+	};
+
+	uint32_t _initialVertexBytes;
+	uint32_t _initialIndexBytes;
+
+	std::vector<std::unique_ptr<Bucket>> _buckets;
+	std::unordered_map<const VertexArrayObject*, Record> _records;
+
+	// Holds 0, 1, 2 ... so that the instance ID attribute reads back the base instance of each draw
+	VertexBuffer::Sptr _instanceIds;
+	uint32_t           _instanceCapacity;
+
+	// Copies a mesh into the bucket for it's layout, returning false if it can't be pooled
+	bool _Add(VertexArrayObject& mesh, Record& record);
+	// Gives the space of a mesh back to it's bucket
+	void _Release(const Entry& entry);
+	// Finds or creates the bucket for a vertex layout
+	Bucket* _FindBucket(const std::vector<BufferAttribute>& attributes, uint32_t stride, IndexType indexType);
+	// Grows a bucket's buffers so they have room for the given number of vertices and indices
+	void _GrowVertices(Bucket& bucket, uint32_t vertexCount);
+	void _GrowIndices(Bucket& bucket, uint32_t indexCount);
+	// Re-creates a bucket's VAO, needed whenever it's buffers are replaced
+	void _BuildVao(Bucket& bucket);
+	// Attaches the instance ID buffer to a bucket's VAO
+	void _BindInstanceIds(Bucket& bucket);
+};
@@ -0,0 +1,74 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+RenderQueue::RenderQueue() :
+	_items(),
+	_scratch()
+{ }
+
+RenderQueue::~RenderQueue() = default;
+
+uint64_t RenderQueue::MakeSortKey(RenderPass pass, uint32_t shaderId, uint32_t materialId, uint32_t vaoId, uint32_t lod, float depth)
+{
+	constexpr uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+
+	// Quantize the depth into our available bits
+	uint32_t depthBits = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+	// Transparent objects need to be drawn back to front, so we flip their depth
+	if (pass == RenderPass::Transparent) {
+		depthBits = maxDepth - depthBits;
+	}
+
+	uint64_t result = 0;
+	result |= (static_cast<uint64_t>(pass)       & ((1ull << PASS_BITS) - 1))     << (SHADER_BITS + MATERIAL_BITS + VAO_BITS + LOD_BITS + DEPTH_BITS);
+	result |= (static_cast<uint64_t>(shaderId)   & ((1ull << SHADER_BITS) - 1))   << (MATERIAL_BITS + VAO_BITS + LOD_BITS + DEPTH_BITS);
+	result |= (static_cast<uint64_t>(materialId) & ((1ull << MATERIAL_BITS) - 1)) << (VAO_BITS + LOD_BITS + DEPTH_BITS);
+	result |= (static_cast<uint64_t>(vaoId)      & ((1ull << VAO_BITS) - 1))      << (LOD_BITS + DEPTH_BITS);
+	result |= (static_cast<uint64_t>(lod)        & ((1ull << LOD_BITS) - 1))      << DEPTH_BITS;
+	result |= static_cast<uint64_t>(depthBits);
+	return result;
+}
+
+void RenderQueue::Clear() {
+	_items.clear();
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t index) {
+	_items.push_back({ key, index });
+}
+
+void RenderQueue::Sort()
+{
+	if (_items.size() < 2) {
+		return;
+	}
+
+	_scratch.resize(_items.size());
+
+	// We sort 8 bits at a time, starting from the least significant byte. Since
+	// each pass is stable, the result is sorted by the full key
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = { 0 };
+		for (const RenderQueueItem& item : _items) {
+			counts[(item.SortKey >> shift) & 0xFF]++;
+		}
+
+		// If every key has the same value for this byte, the pass would not change anything
+		if (counts[(_items[0].SortKey >> shift) & 0xFF] == _items.size()) {
+			continue;
+		}
+
+		// Convert counts into starting offsets
+		size_t offset = 0;
+		for (size_t& count : counts) {
+			size_t temp = count;
+			count = offset;
+			offset += temp;
+		}
+
+		for (const RenderQueueItem& item : _items) {
+			_scratch[counts[(item.SortKey >> shift) & 0xFF]++] = item;
+		}
+		_items.swap(_scratch);
+	}
+}
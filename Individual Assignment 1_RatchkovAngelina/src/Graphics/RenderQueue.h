@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <EnumToString.h>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// The passes that a draw can be submitted to, in the order they will be drawn
+/// </summary>
+ENUM(RenderPass, uint8_t,
+	Opaque      = 0,
+	Transparent = 1
+);
+
+/// <summary>
+/// A single entry in the render queue, pairing a sort key with an index into
+/// whatever list of draws the owner of the queue is building
+/// </summary>
+struct RenderQueueItem {
+	uint64_t SortKey;
+	uint32_t Index;
+};
+
+/// <summary>
+/// A render queue sorts draws by a packed 64-bit key, so that draws sharing
+/// a shader, material, mesh and level of detail end up next to each other. The key is laid out as
+/// (from most to least significant bits):
+///    | pass (4) | shader (12) | material (16) | vao (12) | lod (2) | depth (18) |
+/// </summary>
+class RenderQueue final {
+public:
+	MAKE_PTRS(RenderQueue);
+
+	static constexpr uint32_t PASS_BITS     = 4;
+	static constexpr uint32_t SHADER_BITS   = 12;
+	static constexpr uint32_t MATERIAL_BITS = 16;
+	static constexpr uint32_t VAO_BITS      = 12;
+	static constexpr uint32_t LOD_BITS      = 2;
+	static constexpr uint32_t DEPTH_BITS    = 18;
+
+	RenderQueue();
+	~RenderQueue();
+
+	/// <summary>
+	/// Packs a sort key for a single draw
+	/// </summary>
+	/// <param name="pass">The pass that the draw belongs to</param>
+	/// <param name="shaderId">An ID for the shader, only the lower 12 bits are used</param>
+	/// <param name="materialId">An ID for the material, only the lower 16 bits are used</param>
+	/// <param name="vaoId">An ID for the mesh VAO, only the lower 12 bits are used</param>
+	/// <param name="lod">The level of detail of the mesh to draw, only the lower 2 bits are used</param>
+	/// <param name="depth">The normalized depth of the object from the camera, in the range [0, 1]</param>
+	/// <returns>The packed key</returns>
+	static uint64_t MakeSortKey(RenderPass pass, uint32_t shaderId, uint32_t materialId, uint32_t vaoId, uint32_t lod, float depth);
+
+	/// <summary>
+	/// Removes all items from the queue, without releasing memory
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Adds a draw to the queue
+	/// </summary>
+	/// <param name="key">The sort key for the draw, see MakeSortKey</param>
+	/// <param name="index">The index of the draw in the owner's list</param>
+	void Push(uint64_t key, uint32_t index);
+
+	/// <summary>
+	/// Sorts the queue in ascending key order, using an LSD radix sort
+	/// </summary>
+	void Sort();
+
+	size_t Size() const { return _items.size(); }
+	bool   Empty() const { return _items.empty(); }
+
+	const RenderQueueItem& operator[](size_t ix) const { return _items[ix]; }
+
+	std::vector<RenderQueueItem>::const_iterator begin() const { return _items.cbegin(); }
+	std::vector<RenderQueueItem>::const_iterator end() const { return _items.cend(); }
+
+protected:
+	std::vector<RenderQueueItem> _items;
+	// Scratch space for the radix sort, kept around to avoid re-allocating each frame
+	std::vector<RenderQueueItem> _scratch;
+};
@@ -1,22 +1,55 @@
 #include "ShaderProgram.h"
 #include "Logging.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <cstdio>
+#include <cstdlib>
 
 #include "Utils/FileHelpers.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/Hash.h"
+#include "Graphics/GlState.h"
+
+bool ShaderProgram::__binaryCacheEnabled = true;
+std::string ShaderProgram::__binaryCacheDirectory = "shader_cache";
+std::vector<std::string> ShaderProgram::__keywordNames;
+uint32_t ShaderProgram::__globalKeywords = 0;
+
+namespace {
+	// Written at the start of every cached program, so we can reject files from other versions of the cache
+	struct ProgramBinaryHeader {
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;
+		GLenum   Format;
+		uint32_t Length;
+	};
+	constexpr uint32_t PROGRAM_BINARY_MAGIC   = 0x43425053; // "SPBC"
+	constexpr uint32_t PROGRAM_BINARY_VERSION = 1;
+
+	std::filesystem::path GetBinaryCachePath(const std::string& directory, uint64_t key) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+		return std::filesystem::path(directory) / name;
+	}
+}
 
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_interleavedVaryings(true),
+	_keywords(0)
 {
 	_rendererId = glCreateProgram();
 }
 
 ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_interleavedVaryings(true),
+	_keywords(0)
 {
 	_rendererId = glCreateProgram();
 	for (auto& [type, path] : filePaths) {
@@ -27,17 +60,61 @@ ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::strin
 
 ShaderProgram::~ShaderProgram() {
 	if (_rendererId != 0) {
+		GlState::OnProgramDeleted(_rendererId);
 		glDeleteProgram(_rendererId);
 		_rendererId = 0;
 	}
 }
 
 bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
+	if (source == nullptr || source[0] == '\0') {
+		LOG_WARN("Ignoring empty source for {} shader", ~type);
+		return false;
+	}
+
+	// If we're overwriting, warn so that the user knows the old source is gone
+	if (_sources.find(type) != _sources.end()) {
+		LOG_WARN("Another shader has been attached to this slot, overwriting");
+	}
+	// We hold on to the source until we know if we need to compile it
+	_sources[type] = source;
+	_keywords |= _FindKeywords(_sources[type]);
+	_FindDefaults(_sources[type], _uniformDefaults);
+
+	// Store info about where we got this data from
+	_fileSourceMap[type].IsFilePath = false;
+	_fileSourceMap[type].Source = source;
+
+	return true;
+}
+
+bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
+	// Make sure that the file exists before we try reading
+	if (std::filesystem::exists(path)) {
+		// Load the source from the file, using our helper that will
+		// resolve #include directives
+		std::string source = FileHelpers::ReadResolveIncludes(path);
+		// Pass off to LoadShaderPart
+		bool result =  LoadShaderPart(source.c_str(), type);
+		_fileSourceMap[type].IsFilePath = true;
+		_fileSourceMap[type].Source = path;
+		if (result == false) {
+			LOG_ERROR("Source File: {}", path);
+		}
+		return result; 
+	} else {
+		LOG_WARN("Could not open file at \"{}\"", path);
+		return false;
+	}
+}
+
+GLuint ShaderProgram::_CompileShaderPart(ShaderPartType type, const std::string& source) {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader((GLenum)type);
 
 	// Load the GLSL source and compile it
-	glShaderSource(handle, 1, &source, nullptr);
+	const char* sourcePtr = source.c_str();
+	glShaderSource(handle, 1, &sourcePtr, nullptr);
 	glCompileShader(handle);
 
 	// Get the compilation status for the shader part
@@ -57,6 +134,9 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 
 		// Dump error log
 		LOG_ERROR("Failed to compile shader part:\n{}", log);
+		if (_fileSourceMap[type].IsFilePath) {
+			LOG_ERROR("Source File: {}", _fileSourceMap[type].Source);
+		}
 
 		// Clean up our log memory
 		delete[] log;
@@ -64,68 +144,76 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 		// Delete the broken shader result
 		glDeleteShader(handle);
 		handle = 0;
-
-		return false;
 	}
 
-	// If we're overwriting, warn and clean up the old program before we store
-	if (_handles[type] != 0) {
-		LOG_WARN("Another shader has been attached to this slot, overwriting");
-		glDeleteShader(_handles[type]);
-	}
-	_handles[type] = handle;
+	return handle;
+}
 
-	// Store info about where we got this data from
-	_fileSourceMap[type].IsFilePath = false;
-	_fileSourceMap[type].Source = source;
+bool ShaderProgram::Link() {
 
-	return status != GL_FALSE;
-}
+	LOG_TRACE("Starting shader link:");
+	for (auto& [type, source] : _sources) {
+		LOG_TRACE("\t{} - {}", ~type, _fileSourceMap[type].IsFilePath ? _fileSourceMap[type].Source : "<from source>");
+	}
 
-bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
-	// Make sure that the file exists before we try reading
-	if (std::filesystem::exists(path)) {
-		// Load the source from the file, using our helper that will
-		// resolve #include directives
-		std::string source = FileHelpers::ReadResolveIncludes(path);
-		// Pass off to LoadShaderPart
-		bool result =  LoadShaderPart(source.c_str(), type);
-		_fileSourceMap[type].IsFilePath = true;
-		_fileSourceMap[type].Source = path;
-		if (result == false) {
-			LOG_ERROR("Source File: {}", path);
+	// We get linked with every keyword we declare, so materials can see every uniform that any of our variants could use
+	if (_keywords != 0) {
+		_variantSources = _sources;
+		for (auto& [type, source] : _sources) {
+			source = _DefineKeywords(source, _keywords);
 		}
-		return result; 
+	}
+
+	// Try the cache first, we only need to compile anything if we've never linked these sources on this driver before
+	const uint64_t cacheKey = __binaryCacheEnabled ? _GetBinaryCacheKey() : 0;
+	bool linked = cacheKey != 0 && _LoadProgramBinary(cacheKey);
+	if (linked) {
+		LOG_TRACE("Loaded program from binary cache ({:016x})", cacheKey);
 	} else {
-		LOG_WARN("Could not open file at \"{}\"", path);
-		return false;
+		linked = _LinkFromSource();
+		if (linked && cacheKey != 0) {
+			_SaveProgramBinary(cacheKey);
+		}
 	}
-}
 
-bool ShaderProgram::Link() {
+	// We don't need the sources anymore, the file source map still remembers where they came from
+	_sources.clear();
 
-	LOG_TRACE("Starting shader link:");
-	
-	// Attach all our shaders
-	for (auto& [type, id] : _handles) {
-		if (id != 0) {
-			glAttachShader(_rendererId, id);
-			LOG_TRACE("\t{} - {}", ~type, _fileSourceMap[type].IsFilePath ? _fileSourceMap[type].Source : "<from source>");
+	if (linked) {
+		LOG_TRACE("Linking complete, starting introspection");
+	}
+
+	// Perform our uniform introspection to see what uniforms are in the shader
+	_Introspect();
+
+	return linked;
+}
+
+bool ShaderProgram::_LinkFromSource() {
+	// Compile and attach all our shaders
+	std::vector<GLuint> handles;
+	bool compiled = true;
+	for (auto& [type, source] : _sources) {
+		GLuint handle = _CompileShaderPart(type, source);
+		if (handle == 0) {
+			compiled = false;
+			continue;
 		}
+		glAttachShader(_rendererId, handle);
+		handles.push_back(handle);
 	}
 
+	// We only want to be able to read back binaries that we're going to cache
+	glProgramParameteri(_rendererId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, __binaryCacheEnabled ? GL_TRUE : GL_FALSE);
+
 	// Perform linking
 	glLinkProgram(_rendererId);
 
 	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
-	for (auto& [type, id] : _handles) { 
-		if (id != 0) {
-			glDetachShader(_rendererId, id);
-			glDeleteShader(id);
-		}
+	for (GLuint handle : handles) {
+		glDetachShader(_rendererId, handle);
+		glDeleteShader(handle);
 	}
-	// Remove all the handles so we don't accidentally use them
-	_handles.clear();
 
 	GLint status = 0;
 	glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
@@ -146,24 +234,280 @@ bool ShaderProgram::Link() {
 		} else {
 			LOG_ERROR("Shader failed to link for an unknown reason!");
 		}
-	} else {
-		LOG_TRACE("Linking complete, starting introspection");
 	}
 
-	// Perform our uniform introspection to see what uniforms are in the shader
-	_Introspect();
+	return compiled && status != GL_FALSE;
+}
+
+uint64_t ShaderProgram::_GetBinaryCacheKey() const {
+	// Binaries are only valid for the exact driver that made them, and drivers without
+	// any binary formats can't give us one at all
+	static const std::string driver = []() {
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		if (numFormats == 0) {
+			LOG_WARN("Driver does not support program binaries, shaders will always be compiled");
+			return std::string();
+		}
+		const char* vendor   = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
+		const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		const char* version  = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+		return std::string(vendor ? vendor : "") + "|" + (renderer ? renderer : "") + "|" + (version ? version : "");
+	}();
+	if (driver.empty() || _sources.empty()) {
+		return 0;
+	}
+
+	Fnv1aHash hash;
+	hash.AddValue(PROGRAM_BINARY_VERSION);
+	hash.Add(driver);
+	for (auto& [type, source] : _sources) {
+		hash.AddValue(type);
+		hash.Add(source);
+	}
+	hash.AddValue(static_cast<uint32_t>(_varyings.size()));
+	for (const std::string& varying : _varyings) {
+		hash.Add(varying);
+	}
+	hash.AddValue(_interleavedVaryings);
 
-	return status != GL_FALSE;
+	// 0 means no key, so nudge the rare hash that lands on it
+	return hash.Value != 0 ? hash.Value : 1;
+}
+
+bool ShaderProgram::_LoadProgramBinary(uint64_t key) {
+	const std::filesystem::path path = GetBinaryCachePath(__binaryCacheDirectory, key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	ProgramBinaryHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(ProgramBinaryHeader));
+	if (!file || header.Magic != PROGRAM_BINARY_MAGIC || header.Version != PROGRAM_BINARY_VERSION || header.Key != key) {
+		LOG_WARN("Ignoring invalid shader cache file \"{}\"", path.string());
+		return false;
+	}
+
+	std::vector<char> binary(header.Length);
+	file.read(binary.data(), header.Length);
+	if (!file) {
+		LOG_WARN("Shader cache file \"{}\" is truncated", path.string());
+		return false;
+	}
+
+	// The driver may still reject the binary (ex: after an update that kept the version string), in which
+	// case the program is left unlinked and we can compile it as normal
+	glProgramBinary(_rendererId, header.Format, binary.data(), static_cast<GLsizei>(header.Length));
+	GLint status = 0;
+	glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		LOG_INFO("Driver rejected cached shader binary \"{}\", recompiling", path.string());
+		return false;
+	}
+	return true;
+}
+
+void ShaderProgram::_SaveProgramBinary(uint64_t key) {
+	GLint length = 0;
+	glGetProgramiv(_rendererId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	ProgramBinaryHeader header;
+	header.Magic = PROGRAM_BINARY_MAGIC;
+	header.Version = PROGRAM_BINARY_VERSION;
+	header.Key = key;
+	std::vector<char> binary(length);
+	glGetProgramBinary(_rendererId, length, &length, &header.Format, binary.data());
+	header.Length = static_cast<uint32_t>(length);
+
+	std::error_code error;
+	std::filesystem::create_directories(__binaryCacheDirectory, error);
+	const std::filesystem::path path = GetBinaryCachePath(__binaryCacheDirectory, key);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		LOG_WARN("Failed to write shader cache file \"{}\"", path.string());
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(ProgramBinaryHeader));
+	file.write(binary.data(), header.Length);
+}
+
+ShaderProgram* ShaderProgram::GetVariant(uint32_t keywords) {
+	keywords &= _keywords;
+	if (keywords == _keywords) {
+		return this;
+	}
+
+	auto it = _variants.find(keywords);
+	if (it != _variants.end()) {
+		return it->second.get();
+	}
+
+	// First time we've needed this combination, build it from our original sources
+	Sptr variant = std::make_shared<ShaderProgram>();
+	std::string name = GetDebugName() + " [";
+	for (const std::string& keyword : GetKeywordNames(keywords)) {
+		name += " " + keyword;
+	}
+	variant->SetDebugName(name + " ]");
+	LOG_INFO("Compiling shader variant \"{}\"", variant->GetDebugName());
+
+	for (auto& [type, source] : _variantSources) {
+		variant->_sources[type] = _DefineKeywords(source, keywords);
+		variant->_fileSourceMap[type] = _fileSourceMap[type];
+	}
+	if (!_varyings.empty()) {
+		std::vector<const char*> names;
+		for (const std::string& varying : _varyings) {
+			names.push_back(varying.c_str());
+		}
+		variant->RegisterVaryings(names.data(), static_cast<int>(names.size()), _interleavedVaryings);
+	}
+	variant->Link();
+
+	_variants[keywords] = variant;
+	return variant.get();
+}
+
+uint32_t ShaderProgram::GetKeywordMask(const std::string& name) {
+	auto it = std::find(__keywordNames.begin(), __keywordNames.end(), name);
+	if (it != __keywordNames.end()) {
+		return 1u << static_cast<uint32_t>(it - __keywordNames.begin());
+	}
+	if (__keywordNames.size() >= 32) {
+		LOG_WARN("Ran out of shader keywords, ignoring \"{}\"", name);
+		return 0;
+	}
+	__keywordNames.push_back(name);
+	return 1u << static_cast<uint32_t>(__keywordNames.size() - 1);
+}
+
+std::vector<std::string> ShaderProgram::GetKeywordNames(uint32_t keywords) {
+	std::vector<std::string> result;
+	for (uint32_t ix = 0; ix < __keywordNames.size(); ix++) {
+		if (keywords & (1u << ix)) {
+			result.push_back(__keywordNames[ix]);
+		}
+	}
+	return result;
+}
+
+void ShaderProgram::SetGlobalKeywords(uint32_t keywords) {
+	__globalKeywords = keywords;
+}
+
+uint32_t ShaderProgram::GetGlobalKeywords() {
+	return __globalKeywords;
+}
+
+std::string ShaderProgram::_DefineKeywords(const std::string& source, uint32_t keywords) {
+	std::string defines;
+	for (const std::string& keyword : GetKeywordNames(keywords)) {
+		defines += "#define " + keyword + "\n";
+	}
+	if (defines.empty()) {
+		return source;
+	}
+
+	// Nothing but comments may come before the #version directive
+	size_t versionLine = source.find("#version");
+	if (versionLine == std::string::npos) {
+		return defines + source;
+	}
+	size_t eol = source.find('\n', versionLine);
+	if (eol == std::string::npos) {
+		return source + "\n" + defines;
+	}
+	std::string result = source;
+	result.insert(eol + 1, defines);
+	return result;
+}
+
+uint32_t ShaderProgram::_FindKeywords(const std::string& source) {
+	const std::string token = "#pragma keyword";
+	uint32_t result = 0;
+	for (size_t seek = source.find(token); seek != std::string::npos; seek = source.find(token, seek + token.size())) {
+		size_t eol = source.find_first_of("\r\n", seek);
+		std::stringstream names(source.substr(seek + token.size(), eol == std::string::npos ? std::string::npos : eol - seek - token.size()));
+
+		// A declaration can list more than one keyword
+		std::string name;
+		while (names >> name) {
+			result |= GetKeywordMask(name);
+		}
+	}
+	return result;
+}
+
+void ShaderProgram::_FindDefaults(const std::string& source, std::unordered_map<std::string, std::vector<double>>& defaults) {
+	const std::string token = "#pragma default";
+	for (size_t seek = source.find(token); seek != std::string::npos; seek = source.find(token, seek + token.size())) {
+		size_t eol = source.find_first_of("\r\n", seek);
+		std::stringstream line(source.substr(seek + token.size(), eol == std::string::npos ? std::string::npos : eol - seek - token.size()));
+
+		// The name, followed by a value for each component
+		std::string name;
+		if (!(line >> name)) {
+			continue;
+		}
+		std::vector<double> values;
+		std::string value;
+		while (line >> value) {
+			if (value == "true" || value == "false") {
+				values.push_back(value == "true" ? 1.0 : 0.0);
+			} else {
+				char* end = nullptr;
+				double number = strtod(value.c_str(), &end);
+				if (end == value.c_str()) {
+					LOG_WARN("Ignoring default \"{}\" for uniform \"{}\", it is not a number", value, name);
+					continue;
+				}
+				values.push_back(number);
+			}
+		}
+		defaults[name] = values;
+	}
+}
+
+const std::vector<double>* ShaderProgram::GetUniformDefault(const std::string& name) const {
+	auto it = _uniformDefaults.find(name);
+	return it != _uniformDefaults.end() ? &it->second : nullptr;
+}
+
+int ShaderProgram::GetUniformLocation(const std::string& name) const {
+	return GetUniformLocation(UniformId(name));
+}
+
+int ShaderProgram::GetUniformLocation(UniformId id) const {
+	auto it = std::lower_bound(_uniformIds.begin(), _uniformIds.end(), id, [](const UniformHandle& handle, UniformId value) {
+		return handle.Id < value;
+	});
+	return (it != _uniformIds.end() && it->Id == id) ? it->Location : -1;
+}
+
+void ShaderProgram::SetBinaryCacheEnabled(bool value) {
+	__binaryCacheEnabled = value;
+}
+
+bool ShaderProgram::IsBinaryCacheEnabled() {
+	return __binaryCacheEnabled;
+}
+
+void ShaderProgram::SetBinaryCacheDirectory(const std::string& path) {
+	__binaryCacheDirectory = path;
 }
 
 void ShaderProgram::Bind() {
-	// Simply calls glUseProgram with our shader handle
-	glUseProgram(_rendererId);
+	// Simply calls glUseProgram with our shader handle, if it's not already in use
+	GlState::UseProgram(_rendererId);
 }
 
 void ShaderProgram::Unbind() {
 	// We unbind a shader program by using the default program (0)
-	glUseProgram(0);
+	GlState::UseProgram(0);
 }
 
 void ShaderProgram::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
@@ -306,11 +650,8 @@ void ShaderProgram::SetUniform(int location, ShaderDataType type, void* data, in
 	}
 }
 
-int ShaderProgram::__GetUniformLocation(const std::string& name) {
-	// Since the default constructor for UniformInfo sets location to -1,
-	// we can simply index the map and if it doesn't exist, the default
-	// will be used
-	return _uniforms[name].Location;
+int ShaderProgram::__GetUniformLocation(const std::string& name) const {
+	return GetUniformLocation(UniformId(name));
 }
 
 nlohmann::json ShaderProgram::ToJson() const {
@@ -403,6 +744,21 @@ void ShaderProgram::_IntrospectUniforms() {
 		// Store the uniform info
 		_uniforms[e.Name] = e;
 	}
+
+	// Build the sorted ID table, this is what all of our uniform lookups actually go through
+	_uniformIds.clear();
+	_uniformIds.reserve(_uniforms.size());
+	for (const auto& [name, uniform] : _uniforms) {
+		_uniformIds.push_back({ UniformId(name), uniform.Location });
+	}
+	std::sort(_uniformIds.begin(), _uniformIds.end(), [](const UniformHandle& a, const UniformHandle& b) {
+		return a.Id < b.Id;
+	});
+	for (size_t ix = 1; ix < _uniformIds.size(); ix++) {
+		if (_uniformIds[ix].Id == _uniformIds[ix - 1].Id) {
+			LOG_ERROR("Two uniforms in \"{}\" have the same ID, one of them can't be set by name", GetDebugName());
+		}
+	}
 }
 
 void ShaderProgram::_IntrospectUnifromBlocks() {
@@ -460,17 +816,21 @@ void ShaderProgram::_IntrospectUnifromBlocks() {
 				GL_NAME_LENGTH,
 				GL_TYPE,
 				GL_ARRAY_SIZE,
-				GL_OFFSET
+				GL_OFFSET,
+				GL_ARRAY_STRIDE,
+				GL_MATRIX_STRIDE
 			};
 			// Query data from the program
-			int props[4];
-			glGetProgramResourceiv(_rendererId, GL_UNIFORM, activeVars[v], 4, pNames, 4, NULL, props);
+			int props[6];
+			glGetProgramResourceiv(_rendererId, GL_UNIFORM, activeVars[v], 6, pNames, 6, NULL, props);
 
 			// Store properties into the UniformInfo
 			UniformInfo var = UniformInfo();
 			var.Type = FromGLShaderDataType(props[1]);
 			var.Location = props[3];
 			var.ArraySize = props[2];
+			var.ArrayStride = props[4];
+			var.MatrixStride = props[5];
 
 			// Get the uniform name
 			var.Name.resize(props[0] - 1);
@@ -501,16 +861,20 @@ void ShaderProgram::BindUniformBlockToSlot(const std::string& name, int uboSlot)
 	}
 }
 
+const ShaderProgram::UniformBlockInfo* ShaderProgram::GetUniformBlock(const std::string& name) const {
+	auto it = _uniformBlocks.find(name);
+	return it != _uniformBlocks.end() ? &it->second : nullptr;
+}
+
 bool ShaderProgram::FindUniform(const std::string& name, UniformInfo* out) {
-	for (auto& [key, uniform] : _uniforms) {
-		if (uniform.Name == name) {
-			if (out != nullptr) {
-				*out = uniform;
-			}
-			return true;
-		}
+	auto it = _uniforms.find(name);
+	if (it == _uniforms.end()) {
+		return false;
 	}
-	return false;
+	if (out != nullptr) {
+		*out = it->second;
+	}
+	return true;
 }
 
 GlResourceType ShaderProgram::GetResourceClass() const {
@@ -520,4 +884,8 @@ GlResourceType ShaderProgram::GetResourceClass() const {
 void ShaderProgram::RegisterVaryings(const char* const* names, int numVaryings, bool interleaved /*= true*/)
 {
 	glTransformFeedbackVaryings(_rendererId, numVaryings, names, interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+
+	// Keep a copy for the cache key, since the same sources with different varyings link differently
+	_varyings.assign(names, names + numVaryings);
+	_interleavedVaryings = interleaved;
 }
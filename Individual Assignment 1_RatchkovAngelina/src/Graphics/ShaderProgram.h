@@ -1,7 +1,9 @@
 #pragma once
 #include <glad/glad.h>
 #include <memory>
+#include <map>                  // for std::map
 #include <string>               // for std::string
+#include <vector>               // for std::vector
 #include <unordered_map>        // for std::unordered_map
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
@@ -11,9 +13,35 @@
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/GlEnums.h"
 #include "Graphics/IGraphicsResource.h"
+#include "Utils/Hash.h"
+
+/// <summary>
+/// A uniform name interned as it's FNV-1a hash, so that uniforms can be found without hashing or comparing strings.
+/// Declare these as constexpr and the name is hashed by the compiler:
+///     static constexpr UniformId GravityId("u_Gravity");
+/// </summary>
+struct UniformId {
+	uint64_t Value;
+
+	constexpr UniformId() : Value(0) {}
+	template <size_t N>
+	constexpr explicit UniformId(const char(&name)[N]) : Value(Fnv1aHash::Of(name, N - 1)) {}
+	explicit UniformId(const std::string& name) : Value(Fnv1aHash::Of(name.data(), name.size())) {}
+
+	constexpr bool operator==(const UniformId& other) const { return Value == other.Value; }
+	constexpr bool operator!=(const UniformId& other) const { return Value != other.Value; }
+	constexpr bool operator<(const UniformId& other) const { return Value < other.Value; }
+};
 
 /// <summary>
 /// This class will wrap around an OpenGL shader program
+/// 
+/// Shaders can declare compile time keywords with a "#pragma keyword NAME" line, and check for them with
+/// #ifdef NAME. The program itself is linked with all of it's keywords defined, and the variants for
+/// other combinations of keywords are compiled the first time they are requested with GetVariant
+///
+/// Members of a uniform block can't have initializers, so shaders can give them a default value with a
+/// "#pragma default NAME VALUE..." line instead, see GetUniformDefault
 /// </summary>
 class ShaderProgram final : public IGraphicsResource, public IResource
 {
@@ -31,6 +59,9 @@ public:
 		int            ArraySize;
 		int            Location;
 		int            Binding;
+		// For uniforms in a block, the bytes between array elements and between matrix columns
+		int            ArrayStride;
+		int            MatrixStride;
 		std::string    Name;
 
 		UniformInfo() :
@@ -38,6 +69,8 @@ public:
 			ArraySize(0),
 			Location(-1),
 			Binding(-1),
+			ArrayStride(0),
+			MatrixStride(0),
 			Name("") {}
 	};
 
@@ -71,6 +104,8 @@ public:
 
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// The source is not compiled until Link is called, and is skipped entirely if the linked
+	/// program is found in the binary cache. Compile errors will be reported by Link
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -93,11 +128,54 @@ public:
 	void RegisterVaryings(const char* const* names, int numVaryings, bool interleaved = true);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. If a program
+	/// with the same sources was linked on a previous run, it's binary is loaded from the cache instead
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
 
+	/// <summary>
+	/// Gets the variant of this program with the given keywords defined, compiling it if this is the first time it's
+	/// been requested. Keywords that this program doesn't declare are ignored, so shaders without keywords just return themselves
+	/// </summary>
+	/// <param name="keywords">A mask of keywords, see GetKeywordMask</param>
+	/// <returns>The variant, owned by this program</returns>
+	ShaderProgram* GetVariant(uint32_t keywords);
+	/// <summary>
+	/// Gets the mask of all the keywords that this program's sources declare
+	/// </summary>
+	uint32_t GetKeywords() const { return _keywords; }
+	/// <summary>
+	/// Gets the number of variants that have been compiled for this program, not including itself
+	/// </summary>
+	size_t GetVariantCount() const { return _variants.size(); }
+
+	/// <summary>
+	/// Gets the bit for a keyword, registering it if it hasn't been seen yet. There can be at most 32 keywords
+	/// </summary>
+	/// <param name="name">The name of the keyword, as it appears in the shader</param>
+	/// <returns>The bit for the keyword, or 0 if we've run out of bits</returns>
+	static uint32_t GetKeywordMask(const std::string& name);
+	/// <summary>
+	/// Gets the names of all the keywords in a mask
+	/// </summary>
+	static std::vector<std::string> GetKeywordNames(uint32_t keywords);
+	/// <summary>
+	/// Sets the keywords that are enabled for everything drawn this frame, ex: by the render flags
+	/// </summary>
+	static void SetGlobalKeywords(uint32_t keywords);
+	static uint32_t GetGlobalKeywords();
+
+	/// <summary>
+	/// Enables or disables the on disk cache of linked programs, enabled by default
+	/// </summary>
+	static void SetBinaryCacheEnabled(bool value);
+	static bool IsBinaryCacheEnabled();
+	/// <summary>
+	/// Sets the folder that linked program binaries are stored in, relative to the working directory
+	/// </summary>
+	static void SetBinaryCacheDirectory(const std::string& path);
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -108,6 +186,24 @@ public:
 	static void Unbind();
 
 	const std::unordered_map<std::string, UniformInfo>& GetUniforms() const { return _uniforms; }
+	/// <summary>
+	/// Gets a uniform block by name, or nullptr if the program doesn't have it. The Location of each of
+	/// the block's uniforms is it's offset within the block
+	/// </summary>
+	const UniformBlockInfo* GetUniformBlock(const std::string& name) const;
+	/// <summary>
+	/// Gets the location of a uniform by name, or -1 if the program doesn't have it
+	/// </summary>
+	int GetUniformLocation(const std::string& name) const;
+	/// <summary>
+	/// Gets the location of a uniform by it's interned name, or -1 if the program doesn't have it
+	/// </summary>
+	int GetUniformLocation(UniformId id) const;
+	/// <summary>
+	/// Gets the default value declared for a uniform with "#pragma default", one entry per component (bools
+	/// are 0 or 1), or nullptr if the sources don't declare one
+	/// </summary>
+	const std::vector<double>* GetUniformDefault(const std::string& name) const;
 
 	// Inherited from IGraphicsResource
 
@@ -173,17 +269,52 @@ public:
 			LOG_WARN("Ignoring uniform \"{}\"", name);
 		}
 	}
+
+	// These skip the name lookup entirely, prefer them for uniforms that are set every frame
+	template <typename T>
+	void SetUniform(UniformId id, const T& value) {
+		int location = GetUniformLocation(id);
+		if (location != -1) {
+			SetUniform(location, &value, 1);
+		}
+	}
+	template <typename T>
+	void SetUniformMatrix(UniformId id, const T& value, bool transposed = false) {
+		int location = GetUniformLocation(id);
+		if (location != -1) {
+			SetUniformMatrix(location, &value, 1, transposed);
+		}
+	}
 	
 	void BindUniformBlockToSlot(const std::string& name, int uboSlot);
 
 protected:
-	// Stores all the handles to our shaders until we
-	// are ready to compile them into a program
-	std::unordered_map<ShaderPartType, int> _handles;
+	// Stores the resolved source of our shader parts until we are ready to link them
+	// Ordered by type so that the cache key doesn't depend on the order parts were loaded in
+	std::map<ShaderPartType, std::string> _sources;
+
+	// The transform feedback outputs registered with RegisterVaryings, these change the linked program as well
+	std::vector<std::string> _varyings;
+	bool                     _interleavedVaryings;
+
+	// The keywords declared in our sources
+	uint32_t _keywords;
+	// For programs with keywords, the sources before any keywords were defined, so we can build variants later
+	std::map<ShaderPartType, std::string> _variantSources;
+	// The variants that have been compiled so far, by keyword mask
+	std::unordered_map<uint32_t, Sptr> _variants;
 	
 	// Map access to look up uniform locations and blocks
 	std::unordered_map<std::string, UniformInfo> _uniforms;
 	std::unordered_map<std::string, UniformBlockInfo> _uniformBlocks;
+	// The location of every uniform by interned name, sorted by ID so we can binary search it
+	struct UniformHandle {
+		UniformId Id;
+		int       Location;
+	};
+	std::vector<UniformHandle> _uniformIds;
+	// The values declared with "#pragma default" in our sources, by uniform name
+	std::unordered_map<std::string, std::vector<double>> _uniformDefaults;
 
 	// Stores information about the source of our shader parts
 	// EX: if a VS shader is loaded from a file, will contain
@@ -209,5 +340,47 @@ protected:
 	/// </summary>
 	void _IntrospectUnifromBlocks();
 
-	int __GetUniformLocation(const std::string& name);
+	int __GetUniformLocation(const std::string& name) const;
+
+	/// <summary>
+	/// Compiles a single shader part, logging any errors
+	/// </summary>
+	/// <returns>The handle to the shader, or 0 if it failed to compile</returns>
+	GLuint _CompileShaderPart(ShaderPartType type, const std::string& source);
+	/// <summary>
+	/// Compiles all of our shader parts and links them into our program
+	/// </summary>
+	bool _LinkFromSource();
+
+	/// <summary>
+	/// Hashes everything that goes into the linked program, as well as the driver that will compile it,
+	/// since binaries can't be shared between drivers or driver versions
+	/// </summary>
+	uint64_t _GetBinaryCacheKey() const;
+	/// <summary>
+	/// Tries to load our program from the binary cache, returns false on a miss or if the driver rejects the binary
+	/// </summary>
+	bool _LoadProgramBinary(uint64_t key);
+	/// <summary>
+	/// Writes our linked program to the binary cache
+	/// </summary>
+	void _SaveProgramBinary(uint64_t key);
+
+	/// <summary>
+	/// Adds a #define for each keyword in the mask, right after the #version line of a source
+	/// </summary>
+	static std::string _DefineKeywords(const std::string& source, uint32_t keywords);
+	/// <summary>
+	/// Finds all the "#pragma keyword" declarations in a source
+	/// </summary>
+	static uint32_t _FindKeywords(const std::string& source);
+	/// <summary>
+	/// Finds all the "#pragma default" declarations in a source, and adds them to the defaults map
+	/// </summary>
+	static void _FindDefaults(const std::string& source, std::unordered_map<std::string, std::vector<double>>& defaults);
+
+	static bool        __binaryCacheEnabled;
+	static std::string __binaryCacheDirectory;
+	static std::vector<std::string> __keywordNames;
+	static uint32_t    __globalKeywords;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Texture2D.h"
 #include <stb_image.h>
 #include <Logging.h>
+#include "Graphics/GlState.h"
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
@@ -45,16 +46,22 @@ nlohmann::json Texture2D::ToJson() const {
 	return result;
 }
 
-Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
+Texture2DDescription Texture2D::_DescriptionFromJson(const nlohmann::json& data)
 {
 	Texture2DDescription descr = Texture2DDescription();
-	descr.Filename = data["filename"];
+	descr.Filename = JsonGet<std::string>(data, "filename", "");
 	descr.HorizontalWrap = JsonParseEnum(WrapMode, data, "wrap_s", WrapMode::ClampToEdge);
 	descr.VerticalWrap   = JsonParseEnum(WrapMode, data, "wrap_t", WrapMode::ClampToEdge);
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.MaxAnisotropic      = JsonGet(data, "anisotropic", 0.0f);
 	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", false);
+	return descr;
+}
+
+Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
+{
+	Texture2DDescription descr = _DescriptionFromJson(data);
 
 	Texture2D::Sptr result = std::make_shared<Texture2D>(descr);
 
@@ -73,6 +80,31 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	return result;
 }
 
+std::function<Texture2D::Sptr()> Texture2D::Decode(const nlohmann::json& data)
+{
+	Texture2DDescription descr = _DescriptionFromJson(data);
+
+	// Textures with embedded data have nothing to read from disk
+	if (descr.Filename.empty()) {
+		return [data]() { return FromJson(data); };
+	}
+
+	ImageData image = _DecodeFile(descr.Filename, descr.FormatHint);
+	return [descr, image]() {
+		// Create the texture without a filename so the constructor doesn't load the file again
+		Texture2DDescription empty = descr;
+		empty.Filename = "";
+		Texture2D::Sptr result = std::make_shared<Texture2D>(empty);
+		result->_description.Filename = descr.Filename;
+
+		if (image.Pixels != nullptr) {
+			result->_UploadImage(image);
+		}
+		result->SetDebugName(descr.Filename);
+		return result;
+	};
+}
+
 Texture2D::Texture2D(const Texture2DDescription& description) : 
 	ITexture(TextureType::_2D),
 	_description(description),
@@ -146,54 +178,62 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 	}
 }
 
-void Texture2D::_LoadDataFromFile() {
-	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
+Texture2D::ImageData Texture2D::_DecodeFile(const std::string& filename, PixelFormat formatHint) {
+	ImageData result;
+	const int targetChannels = GetTexelComponentCount(formatHint);
 
-	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
-		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
-		}
+	// Use STBI to load the image. Note that the flip flag is global, every texture sets it to the same value
+	// so it's safe for multiple threads to be decoding at once
+	stbi_set_flip_vertically_on_load(true);
+	uint8_t* data = stbi_load(filename.c_str(), &result.Width, &result.Height, &result.NumChannels, targetChannels);
 
-		// We should estimate a good format for our data
+	// If we could not load any data, warn and return an empty image
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", filename);
+		return result;
+	}
+	result.Pixels = std::shared_ptr<uint8_t>(data, stbi_image_free);
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	if (targetChannels != 0)
+		result.NumChannels = targetChannels;
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	return result;
+}
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+void Texture2D::_UploadImage(const ImageData& image) {
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(image.NumChannels);
+	PixelFormat    image_format = GetPixelFormatForChannels(image.NumChannels);
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+	// This is one of those poorly documented things in OpenGL
+	if ((image.NumChannels * image.Width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
 
-		// Allocates our memory
-		_SetTextureParams();
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = image.Width;
+	_description.Height = image.Height;
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+	// Allocates our memory
+	_SetTextureParams();
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+	// Upload data to our texture
+	LoadData(image.Width, image.Height, image_format, PixelType::UByte, image.Pixels.get());
+}
+
+void Texture2D::_LoadDataFromFile() {
+	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
+
+	if (!_description.Filename.empty()) {
+		ImageData image = _DecodeFile(_description.Filename, _description.FormatHint);
+		if (image.Pixels == nullptr) {
+			return;
+		}
+		_UploadImage(image);
 	}
 	
 	SetDebugName(_description.Filename);
@@ -202,6 +242,7 @@ void Texture2D::_LoadDataFromFile() {
 void Texture2D::_SetTextureParams() {
 	// If we have a multisampled texture, and the current type is 2D, change it to 2D multisampled
 	if (_description.MultisampleCount > 1 && _type == TextureType::_2D) {
+		GlState::OnTextureDeleted(_rendererId);
 		glDeleteTextures(1, &_rendererId);
 		_type = TextureType::_2DMultisample;
 		glCreateTextures(*_type, 1, &_rendererId);
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include "ITexture.h"
 
 /// <summary>
@@ -143,11 +144,44 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture2D::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Decodes the image file for a texture from it's JSON blob, and returns a function that
+	/// will create the texture and upload the pixels. Decoding can happen on any thread, but
+	/// the returned function must be invoked on the main thread
+	/// </summary>
+	static std::function<Texture2D::Sptr()> Decode(const nlohmann::json& data);
 
 protected:
 	Texture2DDescription _description;
 	PixelType _pixelType;
 
+	/// <summary>
+	/// Pixel data decoded from an image file that has not been uploaded yet
+	/// </summary>
+	struct ImageData {
+		int Width       = 0;
+		int Height      = 0;
+		int NumChannels = 0;
+		// Freed with stbi_image_free, null if the file failed to load
+		std::shared_ptr<uint8_t> Pixels;
+	};
+
+	/// <summary>
+	/// Parses the sampler and file parameters for a texture from a JSON blob
+	/// </summary>
+	static Texture2DDescription _DescriptionFromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Reads and decodes an image file, does not touch OpenGL so this can be called from any thread
+	/// </summary>
+	/// <param name="filename">The path to the image file</param>
+	/// <param name="formatHint">Determines how many channels to decode</param>
+	static ImageData _DecodeFile(const std::string& filename, PixelFormat formatHint);
+	/// <summary>
+	/// Allocates storage for a decoded image and uploads it's pixels
+	/// Will overwrite description size
+	/// </summary>
+	void _UploadImage(const ImageData& image);
+
 	/// <summary>
 	/// Loads this texture from the file specified in the description
 	/// Will overwrite description size
@@ -97,7 +97,7 @@ nlohmann::json Texture3D::ToJson() const
 	return result;
 }
 
-Texture3D::Sptr Texture3D::FromJson(const nlohmann::json& data)
+Texture3DDescription Texture3D::_DescriptionFromJson(const nlohmann::json& data)
 {
 	Texture3DDescription description = Texture3DDescription();
 	description.Filename = JsonGet<std::string>(data, "filename", "");
@@ -114,6 +114,12 @@ Texture3D::Sptr Texture3D::FromJson(const nlohmann::json& data)
 	description.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	description.GenerateMipMaps = JsonGet(data, "generate_mipmaps", false);
 	description.FormatHint = JsonParseEnum(PixelFormat, data, "format", PixelFormat::Unknown);
+	return description;
+}
+
+Texture3D::Sptr Texture3D::FromJson(const nlohmann::json& data)
+{
+	Texture3DDescription description = _DescriptionFromJson(data);
 
 	Texture3D::Sptr result = std::make_shared<Texture3D>(description);
 
@@ -132,6 +138,29 @@ Texture3D::Sptr Texture3D::FromJson(const nlohmann::json& data)
 	return result;
 }
 
+std::function<Texture3D::Sptr()> Texture3D::Decode(const nlohmann::json& data)
+{
+	Texture3DDescription description = _DescriptionFromJson(data);
+
+	// Only .cube files have anything to parse ahead of time
+	std::string extension = std::filesystem::path(description.Filename).extension().string();
+	StringTools::ToLower(extension);
+	if (extension.compare(".cube") != 0) {
+		return [data]() { return FromJson(data); };
+	}
+
+	std::shared_ptr<LutData> lut = std::make_shared<LutData>(_ParseCubeFile(description.Filename));
+	return [description, lut]() {
+		// Create the texture without a filename so the constructor doesn't parse the file again
+		Texture3DDescription empty = description;
+		empty.Filename = "";
+		Texture3D::Sptr result = std::make_shared<Texture3D>(empty);
+		result->_description.Filename = description.Filename;
+		result->_UploadLut(*lut);
+		return result;
+	};
+}
+
 void Texture3D::_LoadDataFromFile()
 {
 	LOG_ASSERT(_description.Width + _description.Height + _description.Depth == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
@@ -149,15 +178,19 @@ void Texture3D::_LoadDataFromFile()
 
 void Texture3D::_LoadCubeFile()
 {
-	std::ifstream inFile(_description.Filename);
+	_UploadLut(_ParseCubeFile(_description.Filename));
+}
+
+Texture3D::LutData Texture3D::_ParseCubeFile(const std::string& filename)
+{
+	LutData result;
+	std::ifstream inFile(filename);
 
 	if (!inFile.is_open()) {
-		LOG_WARN("Failed to open file .cube file: {}", _description.Filename);
-		return;
+		LOG_WARN("Failed to open file .cube file: {}", filename);
+		return result;
 	}
 
-	glm::u8vec3* textureData = nullptr;
-	uint32_t lutSize{ 0 };
 	uint32_t ix{ 0 };
 	glm::vec3 rgb { 0, 0, 0 };
 
@@ -183,35 +216,21 @@ void Texture3D::_LoadCubeFile()
 
 			// Skip over the LUT_3D_SIZE text and read in the value
 			std::stringstream lReader(line.substr(12));
-			lReader >> lutSize;
-
-			// Update the description's size
-			_description.Width = _description.Height = _description.Depth = lutSize;
+			lReader >> result.Size;
 
-			// If the size we read is non-zero, allocate our data!
-			if (lutSize > 0) {
-				// If we had data already, delete it
-				if (textureData != nullptr) {
-					delete[] textureData;
-				} 
-
-				// Allocate data to store texels in
-				textureData = new glm::u8vec3[(size_t)lutSize * lutSize * lutSize];
-				ix = 0;
-			}
+			// Allocate storage for the texels, replacing anything we had already
+			result.Texels.assign((size_t)result.Size * result.Size * result.Size, glm::u8vec3(0));
+			ix = 0;
 		}
 
 		// We'll grab the title for our debug name, nice lil use of it
 		else if (line.find("TITLE") != std::string::npos) {
 
 			// Skip over the TITLE token and the space after it
-			std::string name = line.substr(6);
+			result.Title = line.substr(6);
 
 			// Trim any excess whitespace
-			StringTools::Trim(name);
-
-			// We'll store this in the debug name
-			SetDebugName(name);
+			StringTools::Trim(result.Title);
 		}
 
 		else if (line.find("DOMAIN_MIN") != std::string::npos)
@@ -224,11 +243,12 @@ void Texture3D::_LoadCubeFile()
 		{ /* ignore for now */ }
 
 		// Reading data lines
-		else if (!line.empty() && textureData != nullptr) {
+		else if (!result.Texels.empty()) {
 
 			// Make sure we don't case a write access violation
-			if (ix >= (lutSize * lutSize * lutSize) && lutSize > 0) {
+			if (ix >= result.Texels.size()) {
 				LOG_ASSERT(false, "Attempting to write outside the bounds of the LUT");
+				break;
 			}
 
 			// Read RGB from the line
@@ -238,16 +258,31 @@ void Texture3D::_LoadCubeFile()
 			rgb = glm::clamp(rgb, glm::vec3(0), glm::vec3(1));
 
 			// Store in the array, converting to the correct scale for bytes
-			textureData[ix].r = static_cast<uint8_t>(rgb.r * 255);
-			textureData[ix].g = static_cast<uint8_t>(rgb.g * 255);
-			textureData[ix].b = static_cast<uint8_t>(rgb.b * 255);
+			result.Texels[ix].r = static_cast<uint8_t>(rgb.r * 255);
+			result.Texels[ix].g = static_cast<uint8_t>(rgb.g * 255);
+			result.Texels[ix].b = static_cast<uint8_t>(rgb.b * 255);
 
 			// Move to the next texel
 			ix++;
 		}
 	} 
 
-	if (textureData != nullptr) {
+	if (result.Texels.empty()) {
+		LOG_WARN("Failed to load cube file: \"{}\"", filename);
+	}
+	return result;
+}
+
+void Texture3D::_UploadLut(const LutData& lut)
+{
+	if (!lut.Title.empty()) {
+		// We'll store this in the debug name
+		SetDebugName(lut.Title);
+	}
+
+	if (!lut.Texels.empty()) {
+		// Update the description's size
+		_description.Width = _description.Height = _description.Depth = lut.Size;
 		// Set the pixel format
 		_description.Format = InternalFormat::RGB8;
 		// We need to clamp to edge for LUTS
@@ -256,13 +291,7 @@ void Texture3D::_LoadCubeFile()
 		// Allocate data and configure params
 		_SetTextureParams();
 		// Load data
-		LoadData(lutSize, lutSize, lutSize, PixelFormat::RGB, PixelType::UByte, textureData);
-
-		// Clean up after ourselves
-		delete[] textureData;
-	}
-	else {
-		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
+		LoadData(lut.Size, lut.Size, lut.Size, PixelFormat::RGB, PixelType::UByte, const_cast<glm::u8vec3*>(lut.Texels.data()));
 	}
 }
 
@@ -1,4 +1,7 @@
 #pragma once
+#include <functional>
+#include <vector>
+#include <GLM/gtc/type_precision.hpp>
 #include "ITexture.h"
 
 /// <summary>
@@ -145,11 +148,40 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture3D::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Parses the LUT file for a texture from it's JSON blob, and returns a function that will
+	/// create the texture and upload the texels. Parsing can happen on any thread, but the
+	/// returned function must be invoked on the main thread
+	/// </summary>
+	static std::function<Texture3D::Sptr()> Decode(const nlohmann::json& data);
 
 protected:
 	Texture3DDescription _description;
 	PixelType _pixelType;
 
+	/// <summary>
+	/// The contents of a .cube file that has not been uploaded yet
+	/// </summary>
+	struct LutData {
+		uint32_t                 Size = 0;
+		std::string              Title;
+		std::vector<glm::u8vec3> Texels;
+	};
+
+	/// <summary>
+	/// Parses the parameters for a texture from a JSON blob
+	/// </summary>
+	static Texture3DDescription _DescriptionFromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Reads a 3D LUT from a .cube file, does not touch OpenGL so this can be called from any thread
+	/// </summary>
+	/// <returns>The LUT, with no texels if the file could not be read</returns>
+	static LutData _ParseCubeFile(const std::string& filename);
+	/// <summary>
+	/// Allocates storage for a parsed LUT and uploads it's texels
+	/// </summary>
+	void _UploadLut(const LutData& lut);
+
 	/// <summary>
 	/// Loads this texture from the file specified in the description
 	/// Will overwrite description size
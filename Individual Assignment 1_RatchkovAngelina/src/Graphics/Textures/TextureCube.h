@@ -1,5 +1,7 @@
 #pragma once
 #include <EnumToString.h>
+#include <functional>
+#include <vector>
 #include "ITexture.h"
 
 /*
@@ -84,6 +86,12 @@ public:
 	TextureCube(const std::string& baseFilename);
 	TextureCube(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
 	TextureCube(const TextureCubeDescription& description);
+	/// <summary>
+	/// Creates a cubemap from face images that have already been decoded
+	/// </summary>
+	/// <param name="description">The description of the cubemap, with the size and format of the faces filled in</param>
+	/// <param name="faceData">The pixels for all 6 faces, back to back in the order of CubeMapFace</param>
+	TextureCube(const TextureCubeDescription& description, const std::vector<uint8_t>& faceData);
 
 	/// <summary>
 	/// Gets the width of this texture in pixels
@@ -110,10 +118,35 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static TextureCube::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Decodes the face images for a cubemap from it's JSON blob, and returns a function that
+	/// will create the texture and upload the faces. Decoding can happen on any thread, but
+	/// the returned function must be invoked on the main thread
+	/// </summary>
+	static std::function<TextureCube::Sptr()> Decode(const nlohmann::json& data);
 
 protected:
 	TextureCubeDescription _description;
 
+	/// <summary>
+	/// Parses the parameters for a cubemap from a JSON blob
+	/// </summary>
+	static TextureCubeDescription _DescriptionFromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Fills in the face filenames from the base filename if they were not provided
+	/// </summary>
+	static void _ResolveFaceFilenames(TextureCubeDescription& description);
+	/// <summary>
+	/// Reads and decodes all 6 faces, updating the size and format of the description. Does not
+	/// touch OpenGL so this can be called from any thread
+	/// </summary>
+	/// <returns>The pixels for all 6 faces back to back, or an empty vector if any face failed to load</returns>
+	static std::vector<uint8_t> _DecodeFaces(TextureCubeDescription& description);
+	/// <summary>
+	/// Allocates storage and uploads the pixels for all 6 faces
+	/// </summary>
+	void _UploadFaces(const std::vector<uint8_t>& faceData);
+
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
 
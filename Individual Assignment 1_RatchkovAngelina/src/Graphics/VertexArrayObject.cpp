@@ -1,6 +1,7 @@
 #include "VertexArrayObject.h"
 #include "Buffers/IndexBuffer.h"
 #include "Buffers/VertexBuffer.h"
+#include "Graphics/GlState.h"
 #include "Logging.h"
 
 VertexArrayObject::VertexArrayObject() :
@@ -8,7 +9,9 @@ VertexArrayObject::VertexArrayObject() :
 	_handle(0),
 	_vertexCount(0),
 	_elementCount(0),
-	_vertexBuffers(std::vector<VertexBufferBinding*>())
+	_vertexBuffers(std::vector<VertexBufferBinding*>()),
+	_positionTransform(glm::mat4(1.0f)),
+	_hasPositionTransform(false)
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -16,6 +19,7 @@ VertexArrayObject::VertexArrayObject() :
 VertexArrayObject::~VertexArrayObject()
 {
 	if (_handle != 0) {
+		GlState::OnVertexArrayDeleted(_handle);
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
 	}
@@ -24,6 +28,9 @@ VertexArrayObject::~VertexArrayObject()
 void VertexArrayObject::SetIndexBuffer(const IndexBuffer::Sptr& ibo) {
 	// TODO: What if we already have a buffer? should we delete it? who owns the buffer?
 	_indexBuffer = ibo;
+	// The old levels of detail and clusters pointed into the old buffer
+	_lods.clear();
+	_meshlets.clear();
 	Bind();
 	if (_indexBuffer != nullptr) {
 		_indexBuffer->Bind();
@@ -103,6 +110,11 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 
 void VertexArrayObject::Draw(DrawMode mode) {
 	Bind();
+	DrawBound(mode);
+	Unbind();
+}
+
+void VertexArrayObject::DrawBound(DrawMode mode) {
 	if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
 		glDrawArrays((GLenum)mode, 0, elements);
@@ -110,12 +122,44 @@ void VertexArrayObject::Draw(DrawMode mode) {
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
 		glDrawElements((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr);
 	}
-	Unbind();
+}
+
+void VertexArrayObject::DrawLodInstancedBound(uint32_t lod, uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/)
+{
+	if (_indexBuffer == nullptr || lod == 0 || lod >= _lods.size()) {
+		DrawInstancedBound(instanceCount, mode);
+		return;
+	}
+	const MeshLod& level = _lods[lod];
+	const size_t offset = level.FirstIndex * (size_t)GetIndexTypeSize(_indexBuffer->GetElementType());
+	glDrawElementsInstanced((GLenum)mode, level.IndexCount, (GLenum)_indexBuffer->GetElementType(), reinterpret_cast<const void*>(offset), instanceCount);
+}
+
+void VertexArrayObject::DrawIndirectBound(uint32_t offset, uint32_t drawCount, DrawMode mode /*= DrawMode::TriangleList*/)
+{
+	if (_indexBuffer == nullptr || drawCount == 0) {
+		return;
+	}
+	glMultiDrawElementsIndirect((GLenum)mode, (GLenum)_indexBuffer->GetElementType(), reinterpret_cast<const void*>(static_cast<size_t>(offset)), drawCount, sizeof(DrawElementsIndirectCommand));
+}
+
+void VertexArrayObject::SetLods(const std::vector<MeshLod>& lods) {
+	_lods = lods;
+	// Anything that isn't LOD aware should just see the full detail mesh
+	if (_indexBuffer != nullptr && !_lods.empty()) {
+		_elementCount = _lods[0].IndexCount;
+	}
 }
 
 void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/)
 {
 	Bind();
+	DrawInstancedBound(instanceCount, mode);
+	Unbind();
+}
+
+void VertexArrayObject::DrawInstancedBound(uint32_t instanceCount, DrawMode mode /*= DrawMode::TriangleList*/)
+{
 	if (_indexBuffer == nullptr) {
 		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
 		glDrawArraysInstanced((GLenum)mode, 0, elements, instanceCount);
@@ -124,16 +168,14 @@ void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*=
 		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
 		glDrawElementsInstanced((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount);
 	}
-	Unbind();
-	
 }
 
 void VertexArrayObject::Bind() {
-	glBindVertexArray(_handle);
+	GlState::BindVertexArray(_handle);
 }
 
 void VertexArrayObject::Unbind() {
-	glBindVertexArray(0);
+	GlState::BindVertexArray(0);
 }
 
 void VertexArrayObject::SetVDecl(const VertexDeclaration& vDecl) {
@@ -177,6 +219,12 @@ VertexArrayObject::Sptr VertexArrayObject::Clone() const
 	}
 
 	result->SetVDecl(_vDecl);
+	result->SetBounds(_bounds);
+	result->SetLods(_lods);
+	result->SetMeshlets(_meshlets);
+	if (_hasPositionTransform) {
+		result->SetPositionTransform(_positionTransform);
+	}
 
 	return result;
 }
@@ -9,6 +9,7 @@
 #include "Graphics/Buffers/IndexBuffer.h"
 #include "Graphics/GlEnums.h"
 #include "Graphics/IGraphicsResource.h"
+#include "Utils/Bounds.h"
 
 /// <summary>
 /// This structure will represent the parameters passed to the glVertexAttribPointer commands
@@ -50,6 +51,46 @@ struct BufferAttribute {
 		Slot(slot), Size(size), Type(type), Stride(stride), Offset(offset), Usage(usage), Normalized(normalized) { }
 };
 
+/// <summary>
+/// A level of detail within a VAO's index buffer. Every level shares the same vertices
+/// </summary>
+struct MeshLod {
+	// The first index of this level in the index buffer
+	uint32_t FirstIndex = 0;
+	// The number of indices in this level
+	uint32_t IndexCount = 0;
+	// How far the simplified surface is from the full detail mesh, relative to the largest extent of the mesh
+	float    Error = 0.0f;
+};
+
+/// <summary>
+/// A small cluster of a mesh's triangles, along with the bounds we need to cull it. See MeshletBuilder
+/// </summary>
+struct Meshlet {
+	// The first index of this cluster in the index buffer
+	uint32_t  FirstIndex = 0;
+	// The number of indices in this cluster
+	uint32_t  IndexCount = 0;
+	// The sphere around all of the cluster's vertices, in model space
+	glm::vec3 Center     = glm::vec3(0.0f);
+	float     Radius     = 0.0f;
+	// The average direction that the cluster's triangles face, in model space
+	glm::vec3 ConeAxis   = glm::vec3(0.0f);
+	// The sine of the angle between the axis and the normal furthest from it, 1 if the cluster can't be back face culled
+	float     ConeCutoff = 1.0f;
+};
+
+/// <summary>
+/// The layout that glMultiDrawElementsIndirect reads draws from
+/// </summary>
+struct DrawElementsIndirectCommand {
+	uint32_t Count;
+	uint32_t InstanceCount;
+	uint32_t FirstIndex;
+	int32_t  BaseVertex;
+	uint32_t BaseInstance;
+};
+
 /// <summary>
 /// The Vertex Array Object wraps around an OpenGL VAO and basically represents all of the data for a mesh
 /// </summary>
@@ -119,6 +160,10 @@ public:
 	/// <param name="usage">The attribute usage hint to search for</param>
 	/// <returns>A const pointer to the binding, or nullptr if none is found</returns>
 	VertexBufferBinding* GetBufferBinding(AttribUsage usage);
+	/// <summary>
+	/// Gets all of the vertex buffers bound to this VAO, in the order they were added
+	/// </summary>
+	const std::vector<VertexBufferBinding*>& GetVertexBuffers() const { return _vertexBuffers; }
 
 	/// <summary>
 	/// Renders this VAO, using the specified draw mode
@@ -134,6 +179,35 @@ public:
 	/// <param name="mode">The primitive mode for rendering the mesh</param>
 	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
 
+	/// <summary>
+	/// Renders this VAO without binding or unbinding it, the caller must make sure
+	/// that this VAO is already bound. Lets a sorted render loop skip redundant VAO binds
+	/// </summary>
+	/// <param name="mode">The draw mode for primitives in this VAO</param>
+	void DrawBound(DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Renders this VAO with the given instance count, without binding or unbinding it
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to render</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	void DrawInstancedBound(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Renders one of this VAO's levels of detail with the given instance count, without binding or unbinding it.
+	/// Falls back to DrawInstancedBound if the VAO does not have the level
+	/// </summary>
+	/// <param name="lod">The index of the level to draw, 0 is full detail</param>
+	/// <param name="instanceCount">The number of instances to render</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	void DrawLodInstancedBound(uint32_t lod, uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Renders a list of DrawElementsIndirectCommands with glMultiDrawElementsIndirect, without binding or unbinding
+	/// this VAO. The caller must bind the buffer holding the commands to the draw indirect target first
+	/// </summary>
+	/// <param name="offset">The offset in bytes of the first command in the bound draw indirect buffer</param>
+	/// <param name="drawCount">The number of commands to draw</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	void DrawIndirectBound(uint32_t offset, uint32_t drawCount, DrawMode mode = DrawMode::TriangleList);
+
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
 	/// </summary>
@@ -151,6 +225,48 @@ public:
 	void SetVDecl(const VertexDeclaration& vDecl);
 	const VertexDeclaration& GetVDecl();
 
+	/// <summary>
+	/// Sets the local space bounds of the vertices in this VAO, should be set by whatever
+	/// loaded the vertex data, since we can't easily read it back from the GPU
+	/// </summary>
+	void SetBounds(const Bounds& bounds) { _bounds = bounds; }
+	/// <summary>
+	/// Gets the local space bounds of this VAO, will be invalid if they were never set
+	/// </summary>
+	const Bounds& GetBounds() const { return _bounds; }
+
+	/// <summary>
+	/// Sets a transform from the stored vertex positions to model space, for meshes with quantized positions.
+	/// The renderer folds this into the model matrix, but not the normal matrix
+	/// </summary>
+	void SetPositionTransform(const glm::mat4& transform) { _positionTransform = transform; _hasPositionTransform = true; }
+	/// <summary>
+	/// Gets the transform from stored vertex positions to model space, identity unless HasPositionTransform is true
+	/// </summary>
+	const glm::mat4& GetPositionTransform() const { return _positionTransform; }
+	bool HasPositionTransform() const { return _hasPositionTransform; }
+
+	/// <summary>
+	/// Sets the levels of detail stored in the index buffer, ordered from full detail to the coarsest. The
+	/// regular draw functions will only draw the first level. Must be called after SetIndexBuffer
+	/// </summary>
+	void SetLods(const std::vector<MeshLod>& lods);
+	/// <summary>
+	/// Gets the levels of detail in the index buffer, empty if the mesh only has one
+	/// </summary>
+	const std::vector<MeshLod>& GetLods() const { return _lods; }
+	uint32_t GetLodCount() const { return _lods.empty() ? 1 : static_cast<uint32_t>(_lods.size()); }
+
+	/// <summary>
+	/// Sets the clusters that the full detail mesh is split into, so the renderer can cull parts of the mesh
+	/// instead of the whole thing. Must be called after SetIndexBuffer
+	/// </summary>
+	void SetMeshlets(const std::vector<Meshlet>& meshlets) { _meshlets = meshlets; }
+	/// <summary>
+	/// Gets the clusters of the full detail mesh, empty if the mesh was not split up
+	/// </summary>
+	const std::vector<Meshlet>& GetMeshlets() const { return _meshlets; }
+
 protected:
 	
 	// The index buffer bound to this VAO
@@ -162,6 +278,16 @@ protected:
 	// defined in VertexTypes.cpp
 	VertexDeclaration _vDecl;
 
+	// The local space bounds of the mesh
+	Bounds _bounds;
+	// Maps quantized positions to model space
+	glm::mat4 _positionTransform;
+	bool      _hasPositionTransform;
+	// The index ranges of each level of detail
+	std::vector<MeshLod> _lods;
+	// The clusters of the full detail mesh
+	std::vector<Meshlet> _meshlets;
+
 	uint32_t _vertexCount;
 	uint32_t _elementCount;
 
@@ -7,6 +7,8 @@ VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
 VertexPosNormTexColTangents* VPNTCT = nullptr;
+VertexQuantized* VQ = nullptr;
+VertexQuantizedPos16* VQP = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -41,4 +43,20 @@ const std::vector<BufferAttribute> VertexPosNormTexColTangents::V_DECL ={
 	BufferAttribute(4, 3, AttributeType::Float, sizeof(VertexPosNormTexColTangents), (size_t)&VPNTCT->Tangent, AttribUsage::Tangent),
 	BufferAttribute(5, 3, AttributeType::Float, sizeof(VertexPosNormTexColTangents), (size_t)&VPNTCT->BiTangent, AttribUsage::BiTangent)
 };
+const std::vector<BufferAttribute> VertexQuantized::V_DECL ={
+	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexQuantized), (size_t)&VQ->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexQuantized), (size_t)&VQ->Color, AttribUsage::Color, true),
+	BufferAttribute(2, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantized), (size_t)&VQ->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexQuantized), (size_t)&VQ->UV, AttribUsage::Texture),
+	BufferAttribute(4, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantized), (size_t)&VQ->Tangent, AttribUsage::Tangent, true),
+	BufferAttribute(5, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantized), (size_t)&VQ->BiTangent, AttribUsage::BiTangent, true)
+};
+const std::vector<BufferAttribute> VertexQuantizedPos16::V_DECL ={
+	BufferAttribute(0, 3, AttributeType::UShort, sizeof(VertexQuantizedPos16), (size_t)&VQP->Position, AttribUsage::Position, true),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexQuantizedPos16), (size_t)&VQP->Color, AttribUsage::Color, true),
+	BufferAttribute(2, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantizedPos16), (size_t)&VQP->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexQuantizedPos16), (size_t)&VQP->UV, AttribUsage::Texture),
+	BufferAttribute(4, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantizedPos16), (size_t)&VQP->Tangent, AttribUsage::Tangent, true),
+	BufferAttribute(5, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantizedPos16), (size_t)&VQP->BiTangent, AttribUsage::BiTangent, true)
+};
 #pragma warning(pop)
\ No newline at end of file
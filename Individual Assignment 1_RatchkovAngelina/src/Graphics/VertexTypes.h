@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
 #include "VertexArrayObject.h"
 
 
@@ -116,4 +117,39 @@ struct VertexPosNormTexColTangents {
 	{}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+/// <summary>
+/// A compressed version of VertexPosNormTexColTangents, at 32 bytes instead of 80. Normals and tangents
+/// are packed as SNORM 10:10:10:2, UVs are half floats, and the color is UNORM8. The shaders see the
+/// same types as they would for the full vertex, see OptimizedObjLoader::ConvertToBinary
+/// </summary>
+struct VertexQuantized {
+	glm::vec3 Position;
+	uint32_t  Normal;
+	uint32_t  UV;
+	uint32_t  Color;
+	uint32_t  Tangent;
+	uint32_t  BiTangent;
+
+	VertexQuantized() : Position(glm::vec3(0.0f)), Normal(0), UV(0), Color(0), Tangent(0), BiTangent(0) {}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// The same as VertexQuantized, but with positions stored as UNORM16 within the mesh's bounds (28 bytes).
+/// VAOs that use this need a position transform to map the positions back to model space
+/// </summary>
+struct VertexQuantizedPos16 {
+	// The W component is padding
+	glm::u16vec4 Position;
+	uint32_t     Normal;
+	uint32_t     UV;
+	uint32_t     Color;
+	uint32_t     Tangent;
+	uint32_t     BiTangent;
+
+	VertexQuantizedPos16() : Position(glm::u16vec4(0)), Normal(0), UV(0), Color(0), Tangent(0), BiTangent(0) {}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
@@ -0,0 +1,232 @@
+#include "Utils/Benchmarks.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <GLFW/glfw3.h>
+#include <GLM/glm.hpp>
+
+#include "Utils/JobSystem.h"
+#include "Utils/ObjParser.h"
+#include "Utils/StringUtils.h"
+#include "Logging.h"
+
+bool Benchmarks::WriteGridObj(const std::string& filename, uint32_t gridSize)
+{
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (file == nullptr) {
+		LOG_WARN("Failed to open \"{}\" for writing", filename);
+		return false;
+	}
+
+	const uint32_t side = gridSize + 1;
+	const float step = 1.0f / static_cast<float>(gridSize);
+	for (uint32_t y = 0; y < side; y++) {
+		for (uint32_t x = 0; x < side; x++) {
+			fprintf(file, "v %f %f 0.0\n", x * step, y * step);
+		}
+	}
+	for (uint32_t y = 0; y < side; y++) {
+		for (uint32_t x = 0; x < side; x++) {
+			fprintf(file, "vt %f %f\n", x * step, y * step);
+		}
+	}
+	fprintf(file, "vn 0.0 0.0 1.0\n");
+
+	// Two triangles per quad, OBJ indices are 1-based
+	for (uint32_t y = 0; y < gridSize; y++) {
+		for (uint32_t x = 0; x < gridSize; x++) {
+			const uint32_t a = y * side + x + 1;
+			const uint32_t b = a + 1;
+			const uint32_t c = a + side;
+			const uint32_t d = c + 1;
+			fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1\n", a, a, b, b, d, d);
+			fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1\n", a, a, d, d, c, c);
+		}
+	}
+
+	fclose(file);
+	LOG_INFO("Wrote benchmark grid \"{}\" ({} triangles)", filename, gridSize * gridSize * 2);
+	return true;
+}
+
+Benchmarks::ObjLoaderResult Benchmarks::RunObjLoaders(const std::string& filename)
+{
+	ObjLoaderResult result;
+	if (!std::ifstream(filename, std::ios::binary)) {
+		LOG_WARN("Can't benchmark OBJ loaders, failed to open \"{}\"", filename);
+		return result;
+	}
+
+	double start = glfwGetTime();
+	_LegacyLoadObj(filename, result.LegacyVertices, result.LegacyTriangles);
+	result.LegacySeconds = glfwGetTime() - start;
+
+	start = glfwGetTime();
+	ObjParser::Data data;
+	ObjParser::ParseFile(filename, data);
+	std::vector<glm::ivec3> vertices;
+	std::vector<uint32_t> indices;
+	ObjParser::Deduplicate(data, vertices, indices);
+	result.ParserSeconds = glfwGetTime() - start;
+	result.ParserVertices = static_cast<uint32_t>(vertices.size());
+	result.ParserTriangles = static_cast<uint32_t>(indices.size() / 3);
+
+	result.Success = true;
+	LOG_INFO("OBJ loader benchmark for \"{}\":", filename);
+	LOG_INFO("\tLegacy:    {:.3f} seconds ({} vertices, {} triangles)", result.LegacySeconds, result.LegacyVertices, result.LegacyTriangles);
+	LOG_INFO("\tObjParser: {:.3f} seconds ({} vertices, {} triangles)", result.ParserSeconds, result.ParserVertices, result.ParserTriangles);
+	LOG_INFO("\tSpeedup:   {:.2f}x", result.ParserSeconds > 0.0 ? result.LegacySeconds / result.ParserSeconds : 0.0);
+	return result;
+}
+
+std::vector<Benchmarks::JobScalingResult> Benchmarks::RunJobScaling(uint32_t itemCount)
+{
+	constexpr uint32_t MAX_THREADS = 32;
+	constexpr uint32_t BATCH_SIZE = 4096;
+	constexpr int RUNS = 3;
+
+	std::vector<float> output(itemCount);
+	// Enough math per item that the work outweighs the cost of handing out batches
+	auto work = [&output](uint32_t ix) {
+		float value = static_cast<float>(ix);
+		for (int step = 0; step < 64; step++) {
+			value = value * 0.999f + glm::sqrt(value + static_cast<float>(step));
+		}
+		output[ix] = value;
+	};
+
+	const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads <= MAX_THREADS && threads <= hardwareThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	if (hardwareThreads <= MAX_THREADS && threadCounts.back() != hardwareThreads) {
+		threadCounts.push_back(hardwareThreads);
+	}
+
+	std::vector<JobScalingResult> results;
+	for (uint32_t threads : threadCounts) {
+		// A job system with no workers isn't possible (0 picks a count for us), so one thread just runs the loop
+		std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>(threads - 1) : nullptr;
+
+		double best = 0.0;
+		for (int run = 0; run < RUNS; run++) {
+			double start = glfwGetTime();
+			if (jobs != nullptr) {
+				jobs->ParallelFor(itemCount, BATCH_SIZE, work);
+			} else {
+				for (uint32_t ix = 0; ix < itemCount; ix++) {
+					work(ix);
+				}
+			}
+			double elapsed = glfwGetTime() - start;
+			best = run == 0 ? elapsed : std::min(best, elapsed);
+		}
+
+		JobScalingResult result;
+		result.Threads = threads;
+		result.Seconds = best;
+		result.Speedup = results.empty() || best <= 0.0 ? 1.0 : results[0].Seconds / best;
+		results.push_back(result);
+	}
+
+	LOG_INFO("Job system scaling ({} items, {} hardware threads):", itemCount, hardwareThreads);
+	for (const JobScalingResult& result : results) {
+		LOG_INFO("\t{:2} threads: {:.2f} ms ({:.2f}x)", result.Threads, result.Seconds * 1000.0, result.Speedup);
+	}
+	return results;
+}
+
+void Benchmarks::_LegacyLoadObj(const std::string& filename, uint32_t& vertexCount, uint32_t& triangleCount)
+{
+	std::ifstream file;
+	file.open(filename, std::ios::binary);
+
+	std::vector<glm::vec3>  positions;
+	std::vector<glm::vec3>  normals;
+	std::vector<glm::vec2>  uvs;
+	std::vector<glm::ivec3> vertices;
+	std::vector<uint32_t>   indices;
+	std::unordered_map<uint64_t, uint32_t> vertexMap;
+
+	std::string line;
+	glm::vec3 vecData;
+	glm::ivec3 vertexIndices;
+
+	while (file.peek() != EOF) {
+		std::string command;
+		file >> command;
+
+		if (command == "#") {
+			std::getline(file, line);
+		}
+		else if (command == "v") {
+			file >> vecData.x >> vecData.y >> vecData.z;
+			positions.push_back(vecData);
+		}
+		else if (command == "vn") {
+			file >> vecData.x >> vecData.y >> vecData.z;
+			normals.push_back(vecData);
+		}
+		else if (command == "vt") {
+			file >> vecData.x >> vecData.y;
+			uvs.push_back(vecData);
+		}
+		else if (command == "f") {
+			std::getline(file, line);
+			StringTools::Trim(line);
+			std::stringstream stream = std::stringstream(line);
+
+			uint32_t edges[4];
+			int ix = 0;
+			for (; ix < 4; ix++) {
+				if (stream.peek() != EOF) {
+					char tempChar;
+					vertexIndices = glm::ivec3(0);
+					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
+					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() + 1 + vertexIndices.x; }
+					if (vertexIndices.y < 0) { vertexIndices.y = uvs.size() + 1 + vertexIndices.y; }
+					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() + 1 + vertexIndices.z; }
+
+					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
+
+					auto it = vertexMap.find(key);
+					if (it != vertexMap.end()) {
+						edges[ix] = it->second;
+					} else {
+						vertices.push_back(vertexIndices - glm::ivec3(1));
+						uint32_t index = static_cast<uint32_t>(vertices.size()) - 1;
+						vertexMap[key] = index;
+						edges[ix] = index;
+					}
+				}
+				else { break; }
+			}
+
+			if (ix == 3) {
+				indices.push_back(edges[0]);
+				indices.push_back(edges[1]);
+				indices.push_back(edges[2]);
+			}
+			else if (ix == 4) {
+				indices.push_back(edges[0]);
+				indices.push_back(edges[1]);
+				indices.push_back(edges[2]);
+
+				indices.push_back(edges[0]);
+				indices.push_back(edges[2]);
+				indices.push_back(edges[3]);
+			}
+		}
+	}
+
+	vertexCount = static_cast<uint32_t>(vertices.size());
+	triangleCount = static_cast<uint32_t>(indices.size() / 3);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Timing runs that compare our optimized code paths against what they replaced. These run on the
+/// calling thread and block until they finish, so they are meant to be started from the debug window
+/// </summary>
+class Benchmarks {
+public:
+	Benchmarks() = delete;
+
+	/// <summary>
+	/// The results of loading the same OBJ file with the old stream based loader and ObjParser
+	/// </summary>
+	struct ObjLoaderResult {
+		bool     Success          = false;
+		// Time taken to parse the file and de-duplicate it's vertices
+		double   LegacySeconds    = 0.0;
+		double   ParserSeconds    = 0.0;
+		uint32_t LegacyVertices   = 0;
+		uint32_t LegacyTriangles  = 0;
+		uint32_t ParserVertices   = 0;
+		uint32_t ParserTriangles  = 0;
+	};
+
+	/// <summary>
+	/// Writes a flat grid of triangles to an OBJ file, with positions, UVs and normals, for
+	/// benchmarking loaders without needing a large model on hand
+	/// </summary>
+	/// <param name="filename">The path to write to</param>
+	/// <param name="gridSize">The number of quads along each side, the file will have gridSize^2 * 2 triangles</param>
+	/// <returns>True if the file was written</returns>
+	static bool WriteGridObj(const std::string& filename, uint32_t gridSize);
+
+	/// <summary>
+	/// Loads an OBJ file with both the original stream based loader and ObjParser, and logs how
+	/// long each took. Only parsing and vertex de-duplication are timed, since the rest of the
+	/// loading process is the same for both
+	/// </summary>
+	/// <param name="filename">The OBJ file to load</param>
+	static ObjLoaderResult RunObjLoaders(const std::string& filename);
+
+	/// <summary>
+	/// How long a ParallelFor took with a given number of threads
+	/// </summary>
+	struct JobScalingResult {
+		// The number of threads that executed jobs, including the main thread
+		uint32_t Threads = 0;
+		double   Seconds = 0.0;
+		// The single threaded time divided by this run's time
+		double   Speedup = 0.0;
+	};
+
+	/// <summary>
+	/// Runs the same ParallelFor workload on job systems with 1, 2, 4, 8, 16 and 32 threads (up to the
+	/// number of hardware threads), and logs how the time scales. Each count is timed a few times and the
+	/// fastest run is kept
+	/// </summary>
+	/// <param name="itemCount">The number of indices to process in each run</param>
+	static std::vector<JobScalingResult> RunJobScaling(uint32_t itemCount = 1 << 20);
+
+protected:
+	// The OBJ loading loop from before ObjParser, kept here only so we have something to compare against
+	static void _LegacyLoadObj(const std::string& filename, uint32_t& vertexCount, uint32_t& triangleCount);
+};
@@ -0,0 +1,65 @@
+#include "Bounds.h"
+#include <limits>
+
+Bounds::Bounds() :
+	Min(glm::vec3(std::numeric_limits<float>::max())),
+	Max(glm::vec3(std::numeric_limits<float>::lowest()))
+{ }
+
+Bounds::Bounds(const glm::vec3& min, const glm::vec3& max) :
+	Min(min),
+	Max(max)
+{ }
+
+bool Bounds::IsValid() const {
+	return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z;
+}
+
+void Bounds::Encapsulate(const glm::vec3& point) {
+	Min = glm::min(Min, point);
+	Max = glm::max(Max, point);
+}
+
+void Bounds::Encapsulate(const Bounds& other) {
+	if (other.IsValid()) {
+		Min = glm::min(Min, other.Min);
+		Max = glm::max(Max, other.Max);
+	}
+}
+
+glm::vec3 Bounds::GetCenter() const {
+	return (Min + Max) * 0.5f;
+}
+
+glm::vec3 Bounds::GetExtents() const {
+	return (Max - Min) * 0.5f;
+}
+
+float Bounds::GetRadius() const {
+	return glm::length(GetExtents());
+}
+
+Bounds Bounds::Transformed(const glm::mat4& transform) const
+{
+	if (!IsValid()) {
+		return Bounds();
+	}
+
+	// Rather than transforming all 8 corners, we transform the center, and project
+	// the extents onto each world axis using the absolute value of the rotation/scale
+	glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+	glm::mat3 absRotScale = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+	glm::vec3 extents = absRotScale * GetExtents();
+
+	return Bounds(center - extents, center + extents);
+}
+
+Bounds Bounds::FromPoints(const void* data, size_t count, size_t stride, size_t offset)
+{
+	Bounds result;
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data) + offset;
+	for (size_t ix = 0; ix < count; ix++, ptr += stride) {
+		result.Encapsulate(*reinterpret_cast<const glm::vec3*>(ptr));
+	}
+	return result;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// An axis aligned bounding box, with helpers for getting the bounding sphere that
+/// encloses it. Default constructed bounds are empty (invalid) until a point is added
+/// </summary>
+struct Bounds {
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	/// <summary>
+	/// Creates a new empty bounding box
+	/// </summary>
+	Bounds();
+	/// <summary>
+	/// Creates a bounding box from the given corners
+	/// </summary>
+	Bounds(const glm::vec3& min, const glm::vec3& max);
+
+	/// <summary>
+	/// Returns true if this box contains at least one point
+	/// </summary>
+	bool IsValid() const;
+
+	/// <summary>
+	/// Grows this box to contain the given point
+	/// </summary>
+	void Encapsulate(const glm::vec3& point);
+	/// <summary>
+	/// Grows this box to contain another box
+	/// </summary>
+	void Encapsulate(const Bounds& other);
+
+	/// <summary>
+	/// Gets the point at the center of the box
+	/// </summary>
+	glm::vec3 GetCenter() const;
+	/// <summary>
+	/// Gets the half-size of the box along each axis
+	/// </summary>
+	glm::vec3 GetExtents() const;
+	/// <summary>
+	/// Gets the radius of the sphere around GetCenter that encloses the whole box
+	/// </summary>
+	float GetRadius() const;
+
+	/// <summary>
+	/// Returns a new axis aligned box that encloses this box after it has been transformed
+	/// </summary>
+	/// <param name="transform">The transform to apply, ex: a game object's world transform</param>
+	Bounds Transformed(const glm::mat4& transform) const;
+
+	/// <summary>
+	/// Calculates the bounds of an array of points, where each point may be part of a larger structure
+	/// (ex: the Position field of a vertex)
+	/// </summary>
+	/// <param name="data">A pointer to the first element</param>
+	/// <param name="count">The number of elements</param>
+	/// <param name="stride">The size in bytes of one element</param>
+	/// <param name="offset">The offset in bytes to the vec3 within each element</param>
+	static Bounds FromPoints(const void* data, size_t count, size_t stride = sizeof(glm::vec3), size_t offset = 0);
+};
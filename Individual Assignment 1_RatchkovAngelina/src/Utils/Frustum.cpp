@@ -0,0 +1,108 @@
+#include "Frustum.h"
+
+// SSE is always available on x64, so we can rely on it for the batched culling
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	// GLM matrices are column major, so we need to grab the rows ourselves
+	glm::vec4 rows[4];
+	for (int ix = 0; ix < 4; ix++) {
+		rows[ix] = glm::vec4(viewProjection[0][ix], viewProjection[1][ix], viewProjection[2][ix], viewProjection[3][ix]);
+	}
+
+	Frustum result;
+	result.Planes[0] = rows[3] + rows[0]; // Left
+	result.Planes[1] = rows[3] - rows[0]; // Right
+	result.Planes[2] = rows[3] + rows[1]; // Bottom
+	result.Planes[3] = rows[3] - rows[1]; // Top
+	result.Planes[4] = rows[3] + rows[2]; // Near
+	result.Planes[5] = rows[3] - rows[2]; // Far
+
+	// Normalize so the planes can be used for distance (and sphere) tests
+	for (glm::vec4& plane : result.Planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return result;
+}
+
+bool Frustum::Intersects(const Bounds& bounds) const
+{
+	glm::vec3 center = bounds.GetCenter();
+	glm::vec3 extents = bounds.GetExtents();
+
+	for (const glm::vec4& plane : Planes) {
+		// Distance from the center to the plane, and the largest distance the box reaches towards the plane
+		float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : Planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Frustum::IntersectsBatch(const Bounds* bounds, size_t count, uint8_t* results) const
+{
+	size_t ix = 0;
+
+	#ifdef FRUSTUM_USE_SSE
+	// Splat each plane's components, so each lane can test a different box against the same plane
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++) {
+		planeX[p] = _mm_set1_ps(Planes[p].x);
+		planeY[p] = _mm_set1_ps(Planes[p].y);
+		planeZ[p] = _mm_set1_ps(Planes[p].z);
+		planeW[p] = _mm_set1_ps(Planes[p].w);
+		absX[p]   = _mm_set1_ps(glm::abs(Planes[p].x));
+		absY[p]   = _mm_set1_ps(glm::abs(Planes[p].y));
+		absZ[p]   = _mm_set1_ps(glm::abs(Planes[p].z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; ix + 4 <= count; ix += 4) {
+		// Transpose 4 boxes into structure-of-arrays form
+		glm::vec3 c[4], e[4];
+		for (int lane = 0; lane < 4; lane++) {
+			c[lane] = bounds[ix + lane].GetCenter();
+			e[lane] = bounds[ix + lane].GetExtents();
+		}
+		__m128 cx = _mm_setr_ps(c[0].x, c[1].x, c[2].x, c[3].x);
+		__m128 cy = _mm_setr_ps(c[0].y, c[1].y, c[2].y, c[3].y);
+		__m128 cz = _mm_setr_ps(c[0].z, c[1].z, c[2].z, c[3].z);
+		__m128 ex = _mm_setr_ps(e[0].x, e[1].x, e[2].x, e[3].x);
+		__m128 ey = _mm_setr_ps(e[0].y, e[1].y, e[2].y, e[3].y);
+		__m128 ez = _mm_setr_ps(e[0].z, e[1].z, e[2].z, e[3].z);
+
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < 6; p++) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, planeX[p]), _mm_mul_ps(cy, planeY[p])), _mm_add_ps(_mm_mul_ps(cz, planeZ[p]), planeW[p]));
+			__m128 radius   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, absX[p]), _mm_mul_ps(ey, absY[p])), _mm_mul_ps(ez, absZ[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++) {
+			results[ix + lane] = (mask & (1 << lane)) ? 0 : 1;
+		}
+	}
+	#endif
+
+	// Handle whatever is left over (or everything, if we have no SSE)
+	for (; ix < count; ix++) {
+		results[ix] = Intersects(bounds[ix]) ? 1 : 0;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Utils/Bounds.h"
+
+/// <summary>
+/// Represents the 6 clipping planes of a camera, for rejecting objects that can not be seen
+/// </summary>
+struct Frustum {
+	/// <summary>
+	/// The planes in the order left, right, bottom, top, near, far. XYZ is the normal
+	/// pointing into the frustum, W is the distance along the normal
+	/// </summary>
+	glm::vec4 Planes[6];
+
+	/// <summary>
+	/// Extracts the frustum planes from a view-projection matrix
+	/// </summary>
+	/// <param name="viewProjection">The camera's combined view and projection matrices</param>
+	static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Returns true if any part of the box could be inside the frustum
+	/// </summary>
+	bool Intersects(const Bounds& bounds) const;
+	/// <summary>
+	/// Returns true if any part of the sphere could be inside the frustum
+	/// </summary>
+	bool Intersects(const glm::vec3& center, float radius) const;
+
+	/// <summary>
+	/// Tests a whole array of bounding boxes against the frustum, using SSE to test 4 boxes
+	/// at a time where it is available. Results for invalid (empty) bounds should be ignored
+	/// </summary>
+	/// <param name="bounds">The array of boxes to test</param>
+	/// <param name="count">The number of boxes in the array</param>
+	/// <param name="results">Receives 1 for each box that is visible, and 0 for boxes that are culled</param>
+	void IntersectsBatch(const Bounds* bounds, size_t count, uint8_t* results) const;
+};
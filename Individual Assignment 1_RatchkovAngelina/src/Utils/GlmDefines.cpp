@@ -1,5 +1,10 @@
 #include "Utils/GlmDefines.h"
 
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GLM_DEFINES_USE_SSE
+#include <xmmintrin.h>
+#endif
+
 glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
 glm::mat3 MAT3_IDENTITY = glm::mat3(1.0f);
 glm::vec4 UNIT_X = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
@@ -35,3 +40,33 @@ glm::mat4 NormalizeScale(const glm::mat4& transform) {
 	NormalizeScaleRef(result);
 	return result;
 }
+
+
+void MultiplyMat4Batch(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* result, size_t count)
+{
+	#ifdef GLM_DEFINES_USE_SSE
+	// Load the columns of the left hand matrix once, they are shared by every multiplication
+	const float* l = &lhs[0][0];
+	__m128 col0 = _mm_loadu_ps(l + 0);
+	__m128 col1 = _mm_loadu_ps(l + 4);
+	__m128 col2 = _mm_loadu_ps(l + 8);
+	__m128 col3 = _mm_loadu_ps(l + 12);
+
+	for (size_t ix = 0; ix < count; ix++) {
+		const float* r = &rhs[ix][0][0];
+		float* out = &result[ix][0][0];
+		// Each column of the result is the lhs columns weighted by the matching rhs column
+		for (int c = 0; c < 4; c++) {
+			__m128 value = _mm_mul_ps(col0, _mm_set1_ps(r[c * 4 + 0]));
+			value = _mm_add_ps(value, _mm_mul_ps(col1, _mm_set1_ps(r[c * 4 + 1])));
+			value = _mm_add_ps(value, _mm_mul_ps(col2, _mm_set1_ps(r[c * 4 + 2])));
+			value = _mm_add_ps(value, _mm_mul_ps(col3, _mm_set1_ps(r[c * 4 + 3])));
+			_mm_storeu_ps(out + c * 4, value);
+		}
+	}
+	#else
+	for (size_t ix = 0; ix < count; ix++) {
+		result[ix] = lhs * rhs[ix];
+	}
+	#endif
+}
\ No newline at end of file
@@ -32,6 +32,16 @@ void NormalizeScaleRef(glm::mat4& transform);
 /// <returns>A copy of transform with scaling normalized</returns>
 glm::mat4 NormalizeScale(const glm::mat4& transform);
 
+/// <summary>
+/// Multiplies an array of matrices by the same left hand matrix, ex: computing the MVP
+/// for a list of model matrices. Uses SSE where available
+/// </summary>
+/// <param name="lhs">The matrix to multiply by, ex: the view projection</param>
+/// <param name="rhs">The array of right hand side matrices</param>
+/// <param name="result">The array to store the results in (lhs * rhs[i]), may not overlap with rhs</param>
+/// <param name="count">The number of matrices in rhs and result</param>
+void MultiplyMat4Batch(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* result, size_t count);
+
 template <typename T, typename V>
 T Wrap(const T& x, const V& min, const V& max) {
 	return glm::mod((glm::mod((x - min), (max - min)) + (max - min)), (max - min)) + min;
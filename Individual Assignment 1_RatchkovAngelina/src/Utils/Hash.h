@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+/// <summary>
+/// A 64-bit FNV-1a hash that can be fed data a piece at a time. It's fast and simple, but is
+/// not suitable for anything that needs to resist deliberate collisions
+/// </summary>
+struct Fnv1aHash {
+	static constexpr uint64_t OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t PRIME        = 1099511628211ull;
+
+	uint64_t Value = OFFSET_BASIS;
+
+	/// <summary>
+	/// Hashes a string in one go. Unlike Add, this is constexpr so that names written in the source can
+	/// be hashed by the compiler, and it does not include the length
+	/// </summary>
+	static constexpr uint64_t Of(const char* data, size_t size) {
+		uint64_t result = OFFSET_BASIS;
+		for (size_t ix = 0; ix < size; ix++) {
+			result = (result ^ static_cast<uint8_t>(data[ix])) * PRIME;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Adds a block of bytes to the hash
+	/// </summary>
+	void Add(const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t ix = 0; ix < size; ix++) {
+			Value = (Value ^ bytes[ix]) * PRIME;
+		}
+	}
+
+	/// <summary>
+	/// Adds a string to the hash, along with it's length so that "ab" + "c" and "a" + "bc" hash differently
+	/// </summary>
+	void Add(const std::string& value) {
+		AddValue(static_cast<uint64_t>(value.size()));
+		Add(value.data(), value.size());
+	}
+
+	/// <summary>
+	/// Adds the bytes of a trivially copyable value to the hash
+	/// </summary>
+	template <typename T>
+	void AddValue(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be hashed by their bytes");
+		Add(&value, sizeof(T));
+	}
+};
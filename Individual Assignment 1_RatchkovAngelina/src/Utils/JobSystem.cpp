@@ -0,0 +1,217 @@
+#include "JobSystem.h"
+#include "Logging.h"
+
+// The index of the current thread within the job system, worker threads set this when they start
+static thread_local uint32_t t_ThreadIndex = 0;
+
+JobSystem::JobSystem(uint32_t numWorkers) :
+	_queues(),
+	_workers(),
+	_stats(),
+	_mainThreadQueue(),
+	_queuedJobs(0),
+	_isRunning(true)
+{
+	if (numWorkers == 0) {
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	// One queue for the main thread, plus one for each worker
+	for (uint32_t ix = 0; ix <= numWorkers; ix++) {
+		_queues.push_back(std::make_unique<WorkQueue>());
+		_stats.push_back(std::make_unique<ThreadStats>());
+	}
+	for (uint32_t ix = 1; ix <= numWorkers; ix++) {
+		_workers.emplace_back(&JobSystem::_WorkerLoop, this, ix);
+	}
+
+	LOG_INFO("Started job system with {} worker threads", numWorkers);
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_isRunning = false;
+	}
+	_wakeCondition.notify_all();
+
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+}
+
+void JobSystem::Submit(Job job, JobCounter* counter, JobAffinity affinity) {
+	if (counter != nullptr) {
+		counter->_value.fetch_add(1, std::memory_order_relaxed);
+	}
+	_Enqueue(std::move(job), counter, affinity);
+}
+
+void JobSystem::SubmitAfter(JobCounter& dependency, Job job, JobCounter* counter, JobAffinity affinity) {
+	if (counter != nullptr) {
+		counter->_value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// If the dependency is still running, park the job on it. The lock keeps the dependency
+	// from finishing between the check and adding the continuation
+	{
+		std::lock_guard<std::mutex> lock(dependency._mutex);
+		if (!dependency.IsDone()) {
+			dependency._continuations.push_back([this, job, counter, affinity]() mutable {
+				_Enqueue(std::move(job), counter, affinity);
+			});
+			return;
+		}
+	}
+	_Enqueue(std::move(job), counter, affinity);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	const uint32_t threadIx = GetThreadIndex();
+	while (!counter.IsDone()) {
+		// Rather than blocking, help out with any work that is available
+		if (!_TryRunOne(threadIx)) {
+			std::this_thread::yield();
+		}
+	}
+
+	// The thread that finished the last job may still be releasing the counter, taking the
+	// lock makes sure it's done before the caller is allowed to destroy it
+	std::lock_guard<std::mutex> lock(counter._mutex);
+}
+
+void JobSystem::RunMainThreadJobs() {
+	Entry entry;
+	while (_TryPop(_mainThreadQueue, entry)) {
+		_stats[0]->JobsExecuted.fetch_add(1, std::memory_order_relaxed);
+		_Execute(entry);
+	}
+}
+
+uint32_t JobSystem::GetThreadIndex() {
+	return t_ThreadIndex;
+}
+
+JobSystem::Stats JobSystem::GetStats() const {
+	Stats result;
+	result.JobsExecuted.reserve(_stats.size());
+	for (const auto& stats : _stats) {
+		result.JobsExecuted.push_back(stats->JobsExecuted.load(std::memory_order_relaxed));
+		result.JobsStolen += stats->JobsStolen.load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+void JobSystem::ResetStats() {
+	for (auto& stats : _stats) {
+		stats->JobsExecuted.store(0, std::memory_order_relaxed);
+		stats->JobsStolen.store(0, std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::_Enqueue(Job&& job, JobCounter* counter, JobAffinity affinity) {
+	// Main thread jobs don't go in the shared count, since waking workers for them is pointless
+	if (affinity == JobAffinity::MainThread) {
+		std::lock_guard<std::mutex> lock(_mainThreadQueue.Mutex);
+		_mainThreadQueue.Jobs.push_back({ std::move(job), counter });
+		return;
+	}
+
+	// Count the job before it's visible so the count can never drop below zero. We take the
+	// sleep lock so a worker can't miss the notify between checking and waiting
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_queuedJobs.fetch_add(1, std::memory_order_release);
+	}
+
+	// Threads that don't belong to us will use the main thread's queue
+	uint32_t queueIx = GetThreadIndex();
+	queueIx = queueIx < _queues.size() ? queueIx : 0;
+	{
+		std::lock_guard<std::mutex> lock(_queues[queueIx]->Mutex);
+		_queues[queueIx]->Jobs.push_back({ std::move(job), counter });
+	}
+	_wakeCondition.notify_one();
+}
+
+bool JobSystem::_TryPop(WorkQueue& queue, Entry& result) {
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Jobs.empty()) {
+		return false;
+	}
+	result = std::move(queue.Jobs.back());
+	queue.Jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::_TrySteal(uint32_t thiefIx, Entry& result) {
+	// Start with the queue after ours, so that threads don't all pile onto the same victim
+	const uint32_t count = static_cast<uint32_t>(_queues.size());
+	for (uint32_t offset = 1; offset < count; offset++) {
+		WorkQueue& queue = *_queues[(thiefIx + offset) % count];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (!queue.Jobs.empty()) {
+			result = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			_stats[thiefIx]->JobsStolen.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::_TryRunOne(uint32_t threadIx) {
+	threadIx = threadIx < _queues.size() ? threadIx : 0;
+	Entry entry;
+
+	// The main thread gives priority to work that nobody else can do
+	if (threadIx == 0 && _TryPop(_mainThreadQueue, entry)) {
+		_stats[0]->JobsExecuted.fetch_add(1, std::memory_order_relaxed);
+		_Execute(entry);
+		return true;
+	}
+
+	if (_TryPop(*_queues[threadIx], entry) || _TrySteal(threadIx, entry)) {
+		_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		_stats[threadIx]->JobsExecuted.fetch_add(1, std::memory_order_relaxed);
+		_Execute(entry);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::_Execute(Entry& entry) {
+	entry.Func();
+
+	if (entry.Counter != nullptr) {
+		JobCounter& counter = *entry.Counter;
+		std::vector<std::function<void()>> ready;
+		{
+			std::lock_guard<std::mutex> lock(counter._mutex);
+			if (counter._value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				ready.swap(counter._continuations);
+			}
+		}
+
+		// Queue up anything that was waiting on the counter, we don't touch the counter
+		// after this point since it may have been destroyed by a waiting thread
+		for (auto& continuation : ready) {
+			continuation();
+		}
+	}
+}
+
+void JobSystem::_WorkerLoop(uint32_t threadIx) {
+	t_ThreadIndex = threadIx;
+
+	while (_isRunning) {
+		if (!_TryRunOne(threadIx)) {
+			// Sleep until there is something in one of the queues
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_wakeCondition.wait(lock, [this]() {
+				return !_isRunning || _queuedJobs.load(std::memory_order_acquire) > 0;
+			});
+		}
+	}
+}
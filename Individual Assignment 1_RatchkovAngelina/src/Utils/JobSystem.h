@@ -0,0 +1,203 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <EnumToString.h>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Which threads are allowed to run a job
+/// </summary>
+ENUM(JobAffinity, uint8_t,
+	// The job can run on any thread
+	Any        = 0,
+	// The job must run on the main thread, for things like OpenGL calls
+	MainThread = 1
+);
+
+/// <summary>
+/// Tracks a group of jobs, the counter is incremented when a job is submitted
+/// with it, and decremented when that job finishes
+/// </summary>
+class JobCounter final {
+public:
+	NO_COPY(JobCounter);
+	NO_MOVE(JobCounter);
+
+	JobCounter() : _value(0), _mutex(), _continuations() { }
+
+	/// <summary>
+	/// Returns true if all jobs tracked by this counter have finished
+	/// </summary>
+	bool IsDone() const { return _value.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> _value;
+
+	// Jobs that are waiting on this counter to reach zero before they can be queued
+	std::mutex                         _mutex;
+	std::vector<std::function<void()>> _continuations;
+};
+
+/// <summary>
+/// A pool of worker threads that execute small jobs. Each thread has it's own queue of jobs,
+/// and threads that run out of work will steal jobs from the other queues
+///
+/// The thread that created the job system (the main thread) has a queue as well, and will
+/// execute jobs while it is waiting on a counter instead of blocking
+/// </summary>
+class JobSystem final {
+public:
+	MAKE_PTRS(JobSystem);
+	NO_COPY(JobSystem);
+	NO_MOVE(JobSystem);
+
+	typedef std::function<void()> Job;
+
+	/// <summary>
+	/// Creates a new job system and starts it's worker threads
+	/// </summary>
+	/// <param name="numWorkers">The number of worker threads to start, or 0 to use one less than the number of hardware threads</param>
+	JobSystem(uint32_t numWorkers = 0);
+	~JobSystem();
+
+	/// <summary>
+	/// Tracks how much work the job system has done, for profiling
+	/// </summary>
+	struct Stats {
+		// The number of jobs that each thread has executed, index 0 is the main thread
+		std::vector<uint32_t> JobsExecuted;
+		// The total number of jobs taken from another thread's queue
+		uint32_t JobsStolen = 0;
+	};
+
+	/// <summary>
+	/// Submits a job to the queue of the calling thread
+	/// </summary>
+	/// <param name="job">The job to execute</param>
+	/// <param name="counter">An optional counter to track the job with</param>
+	/// <param name="affinity">Which threads can execute the job</param>
+	void Submit(Job job, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::Any);
+	/// <summary>
+	/// Submits a job that will only be queued once all of the jobs tracked by another counter have finished
+	/// </summary>
+	/// <param name="dependency">The counter to wait on, must outlive the job</param>
+	/// <param name="job">The job to execute</param>
+	/// <param name="counter">An optional counter to track the job with, it is incremented immediately</param>
+	/// <param name="affinity">Which threads can execute the job</param>
+	void SubmitAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::Any);
+
+	/// <summary>
+	/// Runs all jobs that are waiting for the main thread, should be invoked by the main thread once per frame
+	/// </summary>
+	void RunMainThreadJobs();
+
+	/// <summary>
+	/// Waits until the counter reaches zero, executing other jobs in the meantime. Counters
+	/// should always be waited on before they are destroyed
+	/// </summary>
+	void Wait(JobCounter& counter);
+
+	/// <summary>
+	/// Invokes func(index) for every index in [0, count), split into batches that
+	/// are spread across all threads. Returns once all indices have been processed
+	/// </summary>
+	/// <param name="count">The number of indices to process</param>
+	/// <param name="batchSize">The number of indices to process in each job</param>
+	/// <param name="func">The function to invoke, should accept a uint32_t index</param>
+	template <typename Func>
+	void ParallelFor(uint32_t count, uint32_t batchSize, Func&& func) {
+		if (count == 0) {
+			return;
+		}
+		batchSize = batchSize == 0 ? 1 : batchSize;
+
+		// Small workloads are not worth the overhead of a job
+		if (count <= batchSize || _workers.empty()) {
+			for (uint32_t ix = 0; ix < count; ix++) {
+				func(ix);
+			}
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t start = 0; start < count; start += batchSize) {
+			const uint32_t end = std::min(start + batchSize, count);
+			// We wait before returning, so capturing func by reference is safe
+			Submit([&func, start, end]() {
+				for (uint32_t ix = start; ix < end; ix++) {
+					func(ix);
+				}
+			}, &counter);
+		}
+		Wait(counter);
+	}
+
+	/// <summary>
+	/// Gets the number of worker threads, not including the main thread
+	/// </summary>
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(_workers.size()); }
+	/// <summary>
+	/// Gets the total number of threads that can execute jobs, including the main thread
+	/// </summary>
+	uint32_t GetThreadCount() const { return GetWorkerCount() + 1; }
+
+	/// <summary>
+	/// Gets the index of the calling thread in the job system, 0 for the main thread (or any
+	/// thread not owned by the job system), and 1 to N for the worker threads
+	/// </summary>
+	static uint32_t GetThreadIndex();
+
+	/// <summary>
+	/// Gets the work done since the last call to ResetStats
+	/// </summary>
+	Stats GetStats() const;
+	void ResetStats();
+
+private:
+	struct Entry {
+		Job         Func;
+		JobCounter* Counter;
+	};
+
+	// Per-thread counters, padded so that threads don't share cache lines
+	struct alignas(64) ThreadStats {
+		std::atomic<uint32_t> JobsExecuted{ 0 };
+		std::atomic<uint32_t> JobsStolen{ 0 };
+	};
+
+	// A queue of jobs owned by a single thread. The owner pushes and pops from the back,
+	// and other threads steal from the front
+	struct WorkQueue {
+		std::mutex        Mutex;
+		std::deque<Entry> Jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>>   _queues;
+	std::vector<std::thread>                  _workers;
+	std::vector<std::unique_ptr<ThreadStats>> _stats;
+	// Jobs that can only be run by the main thread, no other threads will steal from here
+	WorkQueue                                 _mainThreadQueue;
+
+	// Used to put workers to sleep when there is nothing to do
+	std::mutex              _sleepMutex;
+	std::condition_variable _wakeCondition;
+	std::atomic<uint32_t>   _queuedJobs;
+	std::atomic<bool>       _isRunning;
+
+	void _Enqueue(Job&& job, JobCounter* counter, JobAffinity affinity);
+	bool _TryPop(WorkQueue& queue, Entry& result);
+	bool _TrySteal(uint32_t thiefIx, Entry& result);
+	bool _TryRunOne(uint32_t threadIx);
+	void _Execute(Entry& entry);
+	void _WorkerLoop(uint32_t threadIx);
+};
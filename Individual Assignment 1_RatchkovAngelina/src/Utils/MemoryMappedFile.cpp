@@ -0,0 +1,95 @@
+#include "Utils/MemoryMappedFile.h"
+#include <Logging.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MemoryMappedFile::MemoryMappedFile(const std::string& filename) :
+	_data(nullptr),
+	_size(0),
+	_fileHandle(INVALID_HANDLE_VALUE),
+	_mappingHandle(nullptr)
+{
+	// We let the OS know that we'll be reading front to back, so it can read ahead of us
+	_fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_fileHandle == INVALID_HANDLE_VALUE) {
+		LOG_WARN("Failed to open \"{}\" for mapping", filename);
+		return;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_fileHandle, &size) || size.QuadPart == 0) {
+		LOG_WARN("Cannot map empty file \"{}\"", filename);
+		return;
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mappingHandle != nullptr) {
+		_data = static_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (_data == nullptr) {
+		LOG_WARN("Failed to map \"{}\" into memory", filename);
+		_size = 0;
+	}
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+	}
+	if (_fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(_fileHandle);
+	}
+}
+#else
+MemoryMappedFile::MemoryMappedFile(const std::string& filename) :
+	_data(nullptr),
+	_size(0),
+	_fileHandle(-1)
+{
+	_fileHandle = open(filename.c_str(), O_RDONLY);
+	if (_fileHandle == -1) {
+		LOG_WARN("Failed to open \"{}\" for mapping", filename);
+		return;
+	}
+
+	struct stat info;
+	if (fstat(_fileHandle, &info) != 0 || info.st_size == 0) {
+		LOG_WARN("Cannot map empty file \"{}\"", filename);
+		return;
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileHandle, 0);
+	if (data == MAP_FAILED) {
+		LOG_WARN("Failed to map \"{}\" into memory", filename);
+		_size = 0;
+		return;
+	}
+	// We'll be reading front to back, so let the OS read ahead of us
+	madvise(data, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const uint8_t*>(data);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	if (_fileHandle != -1) {
+		close(_fileHandle);
+	}
+}
+#endif
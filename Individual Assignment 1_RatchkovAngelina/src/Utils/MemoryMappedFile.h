@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Maps an entire file into memory as read only, so that it can be accessed like an array
+/// without reading it into a buffer first. Pages are loaded by the OS as they are touched,
+/// and the mapping is released when the object is destroyed
+/// </summary>
+class MemoryMappedFile final {
+public:
+	MAKE_PTRS(MemoryMappedFile);
+	NO_COPY(MemoryMappedFile);
+	NO_MOVE(MemoryMappedFile);
+
+	/// <summary>
+	/// Maps the file at the given path, check IsOpen to see if it succeeded
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	MemoryMappedFile(const std::string& filename);
+	~MemoryMappedFile();
+
+	/// <summary>
+	/// Returns true if the file was mapped
+	/// </summary>
+	bool IsOpen() const { return _data != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the start of the file, or nullptr if it is not open. The pointer
+	/// is aligned to at least the page size of the system
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the file in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	const uint8_t* _data;
+	size_t         _size;
+
+	#ifdef _WIN32
+	void* _fileHandle;
+	void* _mappingHandle;
+	#else
+	int   _fileHandle;
+	#endif
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <cstddef>
 #include "Graphics/VertexArrayObject.h"
 
 /// <summary>
@@ -116,6 +117,13 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
+	/// <summary>
+	/// Calculates the local space bounding box of all vertices in this mesh
+	/// </summary>
+	Bounds GetBounds() const {
+		return Bounds::FromPoints(_vertices.data(), _vertices.size(), sizeof(VertType), offsetof(VertType, Position));
+	}
+
 	/// <summary>
 	/// Creates and returns a VertexArraybject from the current data
 	/// </summary>
@@ -137,6 +145,7 @@ public:
 
 		// Store our vertex type in the VAO's vertex declaration
 		result->SetVDecl(VertType::V_DECL);
+		result->SetBounds(GetBounds());
 
 		return result;
 	}
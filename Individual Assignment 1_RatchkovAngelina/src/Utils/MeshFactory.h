@@ -140,6 +140,18 @@ public:
 	template <typename Vertex>
 	static void AddParameterized(MeshBuilder<Vertex>& mesh, const MeshBuilderParam& param);
 
+	/// <summary>
+	/// Adds a list of MeshBuilderParams to the given mesh and calculates it's tangents. If any of the params are
+	/// tessellated ico spheres, the lower tessellations are added after the full detail mesh as levels of detail
+	/// </summary>
+	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
+	/// <param name="mesh">The mesh to add the objects to, should be empty</param>
+	/// <param name="params">The mesh object parameters</param>
+	/// <param name="maxLods">The most levels to generate, including the full detail mesh</param>
+	/// <returns>The index ranges of each level of detail, starting with the full detail mesh</returns>
+	template <typename Vertex>
+	static std::vector<MeshLod> AddParameterizedWithLods(MeshBuilder<Vertex>& mesh, const std::vector<MeshBuilderParam>& params, uint32_t maxLods = 4);
+
 	/// <summary>
 	/// Manipulates a MeshBuilder by inverting all faces in the mesh
 	/// </summary>
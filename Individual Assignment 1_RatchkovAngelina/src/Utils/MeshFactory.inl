@@ -531,6 +531,62 @@ void MeshFactory::AddParameterized(MeshBuilder<Vertex>& mesh, const MeshBuilderP
 	}
 }
 
+template <typename Vertex>
+std::vector<MeshLod> MeshFactory::AddParameterizedWithLods(MeshBuilder<Vertex>& mesh, const std::vector<MeshBuilderParam>& params, uint32_t maxLods) {
+	for (const MeshBuilderParam& param : params) {
+		AddParameterized(mesh, param);
+	}
+	CalculateTBN(mesh);
+
+	std::vector<MeshLod> result = { MeshLod{ 0, static_cast<uint32_t>(mesh.GetIndexCount()), 0.0f } };
+	const glm::vec3 extents = mesh.GetBounds().Max - mesh.GetBounds().Min;
+	const float meshSize = glm::max(extents.x, glm::max(extents.y, extents.z));
+	if (mesh.GetIndexCount() == 0 || meshSize <= 0.0f) {
+		return result;
+	}
+
+	// Each level drops one subdivision from every ico sphere, we stop once none of them can go any lower
+	for (uint32_t level = 1; level < maxLods; level++) {
+		MeshBuilder<Vertex> lod;
+		bool isReduced = false;
+		float error = 0.0f;
+		for (const MeshBuilderParam& param : params) {
+			if (param.Type != MeshBuilderType::IcoShere) {
+				AddParameterized(lod, param);
+				continue;
+			}
+
+			MeshBuilderParam reduced = param;
+			const int tessellation = static_cast<int>(param.Params.at("tessellation").x);
+			const int lodTessellation = glm::max(tessellation - static_cast<int>(level), 0);
+			reduced.Params["tessellation"].x = static_cast<float>(lodTessellation);
+			isReduced |= tessellation >= static_cast<int>(level);
+			AddParameterized(lod, reduced);
+
+			// An icosahedron's edges span ~1.107 radians, and each subdivision halves that. The error is how
+			// far the middle of the chord is from the sphere's surface
+			const glm::vec3& radii = param.Params.at("radius");
+			const float radius = glm::max(radii.x, glm::max(radii.y, radii.z));
+			const float edgeAngle = 1.1071487f / static_cast<float>(1 << lodTessellation);
+			error = glm::max(error, radius * (1.0f - glm::cos(edgeAngle * 0.5f)) / meshSize);
+		}
+		if (!isReduced) {
+			break;
+		}
+		CalculateTBN(lod);
+
+		// The level gets it's own vertices, appended after all the previous levels
+		const uint32_t baseVertex = mesh.AddVertexRange(lod.GetVertexDataPtr(), static_cast<uint32_t>(lod.GetVertexCount()));
+		result.push_back(MeshLod{ static_cast<uint32_t>(mesh.GetIndexCount()), static_cast<uint32_t>(lod.GetIndexCount()), error });
+		mesh.ReserveIndexSpace(lod.GetIndexCount());
+		for (size_t ix = 0; ix < lod.GetIndexCount(); ix++) {
+			mesh.AddIndex(baseVertex + lod.GetIndexDataPtr()[ix]);
+		}
+	}
+
+	return result;
+}
+
 template <typename Vertex>
 void MeshFactory::InvertFaces(MeshBuilder<Vertex>& mesh)
 {
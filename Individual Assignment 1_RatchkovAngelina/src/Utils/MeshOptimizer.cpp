@@ -0,0 +1,275 @@
+#include "Utils/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <GLM/glm.hpp>
+
+namespace {
+	inline const glm::vec3& GetPosition(const void* vertices, size_t stride, size_t offset, uint32_t index) {
+		return *reinterpret_cast<const glm::vec3*>(static_cast<const uint8_t*>(vertices) + index * stride + offset);
+	}
+
+	/// <summary>
+	/// A FIFO vertex cache, using timestamps so that it can be reset without clearing it
+	/// </summary>
+	struct CacheSimulator {
+		std::vector<uint32_t> Timestamps;
+		uint32_t Time;
+		uint32_t CacheSize;
+
+		CacheSimulator(size_t vertexCount, uint32_t cacheSize) :
+			Timestamps(vertexCount, 0),
+			Time(cacheSize + 1),
+			CacheSize(cacheSize)
+		{ }
+
+		/// <summary>
+		/// Returns the number of vertices of the triangle that were not in the cache
+		/// </summary>
+		uint32_t AddTriangle(const uint32_t* triangle) {
+			uint32_t misses = 0;
+			for (int ix = 0; ix < 3; ix++) {
+				if (Time - Timestamps[triangle[ix]] > CacheSize) {
+					Timestamps[triangle[ix]] = Time++;
+					misses++;
+				}
+			}
+			return misses;
+		}
+
+		void Flush() {
+			Time += CacheSize + 1;
+		}
+	};
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	CacheStats result;
+	if (indexCount < 3 || vertexCount == 0) {
+		return result;
+	}
+
+	CacheSimulator cache(vertexCount, cacheSize);
+	std::vector<bool> isUsed(vertexCount, false);
+	size_t misses = 0;
+	size_t uniqueVertices = 0;
+	for (size_t ix = 0; ix + 2 < indexCount; ix += 3) {
+		misses += cache.AddTriangle(indices + ix);
+		for (size_t corner = ix; corner < ix + 3; corner++) {
+			if (!isUsed[indices[corner]]) {
+				isUsed[indices[corner]] = true;
+				uniqueVertices++;
+			}
+		}
+	}
+
+	result.ACMR = static_cast<float>(misses) / (indexCount / 3);
+	result.ATVR = static_cast<float>(misses) / uniqueVertices;
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>* clusters) {
+	const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+	const uint32_t cacheSize = TIPSIFY_CACHE_SIZE;
+
+	// Build the list of triangles that use each vertex
+	std::vector<uint32_t> liveCounts(vertexCount, 0);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		liveCounts[indices[ix]]++;
+	}
+	std::vector<uint32_t> adjacencyStarts(vertexCount + 1, 0);
+	std::partial_sum(liveCounts.begin(), liveCounts.end(), adjacencyStarts.begin() + 1);
+	std::vector<uint32_t> adjacency(indexCount);
+	std::vector<uint32_t> fill(adjacencyStarts.begin(), adjacencyStarts.end() - 1);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<bool>     isEmitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	uint32_t time = cacheSize + 1;
+	uint32_t scanCursor = 0;
+	size_t   written = 0;
+
+	if (clusters != nullptr) {
+		clusters->clear();
+	}
+
+	// Finds the next vertex that still has triangles, once we've run out of nearby vertices
+	auto skipDeadEnd = [&]() -> int64_t {
+		while (!deadEnds.empty()) {
+			uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCounts[vertex] > 0) {
+				return vertex;
+			}
+		}
+		while (scanCursor < vertexCount) {
+			if (liveCounts[scanCursor] > 0) {
+				return scanCursor;
+			}
+			scanCursor++;
+		}
+		return -1;
+	};
+
+	int64_t fanning = skipDeadEnd();
+	while (fanning >= 0) {
+		// Emit all of the remaining triangles around the fanning vertex
+		candidates.clear();
+		for (uint32_t ix = adjacencyStarts[fanning]; ix < adjacencyStarts[fanning + 1]; ix++) {
+			const uint32_t triangle = adjacency[ix];
+			if (isEmitted[triangle]) {
+				continue;
+			}
+			isEmitted[triangle] = true;
+
+			for (int corner = 0; corner < 3; corner++) {
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				destination[written++] = vertex;
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCounts[vertex]--;
+				if (time - timestamps[vertex] > cacheSize) {
+					timestamps[vertex] = time++;
+				}
+			}
+		}
+
+		// Pick the candidate that will still be in the cache after emitting all of it's triangles, and has been there the longest
+		int64_t next = -1;
+		int32_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (liveCounts[vertex] == 0) {
+				continue;
+			}
+			int32_t priority = 0;
+			if (time - timestamps[vertex] + 2 * liveCounts[vertex] <= cacheSize) {
+				priority = static_cast<int32_t>(time - timestamps[vertex]);
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		// Nothing nearby, jump somewhere else. This is a hard boundary between clusters
+		if (next < 0) {
+			next = skipDeadEnd();
+			if (clusters != nullptr && next >= 0) {
+				clusters->push_back(static_cast<uint32_t>(written));
+			}
+		}
+		fanning = next;
+	}
+
+	if (clusters != nullptr) {
+		clusters->insert(clusters->begin(), 0);
+	}
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, size_t positionOffset, const std::vector<uint32_t>& clusters, float threshold) {
+	// Split the hard clusters into smaller ones wherever the cache efficiency of the cluster so far is close
+	// to that of the whole cluster, smaller clusters can be sorted more accurately
+	std::vector<uint32_t> splits;
+	CacheSimulator cache(vertexCount, ANALYZE_CACHE_SIZE);
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		const uint32_t start = clusters[cluster];
+		const uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : static_cast<uint32_t>(indexCount);
+
+		cache.Flush();
+		uint32_t misses = 0;
+		for (uint32_t ix = start; ix < end; ix += 3) {
+			misses += cache.AddTriangle(indices + ix);
+		}
+		const float clusterAcmr = static_cast<float>(misses) / ((end - start) / 3);
+
+		cache.Flush();
+		splits.push_back(start);
+		misses = 0;
+		uint32_t triangles = 0;
+		for (uint32_t ix = start; ix < end; ix += 3) {
+			misses += cache.AddTriangle(indices + ix);
+			triangles++;
+			if (ix + 3 < end && static_cast<float>(misses) / triangles <= clusterAcmr * threshold) {
+				splits.push_back(ix + 3);
+				cache.Flush();
+				misses = 0;
+				triangles = 0;
+			}
+		}
+	}
+
+	// Work out where each cluster is and which way it faces, weighted by the area of each triangle
+	struct Cluster {
+		uint32_t  Start;
+		uint32_t  End;
+		glm::vec3 Centroid;
+		glm::vec3 Normal;
+		float     SortKey;
+	};
+	std::vector<Cluster> sorted(splits.size());
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+	for (size_t ix = 0; ix < splits.size(); ix++) {
+		Cluster& cluster = sorted[ix];
+		cluster.Start = splits[ix];
+		cluster.End = ix + 1 < splits.size() ? splits[ix + 1] : static_cast<uint32_t>(indexCount);
+		cluster.Centroid = glm::vec3(0.0f);
+		cluster.Normal = glm::vec3(0.0f);
+
+		float area = 0.0f;
+		for (uint32_t tri = cluster.Start; tri < cluster.End; tri += 3) {
+			const glm::vec3& a = GetPosition(vertices, stride, positionOffset, indices[tri + 0]);
+			const glm::vec3& b = GetPosition(vertices, stride, positionOffset, indices[tri + 1]);
+			const glm::vec3& c = GetPosition(vertices, stride, positionOffset, indices[tri + 2]);
+			const glm::vec3 normal = glm::cross(b - a, c - a);
+			const float triArea = glm::length(normal);
+
+			cluster.Centroid += (a + b + c) * (triArea / 3.0f);
+			cluster.Normal += normal;
+			area += triArea;
+		}
+		meshCentroid += cluster.Centroid;
+		meshArea += area;
+		cluster.Centroid = area > 0.0f ? cluster.Centroid / area : cluster.Centroid;
+		float length = glm::length(cluster.Normal);
+		cluster.Normal = length > 0.0f ? cluster.Normal / length : cluster.Normal;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+	// Clusters that face away from the center are on the outside of the mesh, and are drawn first
+	for (Cluster& cluster : sorted) {
+		cluster.SortKey = glm::dot(cluster.Centroid - meshCentroid, cluster.Normal);
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+		return a.SortKey > b.SortKey;
+	});
+
+	size_t written = 0;
+	for (const Cluster& cluster : sorted) {
+		std::copy(indices + cluster.Start, indices + cluster.End, destination + written);
+		written += cluster.End - cluster.Start;
+	}
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride) {
+	constexpr uint32_t Unmapped = ~0u;
+	std::vector<uint32_t> remap(vertexCount, Unmapped);
+
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	uint8_t* target = static_cast<uint8_t*>(destination);
+	uint32_t count = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t& mapped = remap[indices[ix]];
+		if (mapped == Unmapped) {
+			memcpy(target + count * stride, source + indices[ix] * stride, stride);
+			mapped = count++;
+		}
+		indices[ix] = mapped;
+	}
+	return count;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Utils/MeshBuilder.h"
+
+/// <summary>
+/// Re-orders the triangles and vertices of indexed triangle meshes so they render faster, used by
+/// OptimizedObjLoader when converting models. None of the steps change what the mesh looks like
+/// </summary>
+class MeshOptimizer {
+public:
+	MeshOptimizer() = delete;
+
+	// The size of the FIFO cache we simulate when measuring meshes
+	static constexpr uint32_t ANALYZE_CACHE_SIZE = 16;
+	// The cache size that Tipsify optimizes for
+	static constexpr uint32_t TIPSIFY_CACHE_SIZE = 16;
+
+	/// <summary>
+	/// How well a mesh will use the post-transform vertex cache
+	/// </summary>
+	struct CacheStats {
+		// Average cache miss ratio, the number of vertex shader invocations per triangle. Between 0.5 and 3, lower is better
+		float ACMR = 0.0f;
+		// Average transform to vertex ratio, the number of vertex shader invocations per vertex. 1 is ideal
+		float ATVR = 0.0f;
+	};
+
+	/// <summary>
+	/// The stats for a mesh before and after it was optimized
+	/// </summary>
+	struct Report {
+		CacheStats Before;
+		CacheStats After;
+	};
+
+	/// <summary>
+	/// Simulates a FIFO vertex cache to measure how many times each vertex will be transformed
+	/// </summary>
+	static CacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = ANALYZE_CACHE_SIZE);
+
+	/// <summary>
+	/// Re-orders triangles to improve the vertex cache hit rate, using Tipsify (Sander et al, 2007)
+	/// </summary>
+	/// <param name="destination">The array to write the new indices to, must not overlap indices</param>
+	/// <param name="indices">The indices of the triangle list to optimize</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices the indices reference</param>
+	/// <param name="clusters">If not null, will store the index where each run of connected triangles starts</param>
+	static void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr);
+
+	/// <summary>
+	/// Re-orders clusters of triangles so that triangles facing away from the center of the mesh are drawn
+	/// first, which tends to reduce overdraw from any view. Should be run after OptimizeVertexCache
+	/// </summary>
+	/// <param name="destination">The array to write the new indices to, must not overlap indices</param>
+	/// <param name="indices">The indices of the triangle list to optimize</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertices">A pointer to the vertex data</param>
+	/// <param name="vertexCount">The number of vertices in vertices</param>
+	/// <param name="stride">The size of each vertex, in bytes</param>
+	/// <param name="positionOffset">The offset of the vec3 position within each vertex</param>
+	/// <param name="clusters">The clusters that OptimizeVertexCache found</param>
+	/// <param name="threshold">How much the ACMR is allowed to get worse in exchange for smaller clusters</param>
+	static void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, size_t positionOffset, const std::vector<uint32_t>& clusters, float threshold = 1.05f);
+
+	/// <summary>
+	/// Re-orders vertices to be in the order they are first used, so the vertex fetch reads memory
+	/// linearly. Vertices that are not referenced are dropped
+	/// </summary>
+	/// <param name="destination">The array to write the vertices to, must hold vertexCount vertices and not overlap vertices</param>
+	/// <param name="indices">The indices to re-map, modified in place</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertices">The vertices to re-order</param>
+	/// <param name="vertexCount">The number of vertices in vertices</param>
+	/// <param name="stride">The size of each vertex, in bytes</param>
+	/// <returns>The number of vertices written to destination</returns>
+	static size_t OptimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride);
+
+	/// <summary>
+	/// Runs all of the optimization steps on a mesh builder
+	/// </summary>
+	/// <returns>The vertex cache stats before and after optimizing</returns>
+	template <typename VertexType>
+	static Report Optimize(MeshBuilder<VertexType>& mesh);
+};
+
+template <typename VertexType>
+MeshOptimizer::Report MeshOptimizer::Optimize(MeshBuilder<VertexType>& mesh) {
+	Report report;
+	const size_t indexCount  = mesh.GetIndexCount();
+	const size_t vertexCount = mesh.GetVertexCount();
+	if (indexCount < 3 || indexCount % 3 != 0) {
+		return report;
+	}
+
+	report.Before = AnalyzeVertexCache(mesh.GetIndexDataPtr(), indexCount, vertexCount);
+
+	std::vector<uint32_t> clusters;
+	std::vector<uint32_t> cacheOrder(indexCount);
+	OptimizeVertexCache(cacheOrder.data(), mesh.GetIndexDataPtr(), indexCount, vertexCount, &clusters);
+
+	std::vector<uint32_t> indices(indexCount);
+	OptimizeOverdraw(indices.data(), cacheOrder.data(), indexCount, mesh.GetVertexDataPtr(), vertexCount, sizeof(VertexType), offsetof(VertexType, Position), clusters);
+
+	std::vector<VertexType> vertices(vertexCount);
+	vertices.resize(OptimizeVertexFetch(vertices.data(), indices.data(), indexCount, mesh.GetVertexDataPtr(), vertexCount, sizeof(VertexType)));
+
+	report.After = AnalyzeVertexCache(indices.data(), indexCount, vertices.size());
+
+	// Replace the contents of the mesh with the optimized version
+	mesh.Reset();
+	mesh.AddVertexRange(vertices.data(), static_cast<uint32_t>(vertices.size()));
+	mesh.ReserveIndexSpace(indexCount);
+	for (uint32_t index : indices) {
+		mesh.AddIndex(index);
+	}
+
+	return report;
+}
@@ -0,0 +1,307 @@
+#include "Utils/MeshSimplifier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+namespace {
+	/// <summary>
+	/// A symmetric 4x4 matrix that measures the sum of squared distances from a point to a set of planes,
+	/// weighted by the area of the triangle each plane came from
+	/// </summary>
+	struct Quadric {
+		double A2 = 0, AB = 0, AC = 0, AD = 0;
+		double B2 = 0, BC = 0, BD = 0;
+		double C2 = 0, CD = 0;
+		double D2 = 0;
+		double Weight = 0;
+
+		static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight) {
+			Quadric result;
+			result.A2 = normal.x * normal.x * weight;
+			result.AB = normal.x * normal.y * weight;
+			result.AC = normal.x * normal.z * weight;
+			result.AD = normal.x * distance * weight;
+			result.B2 = normal.y * normal.y * weight;
+			result.BC = normal.y * normal.z * weight;
+			result.BD = normal.y * distance * weight;
+			result.C2 = normal.z * normal.z * weight;
+			result.CD = normal.z * distance * weight;
+			result.D2 = distance * distance * weight;
+			result.Weight = weight;
+			return result;
+		}
+
+		Quadric& operator +=(const Quadric& other) {
+			A2 += other.A2; AB += other.AB; AC += other.AC; AD += other.AD;
+			B2 += other.B2; BC += other.BC; BD += other.BD;
+			C2 += other.C2; CD += other.CD;
+			D2 += other.D2;
+			Weight += other.Weight;
+			return *this;
+		}
+
+		/// <summary>
+		/// Returns the average squared distance from the point to the planes
+		/// </summary>
+		double Evaluate(const glm::dvec3& p) const {
+			const double result =
+				A2 * p.x * p.x + 2.0 * AB * p.x * p.y + 2.0 * AC * p.x * p.z + 2.0 * AD * p.x +
+				B2 * p.y * p.y + 2.0 * BC * p.y * p.z + 2.0 * BD * p.y +
+				C2 * p.z * p.z + 2.0 * CD * p.z +
+				D2;
+			return Weight > 0.0 ? glm::abs(result) / Weight : 0.0;
+		}
+	};
+
+	struct Collapse {
+		uint32_t From;
+		uint32_t To;
+		double   Cost;
+	};
+
+	inline uint64_t EdgeKey(uint32_t a, uint32_t b) {
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+}
+
+size_t MeshSimplifier::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, size_t positionOffset, size_t targetIndexCount, float targetError, float* resultError) {
+	std::vector<uint32_t> working(indices, indices + indexCount);
+	if (resultError != nullptr) {
+		*resultError = 0.0f;
+	}
+	if (indexCount < 3 || vertexCount == 0) {
+		std::copy(working.begin(), working.end(), destination);
+		return working.size();
+	}
+
+	// Copy out the positions, scaled so the largest extent of the mesh is 1. That keeps the quadrics well
+	// conditioned, and makes the errors relative to the size of the mesh
+	std::vector<glm::dvec3> positions(vertexCount);
+	glm::dvec3 min = glm::dvec3(std::numeric_limits<double>::max());
+	glm::dvec3 max = glm::dvec3(std::numeric_limits<double>::lowest());
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		glm::vec3 position;
+		memcpy(&position, static_cast<const uint8_t*>(vertices) + ix * stride + positionOffset, sizeof(glm::vec3));
+		positions[ix] = glm::dvec3(position);
+		min = glm::min(min, positions[ix]);
+		max = glm::max(max, positions[ix]);
+	}
+	const glm::dvec3 extents = max - min;
+	const double scale = glm::max(extents.x, glm::max(extents.y, extents.z));
+	const double invScale = scale > 0.0 ? 1.0 / scale : 0.0;
+	for (glm::dvec3& position : positions) {
+		position = (position - min) * invScale;
+	}
+
+	// Vertices that share a position are split by a seam, we look at the mesh through the first vertex at
+	// each position to find the real open edges
+	std::vector<uint32_t> canonical(vertexCount);
+	std::vector<bool> isLocked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> firstAtPosition;
+		firstAtPosition.reserve(vertexCount);
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			const glm::vec3 position = glm::vec3(positions[ix]);
+			uint32_t bits[3];
+			memcpy(bits, &position, sizeof(bits));
+			const uint64_t hash = (bits[0] * 0x9E3779B1ull) ^ (bits[1] * 0x85EBCA77ull << 16) ^ (bits[2] * 0xC2B2AE3Dull << 32);
+
+			// A hash collision only makes us lock a few more vertices than we need to, so we don't compare the positions
+			auto it = firstAtPosition.find(hash);
+			if (it == firstAtPosition.end()) {
+				firstAtPosition[hash] = ix;
+				canonical[ix] = ix;
+			} else {
+				canonical[ix] = it->second;
+				isLocked[ix] = true;
+				isLocked[it->second] = true;
+			}
+		}
+
+		// Any edge that only one triangle uses is on the outline of the mesh, and edges with more than two
+		// triangles are non-manifold, neither can be moved without changing the shape of the mesh
+		std::vector<uint64_t> edges;
+		edges.reserve(indexCount);
+		for (size_t ix = 0; ix < indexCount; ix += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				edges.push_back(EdgeKey(canonical[indices[ix + corner]], canonical[indices[ix + (corner + 1) % 3]]));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for (size_t ix = 0; ix < edges.size();) {
+			size_t end = ix + 1;
+			while (end < edges.size() && edges[end] == edges[ix]) {
+				end++;
+			}
+			if (end - ix != 2) {
+				isLocked[static_cast<uint32_t>(edges[ix] >> 32)] = true;
+				isLocked[static_cast<uint32_t>(edges[ix])] = true;
+			}
+			ix = end;
+		}
+
+		// The canonical vertex stands in for everything at it's position
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			if (isLocked[canonical[ix]]) {
+				isLocked[ix] = true;
+			}
+		}
+	}
+
+	// Each vertex starts with the planes of all the triangles around it
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t ix = 0; ix < indexCount; ix += 3) {
+		const glm::dvec3& a = positions[working[ix + 0]];
+		const glm::dvec3& b = positions[working[ix + 1]];
+		const glm::dvec3& c = positions[working[ix + 2]];
+		glm::dvec3 normal = glm::cross(b - a, c - a);
+		const double area = glm::length(normal);
+		if (area <= 0.0) {
+			continue;
+		}
+		normal /= area;
+		const Quadric plane = Quadric::FromPlane(normal, -glm::dot(normal, a), area);
+		for (int corner = 0; corner < 3; corner++) {
+			quadrics[working[ix + corner]] += plane;
+		}
+	}
+
+	const double maxCost = static_cast<double>(targetError) * targetError;
+	double error = 0.0;
+
+	std::vector<uint64_t> edges;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> adjacencyStarts(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool>     isTouched(vertexCount);
+
+	// Each pass collapses as many independent edges as it can, cheapest first, then cleans up the triangles
+	size_t currentCount = working.size();
+	while (currentCount > targetIndexCount) {
+		// Find the unique edges, and the cheapest way to collapse each of them
+		edges.clear();
+		for (size_t ix = 0; ix < currentCount; ix += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				edges.push_back(EdgeKey(working[ix + corner], working[ix + (corner + 1) % 3]));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		collapses.clear();
+		for (uint64_t edge : edges) {
+			const uint32_t a = static_cast<uint32_t>(edge >> 32);
+			const uint32_t b = static_cast<uint32_t>(edge);
+			if (isLocked[a] && isLocked[b]) {
+				continue;
+			}
+			Quadric combined = quadrics[a];
+			combined += quadrics[b];
+			const double costAtA = isLocked[b] ? std::numeric_limits<double>::max() : combined.Evaluate(positions[a]);
+			const double costAtB = isLocked[a] ? std::numeric_limits<double>::max() : combined.Evaluate(positions[b]);
+			const Collapse collapse = costAtB <= costAtA ? Collapse{ a, b, costAtB } : Collapse{ b, a, costAtA };
+			if (collapse.Cost <= maxCost) {
+				collapses.push_back(collapse);
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.Cost < b.Cost;
+		});
+
+		// Build the list of triangles around each vertex
+		std::fill(adjacencyStarts.begin(), adjacencyStarts.end(), 0);
+		for (size_t ix = 0; ix < currentCount; ix++) {
+			adjacencyStarts[working[ix] + 1]++;
+		}
+		std::partial_sum(adjacencyStarts.begin(), adjacencyStarts.end(), adjacencyStarts.begin());
+		adjacency.resize(currentCount);
+		{
+			std::vector<uint32_t> fill(adjacencyStarts.begin(), adjacencyStarts.end() - 1);
+			for (size_t ix = 0; ix < currentCount; ix++) {
+				adjacency[fill[working[ix]]++] = static_cast<uint32_t>(ix / 3);
+			}
+		}
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(isTouched.begin(), isTouched.end(), false);
+		size_t remaining = currentCount;
+		size_t collapsed = 0;
+		for (const Collapse& collapse : collapses) {
+			if (remaining <= targetIndexCount) {
+				break;
+			}
+			if (isTouched[collapse.From] || isTouched[collapse.To]) {
+				continue;
+			}
+
+			// Make sure none of the triangles that move would flip over, or get stretched to nothing
+			bool isValid = true;
+			uint32_t removed = 0;
+			for (uint32_t ix = adjacencyStarts[collapse.From]; ix < adjacencyStarts[collapse.From + 1] && isValid; ix++) {
+				const uint32_t* triangle = &working[adjacency[ix] * 3];
+				if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To) {
+					removed++;
+					continue;
+				}
+				glm::dvec3 corners[3];
+				for (int corner = 0; corner < 3; corner++) {
+					corners[corner] = positions[triangle[corner]];
+				}
+				const glm::dvec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				for (int corner = 0; corner < 3; corner++) {
+					if (triangle[corner] == collapse.From) {
+						corners[corner] = positions[collapse.To];
+					}
+				}
+				const glm::dvec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				const double lengths = glm::length(before) * glm::length(after);
+				isValid = lengths > 0.0 && glm::dot(before, after) >= 0.25 * lengths;
+			}
+			if (!isValid) {
+				continue;
+			}
+
+			// The triangles around the collapsed vertex have changed, so nothing else touching them can move this pass
+			for (uint32_t ix = adjacencyStarts[collapse.From]; ix < adjacencyStarts[collapse.From + 1]; ix++) {
+				const uint32_t* triangle = &working[adjacency[ix] * 3];
+				isTouched[triangle[0]] = isTouched[triangle[1]] = isTouched[triangle[2]] = true;
+			}
+			remap[collapse.From] = collapse.To;
+			quadrics[collapse.To] += quadrics[collapse.From];
+			error = glm::max(error, collapse.Cost);
+			remaining -= removed * 3;
+			collapsed++;
+		}
+		if (collapsed == 0) {
+			break;
+		}
+
+		// Apply the collapses, and drop the triangles that no longer have any area
+		size_t written = 0;
+		for (size_t ix = 0; ix < currentCount; ix += 3) {
+			const uint32_t a = remap[working[ix + 0]];
+			const uint32_t b = remap[working[ix + 1]];
+			const uint32_t c = remap[working[ix + 2]];
+			if (a != b && b != c && a != c) {
+				working[written++] = a;
+				working[written++] = b;
+				working[written++] = c;
+			}
+		}
+		currentCount = written;
+	}
+
+	std::copy(working.begin(), working.begin() + currentCount, destination);
+	if (resultError != nullptr) {
+		*resultError = static_cast<float>(glm::sqrt(error));
+	}
+	return currentCount;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/MeshBuilder.h"
+#include "Utils/MeshOptimizer.h"
+
+/// <summary>
+/// Reduces the triangle count of indexed meshes with quadric error metric edge collapses (Garland and
+/// Heckbert, 1997), used to build the LOD chains that OptimizedObjLoader stores in binary mesh files.
+///
+/// Vertices are only ever collapsed onto other existing vertices, so every LOD can share the vertex
+/// buffer of the full detail mesh and only needs it's own range of indices
+/// </summary>
+class MeshSimplifier {
+public:
+	MeshSimplifier() = delete;
+
+	// The most levels (including the full detail mesh) that GenerateLods will create
+	static constexpr uint32_t MAX_LODS = 4;
+	// The largest error (relative to the size of the mesh) that a LOD may have before we stop generating them
+	static constexpr float MAX_LOD_ERROR = 0.05f;
+	// A LOD has to remove at least this fraction of the previous level's triangles to be worth keeping
+	static constexpr float MIN_LOD_REDUCTION = 0.1f;
+	// Meshes with less triangles than this are not worth simplifying
+	static constexpr uint32_t MIN_LOD_TRIANGLES = 32;
+
+	/// <summary>
+	/// Simplifies a triangle list by collapsing edges until it has at most targetIndexCount indices, or
+	/// until the next collapse would move the surface further than targetError. Open edges and vertices
+	/// that are split by a UV or normal seam are never moved, so the outline and seams of the mesh are kept
+	/// </summary>
+	/// <param name="destination">The array to write the new indices to, must hold indexCount indices</param>
+	/// <param name="indices">The indices of the triangle list to simplify</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertices">A pointer to the vertex data</param>
+	/// <param name="vertexCount">The number of vertices in vertices</param>
+	/// <param name="stride">The size of each vertex, in bytes</param>
+	/// <param name="positionOffset">The offset of the vec3 position within each vertex</param>
+	/// <param name="targetIndexCount">The number of indices to aim for</param>
+	/// <param name="targetError">The largest error allowed, relative to the largest extent of the mesh</param>
+	/// <param name="resultError">If not null, will store the error of the simplified mesh, relative to the largest extent of the mesh</param>
+	/// <returns>The number of indices written to destination</returns>
+	static size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, size_t positionOffset, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	/// <summary>
+	/// Generates a chain of LODs for a mesh builder, each with about half the triangles of the one before.
+	/// The indices for each LOD are appended to the mesh, after the indices of the full detail mesh
+	/// </summary>
+	/// <returns>The index range and error of each level, starting with the full detail mesh</returns>
+	template <typename VertexType>
+	static std::vector<MeshLod> GenerateLods(MeshBuilder<VertexType>& mesh, uint32_t maxLods = MAX_LODS);
+};
+
+template <typename VertexType>
+std::vector<MeshLod> MeshSimplifier::GenerateLods(MeshBuilder<VertexType>& mesh, uint32_t maxLods) {
+	const uint32_t indexCount  = static_cast<uint32_t>(mesh.GetIndexCount());
+	const uint32_t vertexCount = static_cast<uint32_t>(mesh.GetVertexCount());
+	std::vector<MeshLod> result = { MeshLod{ 0, indexCount, 0.0f } };
+	if (indexCount % 3 != 0 || indexCount / 3 < MIN_LOD_TRIANGLES) {
+		return result;
+	}
+
+	// Every level is simplified from the full detail mesh, so the errors don't stack up
+	const std::vector<uint32_t> source(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + indexCount);
+	std::vector<uint32_t> simplified(indexCount);
+	std::vector<uint32_t> optimized(indexCount);
+	for (uint32_t level = 1; level < maxLods; level++) {
+		const MeshLod& previous = result.back();
+		float error = 0.0f;
+		const size_t count = Simplify(simplified.data(), source.data(), indexCount, mesh.GetVertexDataPtr(), vertexCount,
+			sizeof(VertexType), offsetof(VertexType, Position), indexCount >> level, MAX_LOD_ERROR, &error);
+
+		// Stop once we can't make enough progress, or there's nothing left to draw
+		if (count < 3 || count > previous.IndexCount * (1.0f - MIN_LOD_REDUCTION)) {
+			break;
+		}
+
+		MeshOptimizer::OptimizeVertexCache(optimized.data(), simplified.data(), count, vertexCount);
+		result.push_back(MeshLod{ static_cast<uint32_t>(mesh.GetIndexCount()), static_cast<uint32_t>(count), error });
+		mesh.ReserveIndexSpace(count);
+		for (size_t ix = 0; ix < count; ix++) {
+			mesh.AddIndex(optimized[ix]);
+		}
+	}
+
+	return result;
+}
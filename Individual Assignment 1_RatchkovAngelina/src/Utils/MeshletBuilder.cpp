@@ -0,0 +1,106 @@
+#include "Utils/MeshletBuilder.h"
+
+#include <cstring>
+#include <GLM/glm.hpp>
+
+namespace {
+	inline glm::vec3 GetPosition(const void* vertices, size_t stride, size_t offset, uint32_t index) {
+		glm::vec3 result;
+		memcpy(&result, static_cast<const uint8_t*>(vertices) + index * stride + offset, sizeof(glm::vec3));
+		return result;
+	}
+}
+
+std::vector<Meshlet> MeshletBuilder::Build(const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, size_t positionOffset) {
+	std::vector<Meshlet> result;
+	if (indexCount < 3) {
+		return result;
+	}
+	result.reserve(indexCount / (MAX_TRIANGLES * 3) + 1);
+
+	// Stamping each vertex with the cluster that last used it lets us count unique vertices without clearing a set
+	std::vector<uint32_t> lastUsedBy(vertexCount, ~0u);
+	Meshlet current;
+	uint32_t currentId = 0;
+	uint32_t uniqueVertices = 0;
+
+	for (size_t ix = 0; ix + 2 < indexCount; ix += 3) {
+		uint32_t newVertices = 0;
+		for (int corner = 0; corner < 3; corner++) {
+			newVertices += lastUsedBy[indices[ix + corner]] != currentId ? 1 : 0;
+		}
+
+		// Start a new cluster when this triangle doesn't fit in the current one
+		if (uniqueVertices + newVertices > MAX_VERTICES || current.IndexCount / 3 >= MAX_TRIANGLES) {
+			_CalculateBounds(current, indices, vertices, stride, positionOffset);
+			result.push_back(current);
+
+			current = Meshlet();
+			current.FirstIndex = static_cast<uint32_t>(ix);
+			currentId++;
+			uniqueVertices = 0;
+		}
+
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t& stamp = lastUsedBy[indices[ix + corner]];
+			if (stamp != currentId) {
+				stamp = currentId;
+				uniqueVertices++;
+			}
+		}
+		current.IndexCount += 3;
+	}
+
+	if (current.IndexCount > 0) {
+		_CalculateBounds(current, indices, vertices, stride, positionOffset);
+		result.push_back(current);
+	}
+	return result;
+}
+
+void MeshletBuilder::_CalculateBounds(Meshlet& meshlet, const uint32_t* indices, const void* vertices, size_t stride, size_t positionOffset) {
+	const uint32_t* first = indices + meshlet.FirstIndex;
+
+	// The sphere is centered on the box around the vertices, which is close enough for small clusters
+	Bounds bounds;
+	for (uint32_t ix = 0; ix < meshlet.IndexCount; ix++) {
+		bounds.Encapsulate(GetPosition(vertices, stride, positionOffset, first[ix]));
+	}
+	meshlet.Center = bounds.GetCenter();
+	meshlet.Radius = 0.0f;
+	for (uint32_t ix = 0; ix < meshlet.IndexCount; ix++) {
+		meshlet.Radius = glm::max(meshlet.Radius, glm::length(GetPosition(vertices, stride, positionOffset, first[ix]) - meshlet.Center));
+	}
+
+	// The cone axis is the average of the triangle normals, and it's width is set by the normal furthest from it
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.IndexCount / 3);
+	glm::vec3 axis = glm::vec3(0.0f);
+	for (uint32_t ix = 0; ix < meshlet.IndexCount; ix += 3) {
+		const glm::vec3 a = GetPosition(vertices, stride, positionOffset, first[ix + 0]);
+		const glm::vec3 b = GetPosition(vertices, stride, positionOffset, first[ix + 1]);
+		const glm::vec3 c = GetPosition(vertices, stride, positionOffset, first[ix + 2]);
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const float length = glm::length(normal);
+		if (length > 0.0f) {
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+	}
+
+	const float axisLength = glm::length(axis);
+	meshlet.ConeAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f);
+	meshlet.ConeCutoff = 1.0f;
+	if (axisLength <= 0.0f) {
+		return;
+	}
+
+	float minDot = 1.0f;
+	for (const glm::vec3& normal : normals) {
+		minDot = glm::min(minDot, glm::dot(normal, meshlet.ConeAxis));
+	}
+	// If the cone is 90 degrees or wider, some triangle is always facing the camera
+	if (minDot > 0.0f) {
+		meshlet.ConeCutoff = glm::sqrt(1.0f - minDot * minDot);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/MeshBuilder.h"
+
+/// <summary>
+/// Splits indexed triangle meshes into small clusters (meshlets), each with a bounding sphere and a cone
+/// around it's normals. The renderer uses these to cull the parts of large meshes that are off screen or
+/// facing away from the camera, see ClusterCuller
+/// </summary>
+class MeshletBuilder {
+public:
+	MeshletBuilder() = delete;
+
+	// The most unique vertices a cluster may reference
+	static constexpr uint32_t MAX_VERTICES  = 64;
+	// The most triangles a cluster may contain
+	static constexpr uint32_t MAX_TRIANGLES = 124;
+	// Meshes with fewer triangles than this are cheaper to draw whole than to cull cluster by cluster
+	static constexpr uint32_t MIN_MESH_TRIANGLES = 32 * MAX_TRIANGLES;
+
+	/// <summary>
+	/// Splits a triangle list into clusters. Triangles are not re-ordered, so each cluster is a range of
+	/// the index buffer. Run this after MeshOptimizer, so that neighbouring triangles are next to each other
+	/// </summary>
+	/// <param name="indices">The indices of the triangle list to split</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertices">A pointer to the vertex data</param>
+	/// <param name="vertexCount">The number of vertices in vertices</param>
+	/// <param name="stride">The size of each vertex, in bytes</param>
+	/// <param name="positionOffset">The offset of the vec3 position within each vertex</param>
+	/// <returns>The clusters, in index buffer order</returns>
+	static std::vector<Meshlet> Build(const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t stride, size_t positionOffset);
+
+	/// <summary>
+	/// Splits the first indexCount indices of a mesh builder into clusters, if the mesh is large enough to be
+	/// worth it (see MIN_MESH_TRIANGLES)
+	/// </summary>
+	/// <returns>The clusters, or an empty list if the mesh is too small</returns>
+	template <typename VertexType>
+	static std::vector<Meshlet> Build(const MeshBuilder<VertexType>& mesh, size_t indexCount);
+
+protected:
+	/// <summary>
+	/// Calculates the bounding sphere and normal cone for a range of triangles
+	/// </summary>
+	static void _CalculateBounds(Meshlet& meshlet, const uint32_t* indices, const void* vertices, size_t stride, size_t positionOffset);
+};
+
+template <typename VertexType>
+std::vector<Meshlet> MeshletBuilder::Build(const MeshBuilder<VertexType>& mesh, size_t indexCount) {
+	if (indexCount / 3 < MIN_MESH_TRIANGLES) {
+		return std::vector<Meshlet>();
+	}
+	return Build(mesh.GetIndexDataPtr(), indexCount, mesh.GetVertexDataPtr(), mesh.GetVertexCount(), sizeof(VertexType), offsetof(VertexType, Position));
+}
@@ -0,0 +1,387 @@
+#include "Utils/ObjParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+#include <GLFW/glfw3.h>
+
+#include "Utils/JobSystem.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Logging.h"
+
+namespace {
+	inline bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipSpaces(const char* ptr, const char* end) {
+		while (ptr < end && IsSpace(*ptr)) { ptr++; }
+		return ptr;
+	}
+
+	/// <summary>
+	/// Returns a pointer to the first character after the end of the current line
+	/// </summary>
+	inline const char* NextLine(const char* ptr, const char* end) {
+		const char* newline = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+		return newline != nullptr ? newline + 1 : end;
+	}
+
+	/// <summary>
+	/// Parses a float, advancing ptr past it. Values that fail to parse are left as 0
+	/// </summary>
+	inline float ReadFloat(const char*& ptr, const char* end) {
+		ptr = SkipSpaces(ptr, end);
+		// from_chars does not accept a leading plus sign
+		if (ptr < end && *ptr == '+') { ptr++; }
+		float result = 0.0f;
+		auto [next, error] = std::from_chars(ptr, end, result);
+		if (error == std::errc()) {
+			ptr = next;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Parses a single attribute index of a face corner, converting it to be 0-based. Relative
+	/// (negative) indices are converted to be relative to the start of the chunk, and flagged so
+	/// they can be offset once the number of attributes before the chunk is known
+	/// </summary>
+	inline int ReadIndex(const char*& ptr, const char* end, size_t count, int missing, bool& isRelative) {
+		int value = 0;
+		auto [next, error] = std::from_chars(ptr, end, value);
+		if (error != std::errc() || value == 0) {
+			return missing;
+		}
+		ptr = next;
+		isRelative = value < 0;
+		return value > 0 ? value - 1 : static_cast<int>(count) + value;
+	}
+
+	inline uint64_t HashCorner(const glm::ivec3& key) {
+		uint64_t hash = static_cast<uint32_t>(key.x);
+		hash = hash * 0x9E3779B185EBCA87ull ^ static_cast<uint32_t>(key.y);
+		hash = hash * 0x9E3779B185EBCA87ull ^ static_cast<uint32_t>(key.z);
+		return hash ^ (hash >> 29);
+	}
+
+	struct CornerHash {
+		size_t operator()(const glm::ivec3& key) const {
+			return static_cast<size_t>(HashCorner(key));
+		}
+	};
+
+	// Partitions use the top bits of the hash, so keys within a partition still spread across all of it's buckets
+	inline uint32_t CornerPartition(const glm::ivec3& key, uint32_t numPartitions) {
+		return static_cast<uint32_t>((HashCorner(key) >> 40) % numPartitions);
+	}
+
+	struct FaceCorner {
+		glm::ivec3 Index;
+		// Bit N is set if component N of Index is relative
+		uint8_t    Relative;
+	};
+
+	template <typename T>
+	void Append(std::vector<T>& target, std::vector<T>& source) {
+		if (target.empty()) {
+			target = std::move(source);
+		} else {
+			target.insert(target.end(), source.begin(), source.end());
+		}
+	}
+}
+
+JobSystem* ObjParser::_jobs = nullptr;
+
+void ObjParser::Init(JobSystem& jobs) {
+	_jobs = &jobs;
+}
+
+bool ObjParser::ParseFile(const std::string& filename, Data& result) {
+	MemoryMappedFile file(filename);
+	if (!file.IsOpen()) {
+		return false;
+	}
+
+	float startTime = static_cast<float>(glfwGetTime());
+
+	const char* begin = reinterpret_cast<const char*>(file.GetData());
+	if (_jobs != nullptr && file.GetSize() >= 2 * MIN_CHUNK_SIZE) {
+		_ParseParallel(begin, begin + file.GetSize(), result);
+	} else {
+		Parse(begin, begin + file.GetSize(), result);
+	}
+
+	float elapsed = static_cast<float>(glfwGetTime()) - startTime;
+	float megabytes = file.GetSize() / (1024.0f * 1024.0f);
+	LOG_TRACE("Parsed \"{}\" in {} seconds ({:.1f} MB/s, {} triangles)", filename, elapsed, elapsed > 0.0f ? megabytes / elapsed : 0.0f, result.Corners.size() / 3);
+
+	return true;
+}
+
+void ObjParser::Parse(const char* begin, const char* end, Data& result) {
+	Chunk chunk;
+	_ParseChunk(begin, end, chunk);
+
+	// Indices are validated against everything that's been parsed into result so far
+	const glm::ivec3 base = glm::ivec3(result.Positions.size(), result.UVs.size(), result.Normals.size());
+	const glm::ivec3 totals = base + glm::ivec3(chunk.Positions.size(), chunk.UVs.size(), chunk.Normals.size());
+	_ResolveChunk(chunk, base, totals);
+
+	Append(result.Positions, chunk.Positions);
+	Append(result.UVs, chunk.UVs);
+	Append(result.Normals, chunk.Normals);
+	Append(result.Corners, chunk.Corners);
+}
+
+void ObjParser::_ParseChunk(const char* begin, const char* end, Chunk& result) {
+	// The corners of the face being read, re-used between faces to avoid allocations
+	std::vector<FaceCorner> polygon;
+	polygon.reserve(8);
+
+	const char* ptr = begin;
+	while (ptr < end) {
+		ptr = SkipSpaces(ptr, end);
+		if (ptr >= end) {
+			break;
+		}
+
+		const char command = *ptr;
+		const char next    = ptr + 1 < end ? ptr[1] : '\n';
+
+		// The v command defines a vertex's position
+		if (command == 'v' && IsSpace(next)) {
+			ptr += 1;
+			glm::vec3 position;
+			position.x = ReadFloat(ptr, end);
+			position.y = ReadFloat(ptr, end);
+			position.z = ReadFloat(ptr, end);
+			result.Positions.push_back(position);
+		}
+		else if (command == 'v' && next == 't') {
+			ptr += 2;
+			glm::vec2 uv;
+			uv.x = ReadFloat(ptr, end);
+			uv.y = ReadFloat(ptr, end);
+			result.UVs.push_back(uv);
+		}
+		else if (command == 'v' && next == 'n') {
+			ptr += 2;
+			glm::vec3 normal;
+			normal.x = ReadFloat(ptr, end);
+			normal.y = ReadFloat(ptr, end);
+			normal.z = ReadFloat(ptr, end);
+			result.Normals.push_back(normal);
+		}
+		// The f command defines a polygon in the mesh, with corners in the form v, v/vt, v//vn or v/vt/vn
+		else if (command == 'f' && IsSpace(next)) {
+			ptr += 1;
+			polygon.clear();
+			while (true) {
+				ptr = SkipSpaces(ptr, end);
+				if (ptr >= end || *ptr == '\n' || *ptr == '#') {
+					break;
+				}
+
+				glm::ivec3 corner = glm::ivec3(MISSING_INDEX);
+				bool relative[3] = { false, false, false };
+				corner.x = ReadIndex(ptr, end, result.Positions.size(), MISSING_INDEX, relative[0]);
+				if (ptr < end && *ptr == '/') {
+					ptr++;
+					if (ptr < end && *ptr != '/') {
+						corner.y = ReadIndex(ptr, end, result.UVs.size(), MISSING_INDEX, relative[1]);
+					}
+					if (ptr < end && *ptr == '/') {
+						ptr++;
+						corner.z = ReadIndex(ptr, end, result.Normals.size(), MISSING_INDEX, relative[2]);
+					}
+				}
+
+				// Skip anything we couldn't make sense of, so we don't get stuck on it
+				while (ptr < end && !IsSpace(*ptr) && *ptr != '\n') { ptr++; }
+
+				if (corner.x != MISSING_INDEX) {
+					polygon.push_back({ corner, static_cast<uint8_t>(relative[0] | (relative[1] << 1) | (relative[2] << 2)) });
+				}
+			}
+
+			// Triangulate the polygon as a fan around it's first corner
+			auto addCorner = [&](const FaceCorner& corner) {
+				for (uint32_t component = 0; component < 3; component++) {
+					if (corner.Relative & (1 << component)) {
+						result.Relative.push_back(static_cast<uint32_t>(result.Corners.size()) * 3 + component);
+					}
+				}
+				result.Corners.push_back(corner.Index);
+			};
+			for (size_t ix = 2; ix < polygon.size(); ix++) {
+				addCorner(polygon[0]);
+				addCorner(polygon[ix - 1]);
+				addCorner(polygon[ix]);
+			}
+		}
+
+		// Everything else (comments, groups, materials, etc...) is ignored
+		ptr = NextLine(ptr, end);
+	}
+}
+
+void ObjParser::Deduplicate(const Data& data, std::vector<glm::ivec3>& vertices, std::vector<uint32_t>& indices) {
+	if (_jobs != nullptr && data.Corners.size() >= 2 * DEDUP_BATCH_SIZE) {
+		_DeduplicateParallel(data, vertices, indices);
+		return;
+	}
+
+	// Maps a combination of attribute indices to the vertex that has been created for it
+	std::unordered_map<glm::ivec3, uint32_t, CornerHash> vertexMap;
+	vertexMap.reserve(data.Corners.size() / 2);
+
+	vertices.clear();
+	indices.clear();
+	indices.reserve(data.Corners.size());
+
+	for (const glm::ivec3& corner : data.Corners) {
+		auto [it, inserted] = vertexMap.try_emplace(corner, static_cast<uint32_t>(vertices.size()));
+		if (inserted) {
+			vertices.push_back(corner);
+		}
+		indices.push_back(it->second);
+	}
+}
+
+void ObjParser::_ResolveChunk(Chunk& chunk, const glm::ivec3& base, const glm::ivec3& totals) {
+	for (uint32_t slot : chunk.Relative) {
+		chunk.Corners[slot / 3][slot % 3] += base[slot % 3];
+	}
+	chunk.Relative.clear();
+
+	// Compact the valid triangles to the front of the array
+	size_t count = 0;
+	for (size_t ix = 0; ix + 2 < chunk.Corners.size(); ix += 3) {
+		bool isValid = true;
+		for (size_t corner = ix; corner < ix + 3; corner++) {
+			glm::ivec3& index = chunk.Corners[corner];
+			isValid &= index.x >= 0 && index.x < totals.x;
+			index.y = index.y >= 0 && index.y < totals.y ? index.y : -1;
+			index.z = index.z >= 0 && index.z < totals.z ? index.z : -1;
+		}
+		if (isValid) {
+			std::copy(chunk.Corners.begin() + ix, chunk.Corners.begin() + ix + 3, chunk.Corners.begin() + count);
+			count += 3;
+		}
+	}
+	chunk.Corners.resize(count);
+}
+
+void ObjParser::_ParseParallel(const char* begin, const char* end, Data& result) {
+	// Split the file into a few chunks per thread, so that chunks with a lot of faces don't hold everyone up
+	const size_t size = end - begin;
+	const uint32_t numChunks = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(size / MIN_CHUNK_SIZE, _jobs->GetThreadCount() * 4)));
+
+	// Move every split point forward to the start of the next line
+	std::vector<const char*> starts(numChunks + 1);
+	starts[0] = begin;
+	starts[numChunks] = end;
+	for (uint32_t ix = 1; ix < numChunks; ix++) {
+		const char* split = std::max(begin + size * ix / numChunks, starts[ix - 1]);
+		starts[ix] = NextLine(split, end);
+	}
+
+	std::vector<Chunk> chunks(numChunks);
+	_jobs->ParallelFor(numChunks, 1, [&](uint32_t ix) {
+		_ParseChunk(starts[ix], starts[ix + 1], chunks[ix]);
+	});
+
+	// Now that we know how many attributes are in each chunk, we can work out where they all start
+	std::vector<glm::ivec3> bases(numChunks);
+	std::vector<size_t>     cornerOffsets(numChunks);
+	glm::ivec3 totals = glm::ivec3(result.Positions.size(), result.UVs.size(), result.Normals.size());
+	for (uint32_t ix = 0; ix < numChunks; ix++) {
+		bases[ix] = totals;
+		totals += glm::ivec3(chunks[ix].Positions.size(), chunks[ix].UVs.size(), chunks[ix].Normals.size());
+	}
+
+	_jobs->ParallelFor(numChunks, 1, [&](uint32_t ix) {
+		_ResolveChunk(chunks[ix], bases[ix], totals);
+	});
+
+	// Triangles may have been dropped, so corners are laid out after resolving
+	size_t numCorners = result.Corners.size();
+	for (uint32_t ix = 0; ix < numChunks; ix++) {
+		cornerOffsets[ix] = numCorners;
+		numCorners += chunks[ix].Corners.size();
+	}
+
+	// Copy every chunk into it's place in the result
+	result.Positions.resize(totals.x);
+	result.UVs.resize(totals.y);
+	result.Normals.resize(totals.z);
+	result.Corners.resize(numCorners);
+	_jobs->ParallelFor(numChunks, 1, [&](uint32_t ix) {
+		const Chunk& chunk = chunks[ix];
+		std::copy(chunk.Positions.begin(), chunk.Positions.end(), result.Positions.begin() + bases[ix].x);
+		std::copy(chunk.UVs.begin(), chunk.UVs.end(), result.UVs.begin() + bases[ix].y);
+		std::copy(chunk.Normals.begin(), chunk.Normals.end(), result.Normals.begin() + bases[ix].z);
+		std::copy(chunk.Corners.begin(), chunk.Corners.end(), result.Corners.begin() + cornerOffsets[ix]);
+	});
+}
+
+void ObjParser::_DeduplicateParallel(const Data& data, std::vector<glm::ivec3>& vertices, std::vector<uint32_t>& indices) {
+	const uint32_t count = static_cast<uint32_t>(data.Corners.size());
+	const uint32_t numPartitions = std::min<uint32_t>(_jobs->GetThreadCount(), 256);
+	const uint32_t numBlocks = (count + DEDUP_BATCH_SIZE - 1) / DEDUP_BATCH_SIZE;
+
+	// Each corner belongs to a single partition, so every partition can have it's own map
+	std::vector<uint8_t> partitions(count);
+	_jobs->ParallelFor(count, DEDUP_BATCH_SIZE, [&](uint32_t ix) {
+		partitions[ix] = static_cast<uint8_t>(CornerPartition(data.Corners[ix], numPartitions));
+	});
+
+	// Find the first corner that uses the same attributes as each corner
+	std::vector<uint32_t> firstUse(count);
+	_jobs->ParallelFor(numPartitions, 1, [&](uint32_t partition) {
+		std::unordered_map<glm::ivec3, uint32_t, CornerHash> vertexMap;
+		vertexMap.reserve(count / numPartitions / 2);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			if (partitions[ix] == partition) {
+				firstUse[ix] = vertexMap.try_emplace(data.Corners[ix], ix).first->second;
+			}
+		}
+	});
+
+	// Number the unique corners in the order they first appear, so we match the serial version
+	std::vector<uint32_t> blockStarts(numBlocks + 1, 0);
+	_jobs->ParallelFor(numBlocks, 1, [&](uint32_t block) {
+		const uint32_t end = std::min(count, (block + 1) * DEDUP_BATCH_SIZE);
+		uint32_t unique = 0;
+		for (uint32_t ix = block * DEDUP_BATCH_SIZE; ix < end; ix++) {
+			unique += firstUse[ix] == ix;
+		}
+		blockStarts[block + 1] = unique;
+	});
+	for (uint32_t block = 0; block < numBlocks; block++) {
+		blockStarts[block + 1] += blockStarts[block];
+	}
+
+	vertices.resize(blockStarts[numBlocks]);
+	indices.resize(count);
+	_jobs->ParallelFor(numBlocks, 1, [&](uint32_t block) {
+		const uint32_t end = std::min(count, (block + 1) * DEDUP_BATCH_SIZE);
+		uint32_t vertex = blockStarts[block];
+		for (uint32_t ix = block * DEDUP_BATCH_SIZE; ix < end; ix++) {
+			if (firstUse[ix] == ix) {
+				vertices[vertex] = data.Corners[ix];
+				indices[ix] = vertex++;
+			}
+		}
+	});
+
+	// Every other corner takes the vertex of the first corner it matched
+	_jobs->ParallelFor(count, DEDUP_BATCH_SIZE, [&](uint32_t ix) {
+		if (firstUse[ix] != ix) {
+			indices[ix] = indices[firstUse[ix]];
+		}
+	});
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+class JobSystem;
+
+/// <summary>
+/// The OBJ parsing core shared by ObjLoader and OptimizedObjLoader. Files are mapped into
+/// memory and scanned with pointers instead of streams, with numbers parsed by std::from_chars
+///
+/// Supports v, vt, vn and f lines. Faces can have any number of corners (they are triangulated
+/// as a fan), and corners can omit UVs or normals (ex: "f 1//3 2//3 3//3" or "f 1 2 3")
+///
+/// Once Init has been called, large files are split into chunks at line boundaries that are
+/// parsed on the job system, and corners are de-duplicated in parallel
+/// </summary>
+class ObjParser {
+public:
+	ObjParser() = delete;
+
+	// Files smaller than this are parsed on the calling thread
+	static constexpr size_t MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+	// The number of corners in each job when de-duplicating in parallel
+	static constexpr uint32_t DEDUP_BATCH_SIZE = 64 * 1024;
+
+	/// <summary>
+	/// Gives the parser a job system to split large files across. Without it, all parsing
+	/// happens on the calling thread
+	/// </summary>
+	static void Init(JobSystem& jobs);
+
+	/// <summary>
+	/// The raw contents of an OBJ file, with all indices converted to be 0-based
+	/// </summary>
+	struct Data {
+		std::vector<glm::vec3>  Positions;
+		std::vector<glm::vec2>  UVs;
+		std::vector<glm::vec3>  Normals;
+		// The position, UV and normal index for each corner of each triangle, -1 where an attribute is missing
+		std::vector<glm::ivec3> Corners;
+	};
+
+	/// <summary>
+	/// Parses an entire OBJ file
+	/// </summary>
+	/// <param name="filename">The path to the file to parse</param>
+	/// <param name="result">The data to append the file's contents to</param>
+	/// <returns>True if the file could be opened, false if otherwise</returns>
+	static bool ParseFile(const std::string& filename, Data& result);
+	/// <summary>
+	/// Parses a block of OBJ text, appending it's contents to result
+	/// </summary>
+	static void Parse(const char* begin, const char* end, Data& result);
+
+	/// <summary>
+	/// Merges corners that use the same combination of attributes into a single vertex
+	/// </summary>
+	/// <param name="data">The parsed file</param>
+	/// <param name="vertices">Will store the attribute indices for each unique vertex</param>
+	/// <param name="indices">Will store the vertex index for each corner, 3 per triangle</param>
+	static void Deduplicate(const Data& data, std::vector<glm::ivec3>& vertices, std::vector<uint32_t>& indices);
+
+protected:
+	// Stored in place of an index that was left out of a corner
+	static constexpr int MISSING_INDEX = -0x7FFFFFFF - 1;
+
+	/// <summary>
+	/// A block of the file, parsed without knowing how many attributes came before it
+	/// </summary>
+	struct Chunk : Data {
+		// Components of Corners (corner * 3 + component) that were relative to the end of the chunk,
+		// and need the number of attributes in earlier chunks added to them
+		std::vector<uint32_t> Relative;
+	};
+
+	static JobSystem* _jobs;
+
+	static void _ParseChunk(const char* begin, const char* end, Chunk& chunk);
+	/// <summary>
+	/// Offsets the relative indices in a chunk, and validates every index against the total number
+	/// of attributes. Invalid UV and normal indices become -1, and triangles with invalid positions are dropped
+	/// </summary>
+	static void _ResolveChunk(Chunk& chunk, const glm::ivec3& base, const glm::ivec3& totals);
+	static void _ParseParallel(const char* begin, const char* end, Data& result);
+	static void _DeduplicateParallel(const Data& data, std::vector<glm::ivec3>& vertices, std::vector<uint32_t>& indices);
+};
@@ -1,6 +1,10 @@
 #include "Utils/OptimizedObjLoader.h"
 
 #include "ObjLoader.h"
+#include "Utils/ObjParser.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/MeshletBuilder.h"
 
 #include <string>
 #include <sstream>
@@ -12,12 +16,20 @@
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/packing.hpp>
+
 const char HEADER_BYTES[4] = { 'B', 'O', 'B', 'J' };
 const std::string binaryExtension = ".bin";
 
 namespace fs = std::filesystem;
 
-VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename) {
+VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename, MeshVertexFormat format) {
+	MeshData data;
+	return LoadMeshData(filename, data, format) ? CreateVao(data) : nullptr;
+}
+
+bool OptimizedObjLoader::LoadMeshData(const std::string& filename, MeshData& result, MeshVertexFormat format) {
 	// Get the file extension and lowercase it
 	fs::path filePath = std::filesystem::path(filename);
 	std::string extension = filePath.extension().string();
@@ -27,30 +39,89 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	if (extension == ".obj") {
 		// Get the binary path
 		fs::path binPath = filePath.replace_extension(binaryExtension);
-		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
-			ConvertToBinary(filename, binPath.string());
+		// Load the corresponding binary file if it's up to date, and was converted to the format we want
+		if (fs::exists(binPath) && _LoadFromBinFile(binPath.string(), result, false)) {
+			if (result.Format == format) {
+				return true;
+			}
+			LOG_INFO("\"{}\" was converted with the {} vertex format, but {} was requested", binPath.string(), ~result.Format, ~format);
+			// Let go of the mapped file so we can write over it
+			result = MeshData();
 		}
-		// Load the corresponding binary file
-		return _LoadFromBinFile(binPath.string());
+		// Otherwise (re)convert the OBJ file to a binary file
+		ConvertToBinary(filename, binPath.string(), format);
+		return _LoadFromBinFile(binPath.string(), result);
 	} 
 	// Load our fancy binary files
 	else if (extension == ".bin") {
-		return _LoadFromBinFile(filename);
+		return _LoadFromBinFile(filename, result);
 	}
 	// We've never met this extension in our life
 	else {
 		LOG_WARN("Cannot load model from \"{}\"", filename);
-		return nullptr;
+		return false;
+	}
+}
+
+VertexArrayObject::Sptr OptimizedObjLoader::CreateVao(const MeshData& data) {
+	// If we have index data, load it straight from the mapped file
+	IndexBuffer::Sptr indices = nullptr;
+	if (data.NumIndices > 0) {
+		indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+		indices->LoadData(data.Indices, GetIndexTypeSize(data.IndicesType), data.NumIndices, data.IndicesType);
+	}
+
+	// Create a new VBO and load our vertices into OpenGL, straight from the mapped file
+	VertexBuffer::Sptr vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->LoadData(data.Vertices, data.VertexStride, data.NumVertices);
+
+	// Create the VAO and attach our index and vertex buffers
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->SetIndexBuffer(indices);
+	result->AddVertexBuffer(vertices, data.VertexDeclaration);
+	result->SetBounds(data.LocalBounds);
+	result->SetLods(data.Lods);
+	result->SetMeshlets(data.Meshlets);
+
+	// Copy in the vertex declaration we loaded
+	result->SetVDecl(data.VertexDeclaration);
+
+	// Normalized integer positions are stored relative to the bounds of the mesh
+	for (const BufferAttribute& attrib : data.VertexDeclaration) {
+		if (attrib.Usage == AttribUsage::Position && attrib.Type != AttributeType::Float && attrib.Normalized) {
+			result->SetPositionTransform(
+				glm::translate(glm::mat4(1.0f), data.LocalBounds.Min) *
+				glm::scale(glm::mat4(1.0f), data.LocalBounds.Max - data.LocalBounds.Min)
+			);
+			break;
+		}
 	}
+
+	return result;
 }
 
-void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
+void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile, MeshVertexFormat format) {
 	// Load in the input file
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(inFile);
 
 	float startTime = static_cast<float>(glfwGetTime());
 
+	// Re-order the mesh for the vertex cache, overdraw and vertex fetch
+	MeshOptimizer::Report report = MeshOptimizer::Optimize(*mesh);
+	LOG_INFO("Optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", inFile, report.Before.ACMR, report.After.ACMR, report.Before.ATVR, report.After.ATVR);
+
+	// Append the simplified versions of the mesh to the index buffer
+	std::vector<MeshLod> lods = MeshSimplifier::GenerateLods(*mesh);
+	for (size_t ix = 1; ix < lods.size(); ix++) {
+		LOG_INFO("Generated LOD {} for \"{}\": {} triangles, error {:.4f}", ix, inFile, lods[ix].IndexCount / 3, lods[ix].Error);
+	}
+
+	// Split the full detail mesh into clusters, so large meshes can be culled piece by piece
+	std::vector<Meshlet> meshlets = MeshletBuilder::Build(*mesh, lods[0].IndexCount);
+	if (!meshlets.empty()) {
+		LOG_INFO("Split \"{}\" into {} meshlets", inFile, meshlets.size());
+	}
+
 	// If we didn't get an output path, just take the input and replace the extension
 	std::string outFileName = outFile;
 	if (outFileName.empty()) { 
@@ -63,155 +134,45 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 	}
 
 	// Save the mesh to the file
-	SaveBinaryFile(*mesh, outFileName);
+	if (format == MeshVertexFormat::Full) {
+		SaveBinaryFile(*mesh, outFileName, nullptr, &lods, &meshlets);
+	} else {
+		_SaveQuantized(*mesh, outFileName, format, lods, meshlets);
+	}
 
 	float endTime = static_cast<float>(glfwGetTime());
-	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount());
+	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices, {} format)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount(), ~format);
 
 	// We no longer need the mesh data, free it
 	delete mesh;
 }
 
 MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	float startTime = static_cast<float>(glfwGetTime());
 
-	// If our file fails to open, we will throw an error
-	if (!file) {
+	// Read in the attributes and faces, and merge corners that share attributes
+	ObjParser::Data data;
+	if (!ObjParser::ParseFile(filename, data)) {
 		throw std::runtime_error("Failed to open file");
 	}
-
-	// Could also take this in as a parameter
-	glm::vec4 color = glm::vec4(1.0f);
-
-	// Our attributes
-	std::vector<glm::vec3>  positions;
-	std::vector<glm::vec3>  normals;
-	std::vector<glm::vec2>  uvs;
 	std::vector<glm::ivec3> vertices;
 	std::vector<uint32_t>   indices;
+	ObjParser::Deduplicate(data, vertices, indices);
 
-	// Maps a key generated from obj indices to a vertex index that
-	// has been added to the mesh already
-	std::unordered_map<uint64_t, uint32_t> vertexMap;
+	// Could also take this in as a parameter
+	glm::vec4 color = glm::vec4(1.0f);
 
 	// We'll use the mesh builder since it supports easily adding
 	// vertices and indices
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = new MeshBuilder<VertexPosNormTexColTangents>();
 
-	// Storage for temporary data
-	std::string line;
-	glm::vec3 vecData;
-	glm::ivec3 vertexIndices;
-
-	float startTime = static_cast<float>(glfwGetTime());
-
-	// Read and process the entire file
-	while (file.peek() != EOF) {
-		// Read in the first part of the line (ex: f, v, vn, etc...)
-		std::string command;
-		file >> command;
-
-		// We will ignore the rest of the line for comment lines
-		if (command == "#") {
-			std::getline(file, line);
-		}
-
-		// The v command defines a vertex's position
-		else if (command == "v") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y >> vecData.z;
-			positions.push_back(vecData);
-		}
-		// TODO: handle normals and textures
-		else if (command == "vn") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y >> vecData.z;
-			normals.push_back(vecData);
-		} else if (command == "vt") {
-			// Read in and store a position
-			file >> vecData.x >> vecData.y;
-			uvs.push_back(vecData);
-		}
-
-		// The f command defines a polygon in the mesh
-		// NOTE: make sure you triangulate in blender, otherwise it will
-		// output quads instead of triangles
-		else if (command == "f") {
-			// Read the rest of the line from the file
-			std::getline(file, line);
-			// Trim whitespace from either end of the line
-			StringTools::Trim(line);
-			// Create a string stream so we can use streaming operators on it
-			std::stringstream stream = std::stringstream(line);
-
-			uint32_t edges[4];
-			int ix = 0;
-			// Iterate over up to 4 sets of attributes
-			for (; ix < 4; ix++) {
-				if (stream.peek() != EOF) {
-					// Load in the faces, split up by slashes
-					char tempChar;
-					vertexIndices = glm::ivec3(0);
-					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
-					// The OBJ format can have negative values, which are a reference from the last added attributes
-					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() + 1 + vertexIndices.x; }
-					if (vertexIndices.y < 0) { vertexIndices.y = uvs.size()       + 1 + vertexIndices.y; }
-					if (vertexIndices.z < 0) { vertexIndices.z = normals.size()   + 1 + vertexIndices.z; }
-
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = vertexMap.find(key);
-
-					// If it exists, we push the index to our indices
-					if (it != vertexMap.end()) {
-						edges[ix] = it->second;
-					} else {
-						vertices.push_back(vertexIndices - glm::ivec3(1));
-						uint32_t index = static_cast<uint32_t>(vertices.size()) - 1;
-
-						// Cache the index based on our key
-						vertexMap[key] = index;
-						// Add index to mesh, and add to edges list for if we are using quads
-						edges[ix] = index;
-					}
-				}
-				// We've reached the end of the line, break out of the loop
-				else { break; }
-			}
-
-			// Handling for triangle faces
-			if (ix == 3) {
-				indices.push_back(edges[0]);
-				indices.push_back(edges[1]);
-				indices.push_back(edges[2]);
-			}
-			// Handling for quad faces
-			else if (ix == 4) {
-				indices.push_back(edges[0]);
-				indices.push_back(edges[1]);
-				indices.push_back(edges[2]);
-
-				indices.push_back(edges[0]);
-				indices.push_back(edges[2]);
-				indices.push_back(edges[3]);
-			}
-		}
-	}
-
 	mesh->ReserveVertexSpace(vertices.size());
 	for (const auto& vertexIndices : vertices) {
-		// Construct a new vertex using the indices for the vertex
+		// Construct a new vertex using the indices for the vertex, missing attributes are -1
 		VertexPosNormTexColTangents vertex;
-		vertex.Position = positions[vertexIndices.x];
-		vertex.UV       = vertexIndices.y != 0 ? uvs[vertexIndices.y] : glm::vec2(0.0f);
-		vertex.Normal   = vertexIndices.z != 0 ? normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f);
+		vertex.Position = data.Positions[vertexIndices.x];
+		vertex.UV       = vertexIndices.y >= 0 ? data.UVs[vertexIndices.y] : glm::vec2(0.0f);
+		vertex.Normal   = vertexIndices.z >= 0 ? data.Normals[vertexIndices.z] : glm::vec3(0.0f, 0.0f, 1.0f);
 		vertex.Color    = color;
 
 		// Add to the mesh, get index of the added vertex
@@ -233,96 +194,238 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 	return mesh;
 }
 
-VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
+/// <summary>
+/// Packs all the attributes that are shared between the quantized formats
+/// </summary>
+template <typename QuantizedVertex>
+void PackAttributes(const VertexPosNormTexColTangents& vertex, QuantizedVertex& result) {
+	result.Normal    = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.0f));
+	result.UV        = glm::packHalf2x16(vertex.UV);
+	result.Color     = glm::packUnorm4x8(vertex.Color);
+	result.Tangent   = glm::packSnorm3x10_1x2(glm::vec4(vertex.Tangent, 0.0f));
+	result.BiTangent = glm::packSnorm3x10_1x2(glm::vec4(vertex.BiTangent, 0.0f));
+}
+
+void OptimizedObjLoader::_SaveQuantized(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, MeshVertexFormat format, const std::vector<MeshLod>& lods, const std::vector<Meshlet>& meshlets) {
+	// The bounds come from the full precision positions, and double as the dequantization transform for 16 bit positions
+	const Bounds bounds = mesh.GetBounds();
+	const VertexPosNormTexColTangents* vertices = mesh.GetVertexDataPtr();
+	const size_t vertexCount = mesh.GetVertexCount();
+
+	if (format == MeshVertexFormat::QuantizedPositions) {
+		const glm::vec3 extents = bounds.Max - bounds.Min;
+		const glm::vec3 invExtents = glm::vec3(
+			extents.x > 0.0f ? 1.0f / extents.x : 0.0f,
+			extents.y > 0.0f ? 1.0f / extents.y : 0.0f,
+			extents.z > 0.0f ? 1.0f / extents.z : 0.0f
+		);
+
+		MeshBuilder<VertexQuantizedPos16> result;
+		result.ReserveVertexSpace(vertexCount);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			VertexQuantizedPos16 vertex;
+			const glm::vec3 normalized = glm::clamp((vertices[ix].Position - bounds.Min) * invExtents, 0.0f, 1.0f);
+			vertex.Position = glm::u16vec4(glm::round(normalized * 65535.0f), 0);
+			PackAttributes(vertices[ix], vertex);
+			result.AddVertex(vertex);
+		}
+		result.ReserveIndexSpace(mesh.GetIndexCount());
+		for (size_t ix = 0; ix < mesh.GetIndexCount(); ix++) {
+			result.AddIndex(mesh.GetIndexDataPtr()[ix]);
+		}
+		SaveBinaryFile(result, outFilename, &bounds, &lods, &meshlets, format);
+	} else {
+		MeshBuilder<VertexQuantized> result;
+		result.ReserveVertexSpace(vertexCount);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			VertexQuantized vertex;
+			vertex.Position = vertices[ix].Position;
+			PackAttributes(vertices[ix], vertex);
+			result.AddVertex(vertex);
+		}
+		result.ReserveIndexSpace(mesh.GetIndexCount());
+		for (size_t ix = 0; ix < mesh.GetIndexCount(); ix++) {
+			result.AddIndex(mesh.GetIndexDataPtr()[ix]);
+		}
+		SaveBinaryFile(result, outFilename, &bounds, &lods, &meshlets, format);
+	}
+}
+
+/// <summary>
+/// Returns true if a block of data fits within a file, without overflowing
+/// </summary>
+inline bool BlockFits(uint64_t offset, uint64_t size, uint64_t fileSize) {
+	return offset <= fileSize && size <= fileSize - offset;
+}
 
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
+bool OptimizedObjLoader::_LoadFromBinFile(const std::string& filename, MeshData& result, bool allowOldVersions) {
+	// Map the file rather than reading it, the index and vertex blocks get handed to OpenGL directly
+	MemoryMappedFile::Sptr file = std::make_shared<MemoryMappedFile>(filename);
 	// If our file fails to open, we will throw an error
-	if (!file) { throw std::runtime_error("Failed to open file"); }
+	if (!file->IsOpen()) { throw std::runtime_error("Failed to open file"); }
 
 	float startTime = static_cast<float>(glfwGetTime());
 
-	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	const uint8_t* data = file->GetData();
+	const size_t size = file->GetSize();
 
-	// Read the header from the file
-	BinaryHeader header = BinaryHeader();
-	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
-	} else {
-		LOG_ERROR("Not enough data in the file!");
-		return nullptr;
+	// The magic and version are at the same spot for every version
+	uint16_t version = 0;
+	if (size < sizeof(HEADER_BYTES) + sizeof(uint16_t) || memcmp(data, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file!", filename);
+		return false;
 	}
+	memcpy(&version, data + sizeof(HEADER_BYTES), sizeof(uint16_t));
 
-	// TODO: validate header
-
-	// Handle our version
-	if (header.Version == 0x01) {
-		// Determine how many bytes we need in the file
-		size_t requiredBytes =
-			sizeof(BinaryHeader) +
-			(header.NumAttributes * sizeof(BufferAttribute)) +
-			(header.VertexStride * (size_t)header.NumVertices) +
-			(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-
-		// Make sure there's enough data in the file
-		if (size < requiredBytes) {
+	// Versions 2 to 5 have the same layout as the current version, but the mesh was not optimized, or has no LODs,
+	// meshlets or vertex format. Headers before version 5 stop before the meshlet table, so the rest of the fields are left as zeros
+	if (version == BINARY_VERSION || (version >= 0x02 && version < BINARY_VERSION && allowOldVersions)) {
+		const size_t headerSize = version >= 0x05 ? sizeof(BinaryHeaderV2) : BINARY_HEADER_V4_SIZE;
+		if (size < headerSize) {
 			LOG_ERROR("Not enough data in the file!");
-			return nullptr;
+			return false;
 		}
-
-		// Read all attributes from the file, this is basically our VDECL
-		std::vector<BufferAttribute> vertexDeclaration;
-		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
+		BinaryHeaderV2 header;
+		memcpy(&header, data, headerSize);
+
+		// Make sure every block is where the header says it is, and is entirely inside the file
+		const uint64_t indexBytes  = header.NumIndices * (uint64_t)GetIndexTypeSize(header.IndicesType);
+		const uint64_t vertexBytes = header.NumVertices * (uint64_t)header.VertexStride;
+		bool isValid =
+			header.HeaderSize == headerSize &&
+			header.FileSize == size &&
+			(header.NumIndices == 0 || GetIndexTypeSize(header.IndicesType) != 0) &&
+			header.IndicesOffset % BINARY_ALIGNMENT == 0 &&
+			header.VerticesOffset % BINARY_ALIGNMENT == 0 &&
+			BlockFits(header.AttributesOffset, header.NumAttributes * (uint64_t)sizeof(BufferAttribute), size) &&
+			(header.NumLods == 0 || BlockFits(header.LodsOffset, header.NumLods * (uint64_t)sizeof(BinaryLod), size)) &&
+			(header.NumMeshlets == 0 || BlockFits(header.MeshletsOffset, header.NumMeshlets * (uint64_t)sizeof(BinaryMeshlet), size)) &&
+			BlockFits(header.IndicesOffset, indexBytes, size) &&
+			BlockFits(header.VerticesOffset, vertexBytes, size);
+		if (!isValid) {
+			LOG_ERROR("The header of \"{}\" is invalid!", filename);
+			return false;
 		}
 
-		// These will have the buffer pointers
-		IndexBuffer::Sptr indices = nullptr;
-		VertexBuffer::Sptr vertices = nullptr;
-
-		// If we have index data, load it
-		if (header.NumIndices > 0) {
-			// Create index buffer
-			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
-
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+		// This touches every page of the file, so the upload won't stall on the disk afterwards
+		if (_Checksum(data + header.HeaderSize, size - header.HeaderSize) != header.Checksum) {
+			LOG_ERROR("Checksum did not match for \"{}\", the file is corrupt!", filename);
+			return false;
 		}
 
-		// Create a new VBO
-		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+		// Copy the VDECL out, everything else stays in the mapped file
+		result.VertexDeclaration.resize(header.NumAttributes);
+		memcpy(result.VertexDeclaration.data(), data + header.AttributesOffset, header.NumAttributes * sizeof(BufferAttribute));
+
+		result.File         = file;
+		result.Indices      = header.NumIndices > 0 ? data + header.IndicesOffset : nullptr;
+		result.IndicesType  = header.IndicesType;
+		result.NumIndices   = header.NumIndices;
+		result.Vertices     = data + header.VerticesOffset;
+		result.VertexStride = header.VertexStride;
+		result.NumVertices  = header.NumVertices;
+		result.LocalBounds  = header.NumVertices > 0 ? Bounds(header.BoundsMin, header.BoundsMax) : Bounds();
+		result.Format       = header.Format;
+
+		// Copy out the LOD table, dropping any levels that point outside of the index block
+		result.Lods.clear();
+		result.Lods.reserve(header.NumLods);
+		for (uint32_t ix = 0; ix < header.NumLods; ix++) {
+			BinaryLod lod;
+			memcpy(&lod, data + header.LodsOffset + ix * sizeof(BinaryLod), sizeof(BinaryLod));
+			if ((uint64_t)lod.FirstIndex + lod.NumIndices > header.NumIndices) {
+				LOG_WARN("LOD {} of \"{}\" is outside of the index buffer, ignoring it", ix, filename);
+				break;
+			}
+			result.Lods.push_back(MeshLod{ lod.FirstIndex, lod.NumIndices, lod.Error });
+		}
 
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
+		// Same for the meshlets, we drop all of them if any are bad since they need to cover the whole mesh
+		result.Meshlets.resize(header.NumMeshlets);
+		for (uint32_t ix = 0; ix < header.NumMeshlets; ix++) {
+			BinaryMeshlet meshlet;
+			memcpy(&meshlet, data + header.MeshletsOffset + ix * sizeof(BinaryMeshlet), sizeof(BinaryMeshlet));
+			if ((uint64_t)meshlet.FirstIndex + meshlet.NumIndices > header.NumIndices) {
+				LOG_WARN("Meshlet {} of \"{}\" is outside of the index buffer, ignoring the meshlets", ix, filename);
+				result.Meshlets.clear();
+				break;
+			}
+			result.Meshlets[ix] = Meshlet{ meshlet.FirstIndex, meshlet.NumIndices, meshlet.Center, meshlet.Radius, meshlet.ConeAxis, meshlet.ConeCutoff };
+		}
+	}
+	// Version 1 files are tightly packed, and need the bounds to be calculated
+	else if (version == 0x01 && allowOldVersions) {
+		// Read the header from the file
+		BinaryHeader header = BinaryHeader();
+		if (size < sizeof(BinaryHeader)) {
+			LOG_ERROR("Not enough data in the file!");
+			return false;
+		}
+		memcpy(&header, data, sizeof(BinaryHeader));
 
-		// Load data into OpenGL and free the CPU copy
-		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
+		// Determine where each block is, and make sure there's enough data in the file
+		const uint64_t attributesOffset = sizeof(BinaryHeader);
+		const uint64_t indicesOffset    = attributesOffset + header.NumAttributes * sizeof(BufferAttribute);
+		const uint64_t verticesOffset   = indicesOffset + header.NumIndices * (uint64_t)GetIndexTypeSize(header.IndicesType);
+		if (!BlockFits(verticesOffset, header.VertexStride * (uint64_t)header.NumVertices, size)) {
+			LOG_ERROR("Not enough data in the file!");
+			return false;
+		}
 
-		// Create the VAO and attach our index and vertex buffers
-		VertexArrayObject::Sptr result = VertexArrayObject::Create();
-		result->SetIndexBuffer(indices);
-		result->AddVertexBuffer(vertices, vertexDeclaration);
+		// Read all attributes from the file, this is basically our VDECL
+		result.VertexDeclaration.resize(header.NumAttributes);
+		memcpy(result.VertexDeclaration.data(), data + attributesOffset, header.NumAttributes * sizeof(BufferAttribute));
+
+		result.File         = file;
+		result.Indices      = header.NumIndices > 0 ? data + indicesOffset : nullptr;
+		result.IndicesType  = header.IndicesType;
+		result.NumIndices   = header.NumIndices;
+		result.Vertices     = data + verticesOffset;
+		result.VertexStride = header.VertexStride;
+		result.NumVertices  = header.NumVertices;
+
+		// Grab the bounds from the positions
+		for (const BufferAttribute& attrib : result.VertexDeclaration) {
+			if (attrib.Usage == AttribUsage::Position && attrib.Type == AttributeType::Float && attrib.Size == 3) {
+				result.LocalBounds = Bounds::FromPoints(result.Vertices, header.NumVertices, header.VertexStride, attrib.Offset);
+				break;
+			}
+		}
+	}
+	else {
+		if (allowOldVersions) {
+			LOG_ERROR("\"{}\" has unsupported version {}", filename, version);
+		}
+		return false;
+	}
 
-		// Copy in the vertex declaration we loaded
-		result->SetVDecl(vertexDeclaration);
+	// Calculate and trace out how long it took us to load
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, result.NumVertices, result.NumIndices);
 
-		// Calculate and trace out how long it took us to load
-		float endTime = static_cast<float>(glfwGetTime());
-		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, header.NumVertices, header.NumIndices);
+	return true;
+}
 
-		return result;
+uint64_t OptimizedObjLoader::_Checksum(const uint8_t* data, size_t size) {
+	// Four independent lanes, so the multiplies in each step can overlap
+	constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+	auto rotate = [](uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+
+	uint64_t lanes[4] = { PRIME_1 + PRIME_2, PRIME_2, 0, 0 - PRIME_1 };
+	size_t ix = 0;
+	for (; ix + 32 <= size; ix += 32) {
+		for (int lane = 0; lane < 4; lane++) {
+			uint64_t word;
+			memcpy(&word, data + ix + lane * sizeof(uint64_t), sizeof(uint64_t));
+			lanes[lane] = rotate(lanes[lane] + word * PRIME_2, 31) * PRIME_1;
+		}
 	}
+	uint64_t result = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
 
-	return nullptr;
+	// Mix in whatever is left over a byte at a time, then the size so that truncated files don't match
+	for (; ix < size; ix++) {
+		result = (result ^ data[ix]) * PRIME_1;
+	}
+	return (result ^ size) * PRIME_2;
 }
@@ -6,12 +6,31 @@
  * using similar concepts, and that fit better with your game
  */
 #pragma once
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <EnumToString.h>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/Bounds.h"
+#include "Utils/MemoryMappedFile.h"
+
+/// <summary>
+/// The vertex layouts that an OBJ file can be converted to
+/// </summary>
+ENUM(MeshVertexFormat, uint8_t,
+	// VertexPosNormTexColTangents, everything stored as floats
+	Full               = 0,
+	// VertexQuantized, float positions with packed normals, tangents, UVs and colors
+	Quantized          = 1,
+	// VertexQuantizedPos16, the same as Quantized but with 16 bit positions
+	QuantizedPositions = 2
+);
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -19,31 +38,86 @@
 /// </summary>
 class OptimizedObjLoader {
 public:
+	/// <summary>
+	/// The contents of a binary mesh file, mapped into memory but not uploaded to OpenGL yet
+	/// </summary>
+	struct MeshData {
+		// Keeps the file mapped for as long as the index and vertex pointers are in use
+		MemoryMappedFile::Sptr       File;
+		std::vector<BufferAttribute> VertexDeclaration;
+		// Points into the mapped file, null if the mesh is not indexed
+		const void*                  Indices     = nullptr;
+		IndexType                    IndicesType = IndexType::Unknown;
+		uint32_t                     NumIndices  = 0;
+		// Points into the mapped file
+		const void*                  Vertices     = nullptr;
+		uint16_t                     VertexStride = 0;
+		uint32_t                     NumVertices  = 0;
+		Bounds                       LocalBounds;
+		// The index ranges of each level of detail, empty if the file only has the full detail mesh
+		std::vector<MeshLod>         Lods;
+		// The clusters of the full detail mesh, empty if the mesh was too small to split up
+		std::vector<Meshlet>         Meshlets;
+		// The vertex format the file was converted with, always Full before version 6
+		MeshVertexFormat             Format = MeshVertexFormat::Full;
+	};
+
+	// The current version of the binary format, written by SaveBinaryFile. Version 3 has the same layout as
+	// version 2, but is bumped so that meshes converted before optimization was added get re-converted.
+	// Version 4 adds a table of LODs, stored in what used to be the reserved bytes of the header.
+	// Version 5 grows the header to add a table of meshlets.
+	// Version 6 stores the vertex format in the header, so a cached file can be checked against the requested format
+	static constexpr uint16_t BINARY_VERSION = 6;
+	// The alignment (in bytes) of each block of data in the binary format
+	static constexpr uint64_t BINARY_ALIGNMENT = 16;
+
 	/// <summary>
 	/// Loads a VAO from an OBJ file. On the first time this is called for an OBJ file, will convert the OBJ file 
 	/// to a binary file and load that instead. On subsequent runs, the binary file will be loaded instead
 	/// </summary>
 	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="format">The vertex format to use if the OBJ file needs to be converted</param>
 	/// <returns>A VAO loaded from disk</returns>
-	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, MeshVertexFormat format = MeshVertexFormat::Full);
+	/// <summary>
+	/// Does the same work as LoadFromFile (including converting OBJ files to binary), but stops before
+	/// creating any OpenGL objects, so this can be called from any thread
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="result">The mesh data to fill in</param>
+	/// <param name="format">The vertex format to use if the OBJ file needs to be converted</param>
+	/// <returns>True if the mesh was loaded, false if otherwise</returns>
+	static bool LoadMeshData(const std::string& filename, MeshData& result, MeshVertexFormat format = MeshVertexFormat::Full);
 	/// <summary>
-	/// Manually converts an OBJ file into a binary mesh file
+	/// Creates a VAO from mesh data loaded with LoadMeshData, must be called on the main thread
+	/// </summary>
+	static VertexArrayObject::Sptr CreateVao(const MeshData& data);
+	/// <summary>
+	/// Manually converts an OBJ file into a binary mesh file, optimizing the order of the
+	/// triangles and vertices along the way (see MeshOptimizer), and generating LODs (see MeshSimplifier)
+	/// and meshlets (see MeshletBuilder)
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
 	/// <param name="outFile">The output path for the bin file, or empty to use the inFile path and replace the extension with .bin</param>
-	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "");
+	/// <param name="format">The vertex layout to store in the file, the VDECL in the file will describe it</param>
+	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "", MeshVertexFormat format = MeshVertexFormat::Full);
 
 	/// <summary>
-	/// Saves a mesh builder of the given type to a binary file
+	/// Saves a mesh builder of the given type to a binary file. Indices are stored as 16 bit
+	/// if the mesh has few enough vertices
 	/// </summary>
 	/// <typeparam name="VertexType"></typeparam>
 	/// <param name="mesh"></param>
 	/// <param name="outFilename"></param>
+	/// <param name="bounds">The bounds to store in the header, or null to calculate them from the mesh's float positions</param>
+	/// <param name="lods">The index ranges of the mesh's levels of detail, or null if it only has one</param>
+	/// <param name="meshlets">The clusters of the full detail mesh, or null if it was not split up</param>
+	/// <param name="format">The format that VertexType was converted to, stored in the header</param>
 	template <typename VertexType>
-	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
+	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, const Bounds* bounds = nullptr, const std::vector<MeshLod>* lods = nullptr, const std::vector<Meshlet>* meshlets = nullptr, MeshVertexFormat format = MeshVertexFormat::Full);
 
 protected:
-	// Will be put at the start of the binary file, contains info about the contents of the file
+	// The header for version 1 files, which are still supported for loading
 	struct BinaryHeader {
 		// A check value so we can ensure that we're loading in the right file type
 		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
@@ -61,15 +135,103 @@ protected:
 		uint8_t   NumAttributes = 0;
 	};
 
+	// Will be put at the start of the binary file, contains info about the contents of the file. All the fields
+	// are explicitly sized and placed, and each block of data starts at an aligned offset, so the blocks can be
+	// used directly from a mapped file
+	struct alignas(16) BinaryHeaderV2 {
+		// A check value so we can ensure that we're loading in the right file type
+		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
+		// The version code, BINARY_VERSION when written. Always at the same place as in the version 1 header
+		uint16_t  Version = BINARY_VERSION;
+		// The size of this structure, as a sanity check
+		uint16_t  HeaderSize = 0;
+		// The number of indices in the mesh
+		uint32_t  NumIndices = 0;
+		// The type of index to load
+		IndexType IndicesType = IndexType::Unknown;
+		// The number of vertices in the mesh
+		uint32_t  NumVertices = 0;
+		// The size of a single vertex structure
+		uint16_t  VertexStride = 0;
+		// The number of vertex attributes (basically how many VDECL entries there are)
+		uint16_t  NumAttributes = 0;
+		// The offsets from the start of the file to each block of data
+		uint64_t  AttributesOffset = 0;
+		uint64_t  IndicesOffset = 0;
+		uint64_t  VerticesOffset = 0;
+		// The total size of the file, including padding
+		uint64_t  FileSize = 0;
+		// The checksum of everything after the header, see _Checksum
+		uint64_t  Checksum = 0;
+		// The model space bounds of the vertices, so we don't have to scan them when loading
+		glm::vec3 BoundsMin = glm::vec3(0.0f);
+		glm::vec3 BoundsMax = glm::vec3(0.0f);
+		// The number of entries in the LOD table, always 0 before version 4
+		uint32_t  NumLods = 0;
+		// The offset from the start of the file to the LOD table, which is BinaryLod[NumLods]
+		uint32_t  LodsOffset = 0;
+		// The number of entries in the meshlet table. Everything from here on was added in version 5
+		uint32_t  NumMeshlets = 0;
+		// The offset from the start of the file to the meshlet table, which is BinaryMeshlet[NumMeshlets]
+		uint32_t  MeshletsOffset = 0;
+		// The vertex format the mesh was converted to, added in version 6 (older files have a zero here, which is Full)
+		MeshVertexFormat Format = MeshVertexFormat::Full;
+		uint8_t   Reserved[7] = { 0 };
+	};
+	static_assert(sizeof(BinaryHeaderV2) == 112, "Binary header layout has changed, bump BINARY_VERSION");
+	// The size of the header in versions 2 to 4, which stopped before the meshlet table
+	static constexpr uint16_t BINARY_HEADER_V4_SIZE = 96;
+
+	// An entry in the LOD table, the indices for each level are stored one after another in the index block
+	struct BinaryLod {
+		uint32_t FirstIndex = 0;
+		uint32_t NumIndices = 0;
+		float    Error = 0.0f;
+		uint32_t Reserved = 0;
+	};
+	static_assert(sizeof(BinaryLod) == 16, "Binary LOD layout has changed, bump BINARY_VERSION");
+
+	// An entry in the meshlet table, see Meshlet
+	struct BinaryMeshlet {
+		uint32_t  FirstIndex = 0;
+		uint32_t  NumIndices = 0;
+		glm::vec3 Center = glm::vec3(0.0f);
+		float     Radius = 0.0f;
+		glm::vec3 ConeAxis = glm::vec3(0.0f);
+		float     ConeCutoff = 1.0f;
+	};
+	static_assert(sizeof(BinaryMeshlet) == 40, "Binary meshlet layout has changed, bump BINARY_VERSION");
+
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
-	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	/// <summary>
+	/// Packs a mesh into one of the quantized vertex formats and saves it to a binary file
+	/// </summary>
+	static void _SaveQuantized(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, MeshVertexFormat format, const std::vector<MeshLod>& lods, const std::vector<Meshlet>& meshlets);
+	/// <summary>
+	/// Maps a binary mesh file and validates it
+	/// </summary>
+	/// <param name="filename">The path to the .bin file</param>
+	/// <param name="result">The mesh data to fill in</param>
+	/// <param name="allowOldVersions">True to accept files older than BINARY_VERSION, false to report them as a failure</param>
+	static bool _LoadFromBinFile(const std::string& filename, MeshData& result, bool allowOldVersions = true);
+
+	/// <summary>
+	/// Rounds an offset up to the next multiple of BINARY_ALIGNMENT
+	/// </summary>
+	static uint64_t _AlignOffset(uint64_t offset) { 
+		return (offset + BINARY_ALIGNMENT - 1) & ~(BINARY_ALIGNMENT - 1); 
+	}
+	/// <summary>
+	/// Calculates a fast, non-cryptographic checksum of a block of memory, used to detect truncated or corrupt files
+	/// </summary>
+	static uint64_t _Checksum(const uint8_t* data, size_t size);
 };
 
 template <typename VertexType>
-void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename) {
+void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, const Bounds* bounds, const std::vector<MeshLod>* lods, const std::vector<Meshlet>* meshlets, MeshVertexFormat format) {
 	// Open the output file
 	std::ofstream file(outFilename, std::ios::binary);
 	if (!file) {
@@ -77,26 +239,62 @@ void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std
 	}
 
 	// Create the fixed size header for our output file
-	BinaryHeader header  = BinaryHeader();
-	header.Version       = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
-	header.NumIndices    = mesh.GetIndexCount();
-	header.IndicesType   = IndexType::UInt;
-	header.NumVertices   = mesh.GetVertexCount();
+	BinaryHeaderV2 header = BinaryHeaderV2();
+	header.HeaderSize    = sizeof(BinaryHeaderV2);
+	header.NumIndices    = static_cast<uint32_t>(mesh.GetIndexCount());
+	header.IndicesType   = mesh.GetVertexCount() <= std::numeric_limits<uint16_t>::max() ? IndexType::UShort : IndexType::UInt;
+	header.NumVertices   = static_cast<uint32_t>(mesh.GetVertexCount());
 	header.VertexStride  = sizeof(VertexType);
-	header.NumAttributes = VertexType::V_DECL.size();
+	header.NumAttributes = static_cast<uint16_t>(VertexType::V_DECL.size());
+	header.NumLods       = lods != nullptr ? static_cast<uint32_t>(lods->size()) : 0;
+	header.NumMeshlets   = meshlets != nullptr ? static_cast<uint32_t>(meshlets->size()) : 0;
+	header.Format        = format;
+
+	// Lay out the blocks of data after the header, each one starting on an aligned offset
+	header.AttributesOffset = sizeof(BinaryHeaderV2);
+	header.LodsOffset       = static_cast<uint32_t>(_AlignOffset(header.AttributesOffset + header.NumAttributes * sizeof(BufferAttribute)));
+	header.MeshletsOffset   = static_cast<uint32_t>(_AlignOffset(header.LodsOffset + header.NumLods * sizeof(BinaryLod)));
+	header.IndicesOffset    = _AlignOffset(header.MeshletsOffset + (uint64_t)header.NumMeshlets * sizeof(BinaryMeshlet));
+	header.VerticesOffset   = _AlignOffset(header.IndicesOffset + header.NumIndices * GetIndexTypeSize(header.IndicesType));
+	header.FileSize         = _AlignOffset(header.VerticesOffset + header.NumVertices * (uint64_t)sizeof(VertexType));
+
+	const Bounds meshBounds = bounds != nullptr ? *bounds : mesh.GetBounds();
+	header.BoundsMin = meshBounds.Min;
+	header.BoundsMax = meshBounds.Max;
 
-	// Write header bytes to the stream
-	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+	// Build everything after the header in memory, so we can checksum it before writing, padding is left as zeros
+	std::vector<uint8_t> body(header.FileSize - sizeof(BinaryHeaderV2), 0);
+	auto blockAt = [&](uint64_t offset) { return body.data() + (offset - sizeof(BinaryHeaderV2)); };
 
-	// Write which attributes we have to the stream
-	for (int ix = 0; ix < VertexType::V_DECL.size(); ix++) {
-		file.write(reinterpret_cast<const char*>(&VertexType::V_DECL[ix]), sizeof(BufferAttribute));
+	memcpy(blockAt(header.AttributesOffset), VertexType::V_DECL.data(), header.NumAttributes * sizeof(BufferAttribute));
+	BinaryLod* lodTable = reinterpret_cast<BinaryLod*>(blockAt(header.LodsOffset));
+	for (uint32_t ix = 0; ix < header.NumLods; ix++) {
+		lodTable[ix].FirstIndex = (*lods)[ix].FirstIndex;
+		lodTable[ix].NumIndices = (*lods)[ix].IndexCount;
+		lodTable[ix].Error      = (*lods)[ix].Error;
+	}
+	BinaryMeshlet* meshletTable = reinterpret_cast<BinaryMeshlet*>(blockAt(header.MeshletsOffset));
+	for (uint32_t ix = 0; ix < header.NumMeshlets; ix++) {
+		const Meshlet& meshlet = (*meshlets)[ix];
+		meshletTable[ix].FirstIndex = meshlet.FirstIndex;
+		meshletTable[ix].NumIndices = meshlet.IndexCount;
+		meshletTable[ix].Center     = meshlet.Center;
+		meshletTable[ix].Radius     = meshlet.Radius;
+		meshletTable[ix].ConeAxis   = meshlet.ConeAxis;
+		meshletTable[ix].ConeCutoff = meshlet.ConeCutoff;
+	}
+	if (header.IndicesType == IndexType::UShort) {
+		uint16_t* indices = reinterpret_cast<uint16_t*>(blockAt(header.IndicesOffset));
+		std::copy(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + header.NumIndices, indices);
+	} else if (header.NumIndices > 0) {
+		memcpy(blockAt(header.IndicesOffset), mesh.GetIndexDataPtr(), header.NumIndices * sizeof(uint32_t));
 	}
-	// Write any index data to the file
-	if (mesh.GetIndexCount() > 0) {
-		file.write(reinterpret_cast<const char*>(mesh.GetIndexDataPtr()), mesh.GetIndexCount() * sizeof(uint32_t));
+	if (header.NumVertices > 0) {
+		memcpy(blockAt(header.VerticesOffset), mesh.GetVertexDataPtr(), header.NumVertices * sizeof(VertexType));
 	}
+	header.Checksum = _Checksum(body.data(), body.size());
 
-	// Write vertex data to file
-	file.write(reinterpret_cast<const char*>(mesh.GetVertexDataPtr()), mesh.GetVertexCount() * sizeof(VertexType));
+	// Write the header, followed by the rest of the file
+	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeaderV2));
+	file.write(reinterpret_cast<const char*>(body.data()), body.size());
 }
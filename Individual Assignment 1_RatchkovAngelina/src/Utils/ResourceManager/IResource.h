@@ -12,6 +12,11 @@
 /// Resources must additionally define a static method as such:
 /// static std::shared_ptr<Type> FromJson(const nlohmann::json&);
 /// where Type is the Type of resource
+/// 
+/// Resources can also define a static method for loading in the background:
+/// static std::function<std::shared_ptr<Type>()> Decode(const nlohmann::json&);
+/// which does all the file reading and parsing without touching OpenGL (so it can run on
+/// a worker thread), and returns a function that the main thread invokes to finish the load
 /// </summary>
 class IResource {
 public:
@@ -55,4 +60,13 @@ protected:
 template <typename T>
 constexpr bool is_valid_resource() {
 	return std::is_base_of<IResource, T>::value && test_json<T, const nlohmann::json&>::value;
+}
+
+/// <summary>
+/// Returns true if the given resource type can be decoded off of the main thread
+/// </summary>
+/// <typeparam name="T">The type to check</typeparam>
+template <typename T>
+constexpr bool has_async_decode() {
+	return test_decode<T, const nlohmann::json&>::value;
 }
\ No newline at end of file
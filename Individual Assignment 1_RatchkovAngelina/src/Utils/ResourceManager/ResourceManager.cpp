@@ -1,5 +1,8 @@
 #include "Utils/ResourceManager/ResourceManager.h"
 
+#include <chrono>
+#include <Logging.h>
+
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
@@ -9,7 +12,15 @@ std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManage
 
 nlohmann::ordered_json ResourceManager::_manifest;
 
-void ResourceManager::Init() {
+JobSystem* ResourceManager::_jobs = nullptr;
+std::map<std::string, std::function<std::shared_ptr<ResourceManager::PendingLoad>(Guid)>> ResourceManager::_asyncLoaders;
+std::unordered_map<Guid, std::shared_ptr<ResourceManager::PendingLoad>> ResourceManager::_pendingLoads;
+std::mutex ResourceManager::_uploadMutex;
+std::deque<std::shared_ptr<ResourceManager::PendingLoad>> ResourceManager::_uploadQueue;
+
+void ResourceManager::Init(JobSystem& jobs) {
+	_jobs = &jobs;
+
 	// TODO: initialize the resource manager once it's a bit more complex
 	//_manifest["textures"]  = std::vector<nlohmann::json>();
 	//_manifest["meshes"]    = std::vector<nlohmann::json>();
@@ -27,17 +38,120 @@ void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets)
 	_manifest = blob;
 
 	if (preloadAssets) {
+		// Start every load up front, so that all the decoding can happen in parallel
+		std::vector<std::shared_ptr<PendingLoad>> loads;
 		for (auto& [typeName, items] : blob.items()) {
-			auto& func = _typeLoaders[typeName];
+			auto& func = _asyncLoaders[typeName];
 			if (func) {
-				for (auto& [guid, blob] : items.items()) {
-					func(blob);
+				for (auto& [guid, item] : items.items()) {
+					loads.push_back(func(Guid(guid)));
 				}
 			}
 		}
+
+		// Finish them in manifest order, so dependencies are uploaded before the resources that use them
+		for (const auto& load : loads) {
+			_FinishLoad(*load);
+		}
 	}
 }
 
+void ResourceManager::ProcessUploads(float budget) {
+	const auto start = std::chrono::steady_clock::now();
+	const std::chrono::duration<float> limit(budget);
+
+	do {
+		std::shared_ptr<PendingLoad> load;
+		{
+			std::lock_guard<std::mutex> lock(_uploadMutex);
+			if (_uploadQueue.empty()) {
+				break;
+			}
+			load = _uploadQueue.front();
+			_uploadQueue.pop_front();
+		}
+		_FinishLoad(*load);
+	} while (std::chrono::steady_clock::now() - start < limit);
+}
+
+std::shared_ptr<ResourceManager::PendingLoad> ResourceManager::_LoadAsync(std::type_index type, const std::string& typeName, Guid id, const DecodeFunc& decode) {
+	LOG_ASSERT(_jobs != nullptr, "ResourceManager::Init must be called before loading resources asynchronously!");
+
+	// If the resource is already on it's way, share the existing load
+	auto pending = _pendingLoads.find(id);
+	if (pending != _pendingLoads.end()) {
+		return pending->second;
+	}
+
+	std::shared_ptr<PendingLoad> load = std::make_shared<PendingLoad>(type, id);
+
+	// If the resource is already loaded we have nothing to do
+	auto& resources = _resources[type];
+	auto existing = resources.find(id);
+	if (existing != resources.end() && existing->second != nullptr) {
+		load->Result = existing->second;
+		load->IsDone = true;
+		return load;
+	}
+
+	// We need the manifest entry to know what to load
+	std::string key = id.str();
+	auto& loader = _typeLoaders[typeName];
+	if (!loader || !_manifest.contains(typeName) || !_manifest[typeName].contains(key)) {
+		LOG_WARN("Cannot load {} \"{}\", the type is not registered or the resource is not in the manifest", typeName, key);
+		load->IsDone = true;
+		return load;
+	}
+	nlohmann::json data = _manifest[typeName][key];
+	_pendingLoads[id] = load;
+
+	if (decode) {
+		// The workers do the decoding, then hand the load back to us for uploading
+		_jobs->Submit([load, decode, data]() {
+			try {
+				load->Upload = decode(data);
+			}
+			catch (const std::exception& e) {
+				LOG_ERROR("Failed to decode resource \"{}\": {}", load->Id.str(), e.what());
+			}
+			std::lock_guard<std::mutex> lock(_uploadMutex);
+			_uploadQueue.push_back(load);
+		}, &load->Decoded);
+	} else {
+		// Types that can't be decoded off the main thread are loaded in full during the upload
+		load->Upload = [type, loader, data]() {
+			return _resources[type][loader(data)];
+		};
+		std::lock_guard<std::mutex> lock(_uploadMutex);
+		_uploadQueue.push_back(load);
+	}
+
+	return load;
+}
+
+void ResourceManager::_FinishLoad(PendingLoad& load) {
+	if (load.IsDone) {
+		return;
+	}
+	// Mark the load as done first, so that resources that reference each other can't recurse forever
+	load.IsDone = true;
+
+	// Make sure the decode has finished, running other jobs while we wait
+	_jobs->Wait(load.Decoded);
+
+	if (load.Upload) {
+		load.Result = load.Upload();
+		load.Upload = nullptr;
+	}
+	if (load.Result != nullptr) {
+		load.Result->OverrideGUID(load.Id);
+		_resources[load.Type][load.Id] = load.Result;
+	}
+
+	// Callers hold their own reference to the load, so it's safe to release ours
+	_pendingLoads.erase(load.Id);
+}
+
 void ResourceManager::SaveManifest(const std::string& path) {
 	// Update all resources in the manifest so they match their current representation
 	for (auto& [type, map] : _resources) {
@@ -53,6 +167,16 @@ void ResourceManager::SaveManifest(const std::string& path) {
 }
 
 void ResourceManager::Cleanup() {
+	// Let any decodes that are still running finish before we drop their loads
+	for (auto& [id, load] : _pendingLoads) {
+		_jobs->Wait(load->Decoded);
+	}
+	_pendingLoads.clear();
+	{
+		std::lock_guard<std::mutex> lock(_uploadMutex);
+		_uploadQueue.clear();
+	}
+
 	for (auto& [type, map] : _resources) {
 		map.clear();
 	}
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <json.hpp>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <unordered_map>
 #include <typeindex>
 
 #include "Utils/GUID.hpp"
+#include "Utils/JobSystem.h"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/StringUtils.h"
 
+template <typename T>
+class AsyncResource;
+
 /// <summary>
 /// Utility class for managing and loading resources from JSON
 /// manifest files
@@ -18,7 +25,8 @@ public:
 	/// Initializes the resource manager and performs any first-time
 	/// setup required
 	/// </summary>
-	static void Init();
+	/// <param name="jobs">The job system to decode resources on when they are loaded asynchronously</param>
+	static void Init(JobSystem& jobs);
 
 	/// <summary>
 	/// Creates a new asset, and forwards the arguments to it's constructor
@@ -56,6 +64,16 @@ public:
 		// Try and grab the asset from the resource pool
 		std::shared_ptr<T> result =  std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
 
+		// If the asset is being loaded in the background, finish it now instead of loading it twice
+		if (result == nullptr) {
+			auto pending = _pendingLoads.find(id);
+			if (pending != _pendingLoads.end()) {
+				std::shared_ptr<PendingLoad> load = pending->second;
+				_FinishLoad(*load);
+				return std::dynamic_pointer_cast<T>(load->Result);
+			}
+		}
+
 		// If the asset is null, we can try finding it in the manifest to load it
 		if (result == nullptr) {
 			// Get the type name it'll be stored under
@@ -75,6 +93,30 @@ public:
 		return result;
 	}
 
+	/// <summary>
+	/// Starts loading the resource with the given type and GUID in the background. If the type
+	/// has a Decode method, reading and parsing happens on the job system's workers, and the
+	/// resulting OpenGL uploads are handed back to the main thread (see ProcessUploads)
+	/// 
+	/// Must be called from the main thread
+	/// </summary>
+	/// <typeparam name="T">The type of resource to load</typeparam>
+	/// <param name="id">The ID of the resource to load, must be in the manifest</param>
+	/// <returns>A handle that will hold the resource once it's loaded</returns>
+	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static AsyncResource<T> LoadAsync(Guid id) {
+		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		return AsyncResource<T>(_LoadAsync(std::type_index(typeid(T)), typeName, id, _GetDecoder<T>()));
+	}
+
+	/// <summary>
+	/// Finishes loads that have been decoded by the workers, until the time budget runs out. At least one
+	/// load is always finished, so progress is made even if a single upload takes longer than the budget.
+	/// Should be invoked by the main thread once per frame
+	/// </summary>
+	/// <param name="budget">The time to spend on uploads, in seconds</param>
+	static void ProcessUploads(float budget);
+
 	/// <summary>
 	/// Registers a resource type with the resource manager, only types that have been registered
 	/// can be loaded from JSON manifest files!
@@ -94,6 +136,10 @@ public:
 			return res->GetGUID();
 		};
 
+		_asyncLoaders[typeName] = [typeName](Guid id) {
+			return _LoadAsync(std::type_index(typeid(T)), typeName, id, _GetDecoder<T>());
+		};
+
 		// Make sure we haven't registered the type yet, then add an empty object
 		// to the manifest to ensure it can be saved
 		if (!_manifest.contains(typeName)) {
@@ -148,6 +194,37 @@ public:
 	static void Cleanup();
 
 protected:
+	template <typename T>
+	friend class AsyncResource;
+
+	// Finishes loading a resource on the main thread, returning the resource
+	typedef std::function<IResource::Sptr()> UploadFunc;
+	// Does the CPU side of loading a resource from it's JSON blob, on any thread
+	typedef std::function<UploadFunc(const nlohmann::json&)> DecodeFunc;
+
+	/// <summary>
+	/// The state of a resource that was requested with LoadAsync
+	/// </summary>
+	struct PendingLoad {
+		NO_COPY(PendingLoad);
+		NO_MOVE(PendingLoad);
+
+		PendingLoad(std::type_index type, Guid id) :
+			Type(type), Id(id), Decoded(), Upload(nullptr), Result(nullptr), IsDone(false) { }
+
+		std::type_index Type;
+		Guid            Id;
+		// Tracks the decode job, if the type has one
+		JobCounter      Decoded;
+		// Filled in once the CPU work is done, invoked on the main thread to create the resource
+		UploadFunc      Upload;
+		IResource::Sptr Result;
+		// Only accessed by the main thread
+		bool            IsDone;
+	};
+
+	static JobSystem* _jobs;
+
 	/// <summary>
 	/// This is a map of maps
 	/// The top level map uses type_index, so there's a map per resource type
@@ -164,4 +241,72 @@ protected:
 	/// This allows us to register dependencies before the dependent resource
 	/// </summary>
 	static nlohmann::ordered_json _manifest;
+
+	/// <summary>
+	/// Starts async loads for registered types by name, used when preloading manifests
+	/// </summary>
+	static std::map<std::string, std::function<std::shared_ptr<PendingLoad>(Guid)>> _asyncLoaders;
+	/// <summary>
+	/// Loads that have been started but not finished, so that requesting the same resource again
+	/// will share the load
+	/// </summary>
+	static std::unordered_map<Guid, std::shared_ptr<PendingLoad>> _pendingLoads;
+	/// <summary>
+	/// Loads that are ready for the main thread, filled in by the workers as they finish decoding
+	/// </summary>
+	static std::mutex                               _uploadMutex;
+	static std::deque<std::shared_ptr<PendingLoad>> _uploadQueue;
+
+	static std::shared_ptr<PendingLoad> _LoadAsync(std::type_index type, const std::string& typeName, Guid id, const DecodeFunc& decode);
+	/// <summary>
+	/// Finishes a load right away if it's not done already, waiting on the decode if it's still running
+	/// </summary>
+	static void _FinishLoad(PendingLoad& load);
+
+	template <typename T>
+	static DecodeFunc _GetDecoder() {
+		if constexpr (has_async_decode<T>()) {
+			return [](const nlohmann::json& data) -> UploadFunc { return T::Decode(data); };
+		} else {
+			return nullptr;
+		}
+	}
+};
+
+/// <summary>
+/// A handle to a resource being loaded by ResourceManager::LoadAsync. Handles should only be used
+/// from the main thread
+/// </summary>
+/// <typeparam name="T">The type of resource being loaded</typeparam>
+template <typename T>
+class AsyncResource {
+public:
+	AsyncResource() : _state(nullptr) { }
+
+	/// <summary>
+	/// Returns true once the resource has finished loading, or has failed to load
+	/// </summary>
+	bool IsReady() const { return _state != nullptr && _state->IsDone; }
+	/// <summary>
+	/// Gets the resource, or nullptr if it has not finished loading or failed to load
+	/// </summary>
+	std::shared_ptr<T> Get() const { 
+		return IsReady() ? std::dynamic_pointer_cast<T>(_state->Result) : nullptr; 
+	}
+	/// <summary>
+	/// Finishes loading the resource right away, helping out with the decode if it's still running
+	/// </summary>
+	std::shared_ptr<T> Wait() const {
+		if (_state == nullptr) {
+			return nullptr;
+		}
+		ResourceManager::_FinishLoad(*_state);
+		return Get();
+	}
+
+private:
+	friend class ResourceManager;
+	std::shared_ptr<ResourceManager::PendingLoad> _state;
+
+	AsyncResource(const std::shared_ptr<ResourceManager::PendingLoad>& state) : _state(state) { }
 };
\ No newline at end of file